@@ -11,6 +11,7 @@
 #include "Vorbis.h"
 #include "Chat.h"
 #include "Stream.h"
+#include "Entity.h"
 
 int Audio_SoundsVolume, Audio_MusicVolume;
 static StringsBuffer files;
@@ -35,12 +36,6 @@ static void Volume_Mix16(int16_t* samples, int count, int volume) {
 	}
 }
 
-static void Volume_Mix8(uint8_t* samples, int count, int volume) {
-	int i;
-	for (i = 0; i < count; i++, samples++) {
-		samples[0] = (127 + (samples[0] - 127) * volume / 100);
-	}
-}
 
 /*########################################################################################################################*
 *------------------------------------------------------Soundboard---------------------------------------------------------*
@@ -48,6 +43,7 @@ static void Volume_Mix8(uint8_t* samples, int count, int volume) {
 struct Sound {
 	struct AudioFormat Format;
 	uint8_t* Data; uint32_t DataSize;
+	uint32_t Frames; /* number of samples per channel */
 };
 
 #define AUDIO_MAX_SOUNDS 10
@@ -101,6 +97,25 @@ static ReturnCode Sound_ReadWaveData(struct Stream* stream, struct Sound* snd) {
 	}
 }
 
+/* Converts 8 bit sound data to 16 bit, so the mixer only has to handle one sample format */
+static void Sound_Convert16(struct Sound* snd) {
+	int16_t* data;
+	uint32_t i;
+
+	if (snd->Format.BitsPerSample == 8) {
+		data = Mem_Alloc(snd->DataSize, 2, "WAV 16 bit data");
+		for (i = 0; i < snd->DataSize; i++) {
+			data[i] = (snd->Data[i] - 128) << 8;
+		}
+
+		Mem_Free(snd->Data);
+		snd->Data     = (uint8_t*)data;
+		snd->DataSize = snd->DataSize * 2;
+		snd->Format.BitsPerSample = 16;
+	}
+	snd->Frames = snd->DataSize / (2 * snd->Format.Channels);
+}
+
 static ReturnCode Sound_ReadWave(const String* filename, struct Sound* snd) {
 	String path; char pathBuffer[FILENAME_SIZE];
 	struct Stream stream;
@@ -114,8 +129,207 @@ static ReturnCode Sound_ReadWave(const String* filename, struct Sound* snd) {
 
 	res = Sound_ReadWaveData(&stream, snd);
 	if (res) { stream.Close(&stream); return res; }
+	if ((res = stream.Close(&stream))) return res;
+
+	/* mixer only supports mono or stereo, 8 or 16 bit data */
+	if (snd->Format.Channels < 1 || snd->Format.Channels > 2) return WAV_ERR_DATA_TYPE;
+	if (snd->Format.BitsPerSample != 8 && snd->Format.BitsPerSample != 16) return WAV_ERR_DATA_TYPE;
+	if (!snd->DataSize) return WAV_ERR_NO_DATA;
+
+	Sound_Convert16(snd);
+	return 0;
+}
+
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Sound bank--------------------------------------------------------*
+*#########################################################################################################################*/
+/* All sounds are also stored decoded in one packed file, so that on later runs they can be */
+/* loaded with a single file read, instead of opening and parsing dozens of small .wav files. */
+/* Layout: header, then index of entries, then 16 bit sample data of each sound */
+#define SOUNDBANK_VERSION 1
+#define SOUNDBANK_HEADER_SIZE 16
+#define SOUNDBANK_ENTRY_SIZE 64
+#define SOUNDBANK_NAME_SIZE 32
+#define SOUNDBANK_MAX_ENTRIES (2 * AUDIO_MAX_SOUNDS * AUDIO_MAX_SOUNDS)
+#define SOUNDBANK_ALIGNMENT 16 /* sample data of each sound starts on this boundary */
+
+struct SoundBankEntry { String Name; TimeMS Modified; struct Sound* Snd; };
+static uint8_t* soundBank_data;
+static uint32_t soundBank_size, soundBank_count, soundBank_used;
+/* Set when a sound was not in the bank, or was changed since the bank was saved */
+static bool soundBank_stale;
+
+/* Sounds loaded this session, so the bank can be rebuilt if needed */
+static struct SoundBankEntry soundBank_entries[SOUNDBANK_MAX_ENTRIES];
+static int soundBank_entriesCount;
+
+static void SoundBank_Open(void) {
+	const static String path = String_FromConst("audio/soundbank.bin");
+	struct Stream stream;
+	uint32_t length;
+	ReturnCode res;
+
+	soundBank_stale = true;
+	if (!File_Exists(&path)) return;
+	if ((res = Stream_OpenFile(&stream, &path))) { Logger_Warn(res, "opening sound bank"); return; }
+
+	res = stream.Length(&stream, &length);
+	if (!res && length >= SOUNDBANK_HEADER_SIZE) {
+		soundBank_data = Mem_Alloc(length, 1, "sound bank");
+		soundBank_size = length;
+		res = Stream_Read(&stream, soundBank_data, length);
+	}
+	if (res) Logger_Warn(res, "reading sound bank");
+	stream.Close(&stream);
+
+	if (res || !soundBank_data) goto invalid;
+	if (Stream_GetU32_BE(&soundBank_data[0]) != WAV_FourCC('C','C','S','B')) goto invalid;
+	if (Stream_GetU32_LE(&soundBank_data[4]) != SOUNDBANK_VERSION)           goto invalid;
+	if (Stream_GetU32_LE(&soundBank_data[12]) != length)                      goto invalid;
+
+	soundBank_count = Stream_GetU32_LE(&soundBank_data[8]);
+	if (soundBank_count > SOUNDBANK_MAX_ENTRIES) goto invalid;
+	if (SOUNDBANK_HEADER_SIZE + soundBank_count * SOUNDBANK_ENTRY_SIZE > length) goto invalid;
+
+	soundBank_stale = false;
+	return;
+
+invalid:
+	Mem_Free(soundBank_data);
+	soundBank_data  = NULL;
+	soundBank_count = 0;
+}
+
+/* Looks for an up to date entry for the given sound file in the bank */
+static bool SoundBank_Get(const String* file, TimeMS modified, struct Sound* snd) {
+	uint8_t* entry;
+	uint32_t i, offset, size;
+	String name;
+
+	for (i = 0; i < soundBank_count; i++) {
+		entry = &soundBank_data[SOUNDBANK_HEADER_SIZE + i * SOUNDBANK_ENTRY_SIZE];
+		name  = String_Init((char*)entry, String_CalcLen((char*)entry, SOUNDBANK_NAME_SIZE), 0);
+		if (!String_Equals(&name, file)) continue;
+
+		if (Stream_GetU32_LE(&entry[32]) != (uint32_t)modified)         return false;
+		if (Stream_GetU32_LE(&entry[36]) != (uint32_t)(modified >> 32)) return false;
+
+		offset = Stream_GetU32_LE(&entry[48]);
+		size   = Stream_GetU32_LE(&entry[52]);
+		if (offset > soundBank_size || size > soundBank_size - offset) return false;
+
+		snd->Format.SampleRate    = Stream_GetU32_LE(&entry[40]);
+		snd->Format.Channels      = Stream_GetU16_LE(&entry[44]);
+		snd->Format.BitsPerSample = Stream_GetU16_LE(&entry[46]);
+		if (snd->Format.Channels < 1 || snd->Format.Channels > 2) return false;
+		if (snd->Format.BitsPerSample != 16 || !size)             return false;
+
+		/* sample data is used directly from the bank, without copying */
+		snd->Data     = &soundBank_data[offset];
+		snd->DataSize = size;
+		snd->Frames   = size / (2 * snd->Format.Channels);
+		return true;
+	}
+	return false;
+}
+
+/* Loads a sound from the bank if it is up to date in there, otherwise from its .wav file */
+static ReturnCode SoundBank_Load(const String* file, struct Sound* snd) {
+	String path; char pathBuffer[FILENAME_SIZE];
+	struct SoundBankEntry* e;
+	TimeMS modified = 0;
+	ReturnCode res;
+
+	String_InitArray(path, pathBuffer);
+	String_Format1(&path, "audio/%s", file);
+	File_GetModifiedTime(&path, &modified);
+
+	/* name doesn't fit in an entry, so the sound can never be in the bank */
+	if (file->length >= SOUNDBANK_NAME_SIZE) return Sound_ReadWave(file, snd);
+
+	if (SoundBank_Get(file, modified, snd)) {
+		soundBank_used++;
+	} else {
+		soundBank_stale = true;
+		if ((res = Sound_ReadWave(file, snd))) return res;
+	}
+
+	if (soundBank_entriesCount == SOUNDBANK_MAX_ENTRIES) return 0;
+	e = &soundBank_entries[soundBank_entriesCount++];
+	e->Name = *file; e->Modified = modified; e->Snd = snd;
+	return 0;
+}
+
+static ReturnCode SoundBank_Write(struct Stream* s) {
+	uint8_t data[SOUNDBANK_ENTRY_SIZE] = { 0 };
+	struct SoundBankEntry* e;
+	uint32_t offset, padding;
+	int i;
+	ReturnCode res;
+
+	offset = SOUNDBANK_HEADER_SIZE + soundBank_entriesCount * SOUNDBANK_ENTRY_SIZE;
+	/* data of each sound is padded to alignment, so work out total size first */
+	for (i = 0; i < soundBank_entriesCount; i++) {
+		offset  = (offset + SOUNDBANK_ALIGNMENT - 1) & ~(SOUNDBANK_ALIGNMENT - 1);
+		offset += soundBank_entries[i].Snd->DataSize;
+	}
+
+	Stream_SetU32_BE(&data[0],  WAV_FourCC('C','C','S','B'));
+	Stream_SetU32_LE(&data[4],  SOUNDBANK_VERSION);
+	Stream_SetU32_LE(&data[8],  soundBank_entriesCount);
+	Stream_SetU32_LE(&data[12], offset);
+	if ((res = Stream_Write(s, data, SOUNDBANK_HEADER_SIZE))) return res;
+
+	offset = SOUNDBANK_HEADER_SIZE + soundBank_entriesCount * SOUNDBANK_ENTRY_SIZE;
+	for (i = 0; i < soundBank_entriesCount; i++) {
+		e = &soundBank_entries[i];
+		offset = (offset + SOUNDBANK_ALIGNMENT - 1) & ~(SOUNDBANK_ALIGNMENT - 1);
+
+		Mem_Set(data, 0, sizeof(data));
+		Mem_Copy(data, e->Name.buffer, e->Name.length);
+		Stream_SetU32_LE(&data[32], (uint32_t)e->Modified);
+		Stream_SetU32_LE(&data[36], (uint32_t)(e->Modified >> 32));
+		Stream_SetU32_LE(&data[40], e->Snd->Format.SampleRate);
+		Stream_SetU16_LE(&data[44], e->Snd->Format.Channels);
+		Stream_SetU16_LE(&data[46], e->Snd->Format.BitsPerSample);
+		Stream_SetU32_LE(&data[48], offset);
+		Stream_SetU32_LE(&data[52], e->Snd->DataSize);
+
+		if ((res = Stream_Write(s, data, SOUNDBANK_ENTRY_SIZE))) return res;
+		offset += e->Snd->DataSize;
+	}
+
+	offset = SOUNDBANK_HEADER_SIZE + soundBank_entriesCount * SOUNDBANK_ENTRY_SIZE;
+	Mem_Set(data, 0, sizeof(data));
+	for (i = 0; i < soundBank_entriesCount; i++) {
+		e = &soundBank_entries[i];
+		padding = ((offset + SOUNDBANK_ALIGNMENT - 1) & ~(SOUNDBANK_ALIGNMENT - 1)) - offset;
+
+		if ((res = Stream_Write(s, data, padding)))                     return res;
+		if ((res = Stream_Write(s, e->Snd->Data, e->Snd->DataSize))) return res;
+		offset += padding + e->Snd->DataSize;
+	}
+	return 0;
+}
+
+/* Rebuilds the bank, if any sounds changed or were added/removed since it was saved */
+static void SoundBank_Close(void) {
+	const static String path = String_FromConst("audio/soundbank.bin");
+	struct Stream stream;
+	ReturnCode res;
 
-	return stream.Close(&stream);
+	if (!soundBank_stale && soundBank_used == soundBank_count) return;
+	if (!soundBank_entriesCount) return;
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Logger_Warn(res, "creating sound bank"); return; }
+
+	res = SoundBank_Write(&stream);
+	if (res) Logger_Warn(res, "writing sound bank");
+	res = stream.Close(&stream);
+	if (res) Logger_Warn(res, "closing sound bank");
 }
 
 static struct SoundGroup* Soundboard_Find(struct Soundboard* board, const String* name) {
@@ -134,6 +348,7 @@ static void Soundboard_Init(struct Soundboard* board, const String* boardName, S
 	struct Sound* snd;
 	ReturnCode res;
 	int i, dotIndex;
+	bool warnedGroups = false, warnedSounds = false;
 
 	for (i = 0; i < files->Count; i++) {
 		file = StringsBuffer_UNSAFE_Get(files, i); 
@@ -150,8 +365,10 @@ static void Soundboard_Init(struct Soundboard* board, const String* boardName, S
 
 		group = Soundboard_Find(board, &name);
 		if (!group) {
+			/* skip just this sound, so the rest of the board (and sound bank) is still complete */
 			if (board->Count == Array_Elems(board->Groups)) {
-				Chat_AddRaw("&cCannot have more than 10 sound groups"); return;
+				if (!warnedGroups) Chat_AddRaw("&cCannot have more than 10 sound groups");
+				warnedGroups = true; continue;
 			}
 
 			group = &board->Groups[board->Count++];
@@ -160,11 +377,12 @@ static void Soundboard_Init(struct Soundboard* board, const String* boardName, S
 		}
 
 		if (group->Count == Array_Elems(group->Sounds)) {
-			Chat_AddRaw("&cCannot have more than 10 sounds in a group"); return;
+			if (!warnedSounds) Chat_AddRaw("&cCannot have more than 10 sounds in a group");
+			warnedSounds = true; continue;
 		}
 
 		snd = &group->Sounds[group->Count];
-		res = Sound_ReadWave(&file, snd);
+		res = SoundBank_Load(&file, snd);
 
 		if (res) {
 			Logger_Warn2(res, "decoding", &file);
@@ -193,144 +411,338 @@ struct Sound* Soundboard_PickRandom(struct Soundboard* board, uint8_t type) {
 
 
 /*########################################################################################################################*
-*--------------------------------------------------------Sounds-----------------------------------------------------------*
+*--------------------------------------------------------Mixer------------------------------------------------------------*
 *#########################################################################################################################*/
-struct SoundOutput { AudioHandle Handle; void* Buffer; uint32_t BufferSize; };
-#define AUDIO_MAX_HANDLES 6
-#define AUDIO_DEF_ELEMS 0
-#define HANDLE_INV -1
-#define SOUND_INV { HANDLE_INV, NULL, 0 }
-
-static struct Soundboard digBoard, stepBoard;
-static struct SoundOutput monoOutputs[AUDIO_MAX_HANDLES]   = { SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV };
-static struct SoundOutput stereoOutputs[AUDIO_MAX_HANDLES] = { SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV, SOUND_INV };
+/* All sounds are mixed together on a separate thread into one stereo output stream. */
+/* This avoids needing a platform audio handle for every sound that plays at the same time. */
+#define MIXER_SAMPLE_RATE 44100
+#define MIXER_MAX_VOICES 64
+#define MIXER_CHUNK_FRAMES 512 /* ~12 ms per buffer */
+#define MIXER_CHUNK_SAMPLES (MIXER_CHUNK_FRAMES * 2)
+#define MIXER_QUEUE_SIZE 64 /* must be a power of two */
+#define MIXER_POLL_INTERVAL 2
+
+struct MixerVoice {
+	struct Sound* Snd;
+	uint32_t Pos, Frac, Step; /* position in source frames, Frac and Step are 16.16 fixed point */
+	int VolL, VolR;           /* gain of left and right output channels, 256 is unchanged */
+};
 
-CC_NOINLINE static void Sounds_Fail(ReturnCode res) {
-	Logger_Warn(res, "playing sounds");
-	Chat_AddRaw("&cDisabling sounds");
-	Audio_SetSounds(0);
+/* Queue of sounds to start playing. Main thread pushes, mixer thread pops. */
+/* NOTE: Head is only written by the main thread, and tail by the mixer thread, so no lock is needed. */
+static struct MixerVoice mixer_queue[MIXER_QUEUE_SIZE];
+static volatile uint32_t mixer_queueHead, mixer_queueTail;
+
+/* Writes to a voice in the queue must be visible before the new head, and reads of it before the new tail */
+#if _MSC_VER
+#include <intrin.h>
+/* Interlocked functions are full memory barriers */
+#define Mixer_LoadIndex(ptr)       ((uint32_t)_InterlockedOr((volatile long*)(ptr), 0))
+#define Mixer_StoreIndex(ptr, val) _InterlockedExchange((volatile long*)(ptr), (long)(val))
+#else
+#define Mixer_LoadIndex(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define Mixer_StoreIndex(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#endif
+
+/* Only ever accessed by the mixer thread */
+static struct MixerVoice mixer_voices[MIXER_MAX_VOICES];
+static int mixer_voicesCount;
+static int32_t mixer_accum[MIXER_CHUNK_SAMPLES];
+static int16_t mixer_buffers[MIXER_CHUNK_SAMPLES * AUDIO_MAX_BUFFERS];
+
+static AudioHandle mixer_out;
+static void* mixer_thread;
+static void* mixer_waitable;
+static volatile bool mixer_pendingStop, mixer_joining;
+
+/* Queues a sound to be started by the mixer thread. Sound is dropped if the queue is full. */
+static void Mixer_Push(struct Sound* snd, uint32_t step, int volL, int volR) {
+	uint32_t head = mixer_queueHead;
+	struct MixerVoice* v;
+	if (head - Mixer_LoadIndex(&mixer_queueTail) >= MIXER_QUEUE_SIZE) return;
+
+	v = &mixer_queue[head & (MIXER_QUEUE_SIZE - 1)];
+	v->Snd  = snd;  v->Step = step;
+	v->VolL = volL; v->VolR = volR;
+	v->Pos  = 0;    v->Frac = 0;
+
+	Mixer_StoreIndex(&mixer_queueHead, head + 1);
+	Waitable_Signal(mixer_waitable);
 }
 
-static void Sounds_PlayRaw(struct SoundOutput* output, struct Sound* snd, struct AudioFormat* fmt, int volume) {
-	uint32_t expandBy;
-	void* data = snd->Data;
-	ReturnCode res;
+static void Mixer_ProcessQueue(void) {
+	uint32_t tail = mixer_queueTail, head = Mixer_LoadIndex(&mixer_queueHead);
+	struct MixerVoice* src;
 
-	if ((res = Audio_SetFormat(output->Handle, fmt))) { Sounds_Fail(res); return; }
-	
-	/* copy to temp buffer to apply volume */
-	if (volume < 100) {		
-		if (output->BufferSize < snd->DataSize) {
-			expandBy       = snd->DataSize - output->BufferSize;
-			output->Buffer = Utils_Resize(output->Buffer, &output->BufferSize, 
-											1, AUDIO_DEF_ELEMS, expandBy);
-		}
-		data = output->Buffer;
+	for (; tail != head; tail++) {
+		src = &mixer_queue[tail & (MIXER_QUEUE_SIZE - 1)];
+		/* too many sounds already playing, so just skip this one */
+		if (mixer_voicesCount == MIXER_MAX_VOICES) continue;
+		mixer_voices[mixer_voicesCount++] = *src;
+	}
+	Mixer_StoreIndex(&mixer_queueTail, tail);
+}
 
-		Mem_Copy(data, snd->Data, snd->DataSize);
-		if (fmt->BitsPerSample == 8) {
-			Volume_Mix8(data,  snd->DataSize,     volume);
-		} else {
-			Volume_Mix16(data, snd->DataSize / 2, volume);
+/* Adds the voice's next samples to the accumulation buffer, returning false once it has finished */
+static bool Mixer_MixVoice(struct MixerVoice* v, int32_t* accum) {
+	int16_t* src  = (int16_t*)v->Snd->Data;
+	uint32_t last = v->Snd->Frames - 1;
+	uint32_t pos  = v->Pos, frac = v->Frac, next;
+	int volL = v->VolL, volR = v->VolR;
+	int i, a, b, l, r;
+
+	/* linearly interpolate between samples to resample to the mixer's sample rate */
+	/* (frac is halved so that the difference times it can't overflow) */
+	if (v->Snd->Format.Channels == 1) {
+		for (i = 0; i < MIXER_CHUNK_FRAMES && pos <= last; i++, accum += 2) {
+			next = pos < last ? pos + 1 : last;
+			a = src[pos]; b = src[next];
+			l = a + (((b - a) * (int)(frac >> 1)) >> 15);
+
+			accum[0] += l * volL;
+			accum[1] += l * volR;
+
+			frac += v->Step;
+			pos  += frac >> 16; frac &= 0xFFFF;
+		}
+	} else {
+		for (i = 0; i < MIXER_CHUNK_FRAMES && pos <= last; i++, accum += 2) {
+			next = pos < last ? pos + 1 : last;
+			a = src[pos * 2];     b = src[next * 2];
+			l = a + (((b - a) * (int)(frac >> 1)) >> 15);
+			a = src[pos * 2 + 1]; b = src[next * 2 + 1];
+			r = a + (((b - a) * (int)(frac >> 1)) >> 15);
+
+			accum[0] += l * volL;
+			accum[1] += r * volR;
+
+			frac += v->Step;
+			pos  += frac >> 16; frac &= 0xFFFF;
 		}
 	}
 
-	if ((res = Audio_BufferData(output->Handle, 0, data, snd->DataSize))) { Sounds_Fail(res); return; }
-	if ((res = Audio_Play(output->Handle)))                               { Sounds_Fail(res); return; }
+	v->Pos = pos; v->Frac = frac;
+	return pos <= last;
 }
 
-static void Sounds_Play(uint8_t type, struct Soundboard* board) {
-	struct Sound* snd;
-	struct AudioFormat  fmt;
-	struct SoundOutput* outputs;
-	struct SoundOutput* output;
-	struct AudioFormat* l;
+static void Mixer_Mix(int16_t* data) {
+	int32_t* accum = mixer_accum;
+	int i, sample;
 
-	bool finished;
-	int i, volume;
+	Mem_Set(accum, 0, sizeof(mixer_accum));
+	for (i = 0; i < mixer_voicesCount;) {
+		if (Mixer_MixVoice(&mixer_voices[i], accum)) { i++; continue; }
+
+		/* voice finished, so replace it with the last voice */
+		mixer_voices[i] = mixer_voices[--mixer_voicesCount];
+	}
+
+	/* simple enough for compilers to vectorise */
+	for (i = 0; i < MIXER_CHUNK_SAMPLES; i++) {
+		sample  = accum[i] >> 8;
+		sample  = sample < -32768 ? -32768 : sample;
+		sample  = sample >  32767 ?  32767 : sample;
+		data[i] = (int16_t)sample;
+	}
+}
+
+/* Fills all buffers that have finished playing with newly mixed data */
+static ReturnCode Mixer_FillBuffers(bool* queued) {
+	bool completed;
+	int i;
 	ReturnCode res;
 
-	if (type == SOUND_NONE || !Audio_SoundsVolume) return;
-	snd = Soundboard_PickRandom(board, type);
-	if (!snd) return;
+	for (i = 0; i < AUDIO_MAX_BUFFERS && mixer_voicesCount; i++) {
+		if ((res = Audio_IsCompleted(mixer_out, i, &completed))) return res;
+		if (!completed) continue;
 
-	fmt     = snd->Format;
-	volume  = Audio_SoundsVolume;
-	outputs = fmt.Channels == 1 ? monoOutputs : stereoOutputs;
+		Mixer_ProcessQueue();
+		Mixer_Mix(&mixer_buffers[MIXER_CHUNK_SAMPLES * i]);
 
-	if (board == &digBoard) {
-		if (type == SOUND_METAL) fmt.SampleRate = (fmt.SampleRate * 6) / 5;
-		else fmt.SampleRate = (fmt.SampleRate * 4) / 5;
-	} else {
-		volume /= 2;
-		if (type == SOUND_METAL) fmt.SampleRate = (fmt.SampleRate * 7) / 5;
+		res = Audio_BufferData(mixer_out, i, &mixer_buffers[MIXER_CHUNK_SAMPLES * i], MIXER_CHUNK_SAMPLES * 2);
+		if (res) return res;
+		*queued = true;
 	}
+	return 0;
+}
 
-	/* Try to play on fresh device, or device with same data format */
-	for (i = 0; i < AUDIO_MAX_HANDLES; i++) {
-		output = &outputs[i];
-		if (output->Handle == HANDLE_INV) {
-			Audio_Init(&output->Handle, 1);
-		} else {
-			res = Audio_IsFinished(output->Handle, &finished);
+static void Mixer_RunLoop(void) {
+	struct AudioFormat fmt;
+	bool queued, finished;
+	ReturnCode res;
 
-			if (res) { Sounds_Fail(res); return; }
-			if (!finished) continue;
-		}
+	fmt.Channels      = 2;
+	fmt.SampleRate    = MIXER_SAMPLE_RATE;
+	fmt.BitsPerSample = 16;
+
+	Audio_Init(&mixer_out, AUDIO_MAX_BUFFERS);
+	res = Audio_SetFormat(mixer_out, &fmt);
+
+	while (!res && !mixer_pendingStop) {
+		Mixer_ProcessQueue();
+		/* nothing to play, so sleep until a sound is queued */
+		if (!mixer_voicesCount) { Waitable_Wait(mixer_waitable); continue; }
 
-		l = Audio_GetFormat(output->Handle);
-		if (!l->Channels || AudioFormat_Eq(l, &fmt)) {
-			Sounds_PlayRaw(output, snd, &fmt, volume); return;
+		queued = false;
+		if ((res = Mixer_FillBuffers(&queued))) break;
+
+		/* output stops when it runs out of buffers, so restart it */
+		if (queued) {
+			if ((res = Audio_IsFinished(mixer_out, &finished))) break;
+			if (finished && (res = Audio_Play(mixer_out)))      break;
 		}
+		Thread_Sleep(MIXER_POLL_INTERVAL);
+	}
+
+	if (res) {
+		Logger_Warn(res, "playing sounds");
+		Chat_AddRaw("&cDisabling sounds");
+		Audio_SoundsVolume = 0;
 	}
+	Audio_StopAndFree(mixer_out);
+	mixer_voicesCount = 0;
+
+	if (mixer_joining) return;
+	Thread_Detach(mixer_thread);
+	mixer_thread = NULL;
+}
+
+static void Mixer_Init(void) {
+	if (mixer_thread) return;
+	mixer_joining     = false;
+	mixer_pendingStop = false;
+
+	/* Mixer thread isn't running, so it's safe to drop sounds queued before it stopped */
+	Mixer_StoreIndex(&mixer_queueTail, mixer_queueHead);
+	mixer_thread = Thread_Start(Mixer_RunLoop, false);
+}
+
+static void Mixer_Free(void) {
+	mixer_joining     = true;
+	mixer_pendingStop = true;
+	Waitable_Signal(mixer_waitable);
+
+	if (mixer_thread) Thread_Join(mixer_thread);
+	mixer_thread = NULL;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Sounds-----------------------------------------------------------*
+*#########################################################################################################################*/
+/* Sounds closer than this are played at full volume, further sounds get quieter with distance */
+#define SOUNDS_REF_DISTANCE 8.0f
+/* Sounds further away than this are not played at all */
+#define SOUNDS_MAX_DISTANCE 64.0f
+/* How much quieter sounds fully on one side of the player are in the ear on the other side */
+#define SOUNDS_MAX_PAN 0.5f
+/* At most this many sounds are played for blocks the server changed, per interval */
+#define SOUNDS_MAX_SERVER_BLOCKS 4
+#define SOUNDS_SERVER_INTERVAL 250 /* milliseconds */
+
+static struct Soundboard digBoard, stepBoard;
+static bool sounds_serverBlocks;
+static TimeMS sounds_serverBeg;
+static int sounds_serverCount;
+
+/* Calculates left and right channel gain for a sound emitted at the given position */
+static void Sounds_CalcGain(const Vector3* pos, float* left, float* right) {
+	struct Entity* p = &LocalPlayer_Instance.Base;
+	Vector3 eye, delta;
+	float dist, yaw, pan, gain;
+
+	eye = Entity_GetEyePosition(p);
+	Vector3_Sub(&delta, pos, &eye);
+	dist = Math_SqrtF(Vector3_LengthSquared(&delta));
+	if (dist > SOUNDS_MAX_DISTANCE) { *left = 0.0f; *right = 0.0f; return; }
 
-	/* Try again with all devices, even if need to recreate one (expensive) */
-	for (i = 0; i < AUDIO_MAX_HANDLES; i++) {
-		output = &outputs[i];
-		res = Audio_IsFinished(output->Handle, &finished);
+	gain = dist > SOUNDS_REF_DISTANCE ? SOUNDS_REF_DISTANCE / dist : 1.0f;
+	*left = gain; *right = gain;
 
-		if (res) { Sounds_Fail(res); return; }
-		if (!finished) continue;
+	dist = Math_SqrtF(delta.X * delta.X + delta.Z * delta.Z);
+	if (dist < 0.5f) return;
 
-		Sounds_PlayRaw(output, snd, &fmt, volume); return;
+	/* project direction onto the player's right vector */
+	yaw = p->HeadY * MATH_DEG2RAD;
+	pan = (delta.X * Math_CosF(yaw) + delta.Z * Math_SinF(yaw)) / dist;
+
+	if (pan > 0.0f) *left  *= 1.0f - pan * SOUNDS_MAX_PAN;
+	else            *right *= 1.0f + pan * SOUNDS_MAX_PAN;
+}
+
+static void Sounds_Play(uint8_t type, struct Soundboard* board, const Vector3* pos) {
+	struct Sound* snd;
+	float left = 1.0f, right = 1.0f;
+	int volume, rate, volL, volR;
+	uint32_t step;
+
+	if (type == SOUND_NONE || !Audio_SoundsVolume) return;
+	snd = Soundboard_PickRandom(board, type);
+	if (!snd) return;
+
+	volume = Audio_SoundsVolume;
+	rate   = snd->Format.SampleRate;
+
+	if (board == &digBoard) {
+		if (type == SOUND_METAL) rate = (rate * 6) / 5;
+		else rate = (rate * 4) / 5;
+	} else {
+		volume /= 2;
+		if (type == SOUND_METAL) rate = (rate * 7) / 5;
 	}
+
+	if (pos) Sounds_CalcGain(pos, &left, &right);
+	volL = (int)(left  * volume * 256 / 100);
+	volR = (int)(right * volume * 256 / 100);
+	if (!volL && !volR) return;
+
+	step = (uint32_t)(((uint64_t)rate << 16) / MIXER_SAMPLE_RATE);
+	Mixer_Push(snd, step, volL, volR);
 }
 
-static void Audio_PlayBlockSound(void* obj, Vector3I coords, BlockID old, BlockID now) {
+void Audio_PlayBlockSound(int x, int y, int z, BlockID old, BlockID now) {
+	Vector3 pos;
+	pos.X = x + 0.5f; pos.Y = y + 0.5f; pos.Z = z + 0.5f;
+
 	if (now == BLOCK_AIR) {
-		Audio_PlayDigSound(Blocks.DigSounds[old]);
+		Sounds_Play(Blocks.DigSounds[old],  &digBoard, &pos);
 	} else if (!Game_ClassicMode) {
-		Audio_PlayDigSound(Blocks.StepSounds[now]);
+		Sounds_Play(Blocks.StepSounds[now], &digBoard, &pos);
 	}
 }
 
-static void Sounds_FreeOutputs(struct SoundOutput* outputs) {
-	int i;
-	for (i = 0; i < AUDIO_MAX_HANDLES; i++) {
-		if (outputs[i].Handle == HANDLE_INV) continue;
-
-		Audio_StopAndFree(outputs[i].Handle);
-		outputs[i].Handle = HANDLE_INV;
+void Audio_PlayServerBlockSound(int x, int y, int z, BlockID old, BlockID now) {
+	TimeMS time;
+	if (!sounds_serverBlocks || !Audio_SoundsVolume) return;
 
-		Mem_Free(outputs[i].Buffer);
-		outputs[i].Buffer     = NULL;
-		outputs[i].BufferSize = 0;
+	time = DateTime_CurrentUTC_MS();
+	if (time >= sounds_serverBeg + SOUNDS_SERVER_INTERVAL) {
+		sounds_serverBeg   = time;
+		sounds_serverCount = 0;
 	}
+
+	if (sounds_serverCount >= SOUNDS_MAX_SERVER_BLOCKS) return;
+	sounds_serverCount++;
+	Audio_PlayBlockSound(x, y, z, old, now);
+}
+
+static void Audio_OnBlockChanged(void* obj, Vector3I coords, BlockID old, BlockID now) {
+	Audio_PlayBlockSound(coords.X, coords.Y, coords.Z, old, now);
 }
 
 static void Sounds_Init(void) {
 	const static String dig  = String_FromConst("dig_");
 	const static String step = String_FromConst("step_");
+	Mixer_Init();
 
 	if (digBoard.Count || stepBoard.Count) return;
+	SoundBank_Open();
 	Soundboard_Init(&digBoard,  &dig,  &files);
 	Soundboard_Init(&stepBoard, &step, &files);
+	SoundBank_Close();
 }
 
-static void Sounds_Free(void) {
-	Sounds_FreeOutputs(monoOutputs);
-	Sounds_FreeOutputs(stereoOutputs);
-}
+static void Sounds_Free(void) { Mixer_Free(); }
 
 void Audio_SetSounds(int volume) {
 	if (volume) Sounds_Init();
@@ -338,155 +750,325 @@ void Audio_SetSounds(int volume) {
 	Audio_SoundsVolume = volume;
 }
 
-void Audio_PlayDigSound(uint8_t type)  { Sounds_Play(type, &digBoard); }
-void Audio_PlayStepSound(uint8_t type) { Sounds_Play(type, &stepBoard); }
+void Audio_PlayDigSound(uint8_t type)  { Sounds_Play(type, &digBoard,  NULL); }
+void Audio_PlayStepSound(uint8_t type) { Sounds_Play(type, &stepBoard, NULL); }
 
 
 /*########################################################################################################################*
 *--------------------------------------------------------Music------------------------------------------------------------*
 *#########################################################################################################################*/
+#define MUSIC_MAX_FILES 512
+/* Music is decoded in buffers of about this many milliseconds */
+#define MUSIC_BUFFER_MS 1000
+/* How much of the next track is decoded ahead of time, while current track is still playing */
+#define MUSIC_HEAD_MS 500
+
+struct MusicTrack {
+	struct Stream file, ogg;
+	struct VorbisState vorbis;
+	uint8_t buffer[OGG_BUFFER_SIZE];
+	int16_t* head;         /* samples decoded ahead of time */
+	int headCount, headUsed;
+	uint32_t decoded;      /* number of samples per channel decoded so far */
+	int fileIdx; bool open, ended;
+};
+
 static AudioHandle music_out;
 static void* music_thread;
 static void* music_waitable;
 static volatile bool music_pendingStop, music_joining;
+/* Whether music output signals music_waitable when a buffer finishes playing */
+static bool music_signalled;
+
+static struct MusicTrack music_tracks[2];
+static uint16_t music_files[MUSIC_MAX_FILES];
+static int music_filesCount;
+static RNGState music_rnd;
+/* Track that was playing when music was stopped, so it can be resumed when music is started again */
+static int music_resumeIdx = -1;
+static uint32_t music_resumeSample;
+
+static void Music_CloseTrack(struct MusicTrack* t) {
+	if (!t->open) return;
+	t->open = false;
+
+	Vorbis_Free(&t->vorbis);
+	t->file.Close(&t->file);
+	Mem_Free(t->head);
+	t->head = NULL;
+}
 
-static ReturnCode Music_Buffer(int i, int16_t* data, int maxSamples, struct VorbisState* ctx) {
-	int samples = 0;
-	int16_t* cur;
-	ReturnCode res = 0, res2;
+static ReturnCode Music_OpenTrack(struct MusicTrack* t, int fileIdx) {
+	char pathBuffer[FILENAME_SIZE];
+	String path = String_FromArray(pathBuffer);
+	String file;
+	ReturnCode res;
 
-	while (samples < maxSamples) {
-		if ((res = Vorbis_DecodeFrame(ctx))) break;
+	file = StringsBuffer_UNSAFE_Get(&files, fileIdx);
+	String_Format1(&path, "audio/%s", &file);
 
-		cur = &data[samples];
-		samples += Vorbis_OutputFrame(ctx, cur);
-	}
-	if (Audio_MusicVolume < 100) { Volume_Mix16(data, samples, Audio_MusicVolume); }
+	res = Stream_OpenFile(&t->file, &path);
+	if (res) { Logger_Warn2(res, "opening", &path); return res; }
+
+	Mem_Set(&t->vorbis, 0, sizeof(t->vorbis));
+	Ogg_MakeStream(&t->ogg, t->buffer, &t->file);
+	t->vorbis.Source = &t->ogg;
 
-	res2 = Audio_BufferData(music_out, i, data, samples * 2);
-	if (res2) { music_pendingStop = true; return res2; }
+	t->open    = true; t->ended    = false;
+	t->fileIdx = fileIdx; t->decoded = 0;
+	t->headCount = 0; t->headUsed = 0;
+
+	res = Vorbis_DecodeHeaders(&t->vorbis);
+	if (res) { Logger_Warn2(res, "decoding", &path); Music_CloseTrack(t); }
 	return res;
 }
 
-static ReturnCode Music_PlayOgg(struct Stream* source) {
-	uint8_t buffer[OGG_BUFFER_SIZE];
-	struct Stream stream;
-	struct VorbisState vorbis = { 0 };
-	struct AudioFormat fmt;
+/* Decodes samples from the track until data has at least maxSamples samples */
+static ReturnCode Music_Decode(struct MusicTrack* t, int16_t* data, int maxSamples, int* count) {
+	ReturnCode res = 0;
+	int n;
 
-	int chunkSize, samplesPerSecond;
-	int16_t* data = NULL;
-	bool completed;
-	int i, next;
+	/* use samples decoded ahead of time first */
+	if (t->headUsed < t->headCount) {
+		n = min(t->headCount - t->headUsed, maxSamples - *count);
+		Mem_Copy(&data[*count], &t->head[t->headUsed], n * 2);
+		t->headUsed += n; *count += n;
+	}
+	if (t->ended) return *count < maxSamples ? ERR_END_OF_STREAM : 0;
+
+	while (*count < maxSamples) {
+		if ((res = Vorbis_DecodeFrame(&t->vorbis))) break;
+
+		n = Vorbis_OutputFrame(&t->vorbis, &data[*count]);
+		*count     += n;
+		t->decoded += n / t->vorbis.Channels;
+	}
+
+	if (res == ERR_END_OF_STREAM) t->ended = true;
+	return res;
+}
+
+/* Opens a random track, and decodes the start of it ahead of time */
+static ReturnCode Music_Prefetch(struct MusicTrack* t) {
+	int idx = music_files[Random_Range(&music_rnd, 0, music_filesCount)];
+	int headMax;
 	ReturnCode res;
 
-	Ogg_MakeStream(&stream, buffer, source);
-	vorbis.Source = &stream;
-	if ((res = Vorbis_DecodeHeaders(&vorbis))) goto cleanup;
-	
-	fmt.Channels      = vorbis.Channels;
-	fmt.SampleRate    = vorbis.SampleRate;
-	fmt.BitsPerSample = 16;
-	if ((res = Audio_SetFormat(music_out, &fmt))) goto cleanup;
+	if ((res = Music_OpenTrack(t, idx))) return res;
+	headMax = t->vorbis.Channels * t->vorbis.SampleRate / 1000 * MUSIC_HEAD_MS;
+	t->head = Mem_Alloc(headMax + t->vorbis.Channels * t->vorbis.BlockSizes[1], 2, "Ogg - prefetched PCM");
 
-	/* largest possible vorbis frame decodes to blocksize1 * channels samples */
-	/* so we may end up decoding slightly over a second of audio */
-	chunkSize        = fmt.Channels * (fmt.SampleRate + vorbis.BlockSizes[1]);
-	samplesPerSecond = fmt.Channels * fmt.SampleRate;
-	data = Mem_Alloc(chunkSize * AUDIO_MAX_BUFFERS, 2, "Ogg - final PCM output");
+	res = Music_Decode(t, t->head, headMax, &t->headCount);
+	/* track might be shorter than the amount decoded ahead of time */
+	return res == ERR_END_OF_STREAM ? 0 : res;
+}
 
-	/* fill up with some samples before playing */
-	for (i = 0; i < AUDIO_MAX_BUFFERS && !res; i++) {
-		res = Music_Buffer(i, &data[chunkSize * i], samplesPerSecond, &vorbis);
-	}
-	if (music_pendingStop) goto cleanup;
+static ReturnCode Music_Resume(struct MusicTrack* t) {
+	uint32_t actual;
+	ReturnCode res;
 
-	res = Audio_Play(music_out);
-	if (res) goto cleanup;
+	/* if track can't be opened anymore, just play some other track instead */
+	if (Music_OpenTrack(t, music_resumeIdx)) return Music_Prefetch(t);
+	res = Vorbis_Seek(&t->vorbis, music_resumeSample, &actual);
+	if (!res) { t->decoded = actual; return 0; }
 
-	for (;;) {
-		next = -1;
-		
-		for (i = 0; i < AUDIO_MAX_BUFFERS; i++) {
-			res = Audio_IsCompleted(music_out, i, &completed);
-			if (res)       { music_pendingStop = true; break; }
-			if (completed) { next = i; break; }
-		}
+	/* if track can't be seeked, just play it from the start */
+	if (res == ReturnCode_NotSupported) return 0;
+	Logger_Warn(res, "seeking music");
 
-		if (next == -1) { Thread_Sleep(10); continue; }
-		if (music_pendingStop) break;
+	/* position in file is unknown after a failed seek, so reopen it */
+	Music_CloseTrack(t);
+	return Music_OpenTrack(t, music_resumeIdx);
+}
 
-		res = Music_Buffer(next, &data[chunkSize * next], samplesPerSecond, &vorbis);
-		/* need to specially handle last bit of audio */
-		if (res) break;
+static bool Music_SameFormat(struct MusicTrack* a, struct MusicTrack* b) {
+	return a->vorbis.Channels == b->vorbis.Channels && a->vorbis.SampleRate == b->vorbis.SampleRate;
+}
+
+/* Waits until a buffer might have finished playing, or music is being stopped */
+static void Music_WaitBuffer(void) {
+	if (music_signalled) {
+		Waitable_Wait(music_waitable);
+	} else {
+		/* check for finished buffers a few times per buffer, rather than continuously polling */
+		Waitable_WaitFor(music_waitable, MUSIC_BUFFER_MS / 4);
 	}
+}
 
-	if (music_pendingStop) Audio_Stop(music_out);
-	/* Wait until the buffers finished playing */
-	for (;;) {
-		if (Audio_IsFinished(music_out, &completed) || completed) break;
-		Thread_Sleep(10);
+/* Waits until either all queued music has played, or music is being stopped */
+static ReturnCode Music_WaitFinished(void) {
+	bool finished;
+	ReturnCode res;
+
+	while (!music_pendingStop) {
+		if ((res = Audio_IsFinished(music_out, &finished))) return res;
+		if (finished) break;
+		Music_WaitBuffer();
 	}
+	return 0;
+}
 
-cleanup:
-	Mem_Free(data);
-	Vorbis_Free(&vorbis);
-	return res == ERR_END_OF_STREAM ? 0 : res;
+/* Waits until either the given time has elapsed, or music is being stopped */
+static void Music_Sleep(int delay) {
+	TimeMS end = DateTime_CurrentUTC_MS() + delay, now;
+
+	/* waitable may also be signalled by output finishing a buffer */
+	while (!music_pendingStop) {
+		now = DateTime_CurrentUTC_MS();
+		if (now >= end) break;
+		Waitable_WaitFor(music_waitable, (uint32_t)(end - now));
+	}
 }
 
-#define MUSIC_MAX_FILES 512
-static void Music_RunLoop(void) {
-	const static String ogg = String_FromConst(".ogg");
-	char pathBuffer[FILENAME_SIZE];
-	String path = String_FromArray(pathBuffer);
+static ReturnCode Music_PlayAll(void) {
+	struct MusicTrack* cur  = &music_tracks[0];
+	struct MusicTrack* next = &music_tracks[1];
+	struct MusicTrack* tmp;
+	struct AudioFormat fmt = { 0 };
+	int bufferFrames[AUDIO_MAX_BUFFERS] = { 0 };
+	int16_t* data = NULL;
+	int16_t* buffer;
 
-	uint16_t musicFiles[MUSIC_MAX_FILES];
+	int chunkSize = 0, maxSamples = 0;
+	int i, idx, count, delay;
+	bool gapless, completed, finished;
+	uint32_t queued;
 	String file;
+	ReturnCode res, res2;
 
-	RNGState rnd;
-	struct Stream stream;
-	int i, count = 0, idx, delay;
-	ReturnCode res = 0;
+	gapless = Options_GetBool(OPT_MUSIC_GAPLESS, false);
 
-	for (i = 0; i < files.Count && count < MUSIC_MAX_FILES; i++) {
-		file = StringsBuffer_UNSAFE_Get(&files, i);
-		if (!String_CaselessEnds(&file, &ogg)) continue;
-		musicFiles[count++] = i;
+	if (music_resumeIdx >= 0) {
+		res = Music_Resume(cur);
+	} else {
+		res = Music_Prefetch(cur);
 	}
+	music_resumeIdx = -1;
+
+	while (!res && !music_pendingStop) {
+		/* format can only be changed once previous track has fully played */
+		if (fmt.Channels != cur->vorbis.Channels || fmt.SampleRate != cur->vorbis.SampleRate) {
+			if ((res = Music_WaitFinished())) break;
+
+			fmt.Channels      = cur->vorbis.Channels;
+			fmt.SampleRate    = cur->vorbis.SampleRate;
+			fmt.BitsPerSample = 16;
+			if ((res = Audio_SetFormat(music_out, &fmt))) break;
+
+			/* largest possible vorbis frame decodes to max blocksize * channels samples */
+			/* so we may end up decoding slightly over a buffer of audio */
+			maxSamples = fmt.Channels * fmt.SampleRate / 1000 * MUSIC_BUFFER_MS;
+			chunkSize  = maxSamples + fmt.Channels * VORBIS_MAX_BLOCK_SIZE;
+			Mem_Free(data);
+			data = Mem_Alloc(chunkSize * AUDIO_MAX_BUFFERS, 2, "Ogg - final PCM output");
+		}
 
-	Random_InitFromCurrentTime(&rnd);
-	Audio_Init(&music_out, AUDIO_MAX_BUFFERS);
-
-	while (!music_pendingStop && count) {
-		idx  = Random_Range(&rnd, 0, count);
-		file = StringsBuffer_UNSAFE_Get(&files, musicFiles[idx]);
-		
-		path.length = 0;
-		String_Format1(&path, "audio/%s", &file);
+		file = StringsBuffer_UNSAFE_Get(&files, cur->fileIdx);
 		Platform_Log1("playing music file: %s", &file);
+		/* decode start of next track while this track is playing */
+		if (!next->open && (res = Music_Prefetch(next))) break;
+
+		while (!music_pendingStop) {
+			idx = -1;
+			for (i = 0; i < AUDIO_MAX_BUFFERS; i++) {
+				if ((res = Audio_IsCompleted(music_out, i, &completed))) break;
+				if (completed) { idx = i; break; }
+			}
+			if (res) break;
+			if (idx == -1) { Music_WaitBuffer(); continue; }
 
-		res = Stream_OpenFile(&stream, &path);
-		if (res) { Logger_Warn2(res, "opening", &path); break; }
+			buffer = &data[chunkSize * idx];
+			count  = 0;
+			res    = Music_Decode(cur, buffer, maxSamples, &count);
 
-		res = Music_PlayOgg(&stream);
-		if (res) { 
-			Logger_Warn2(res, "playing", &path); stream.Close(&stream); break;
+			/* continue straight into the next track in the same buffer */
+			if (res == ERR_END_OF_STREAM && gapless && Music_SameFormat(cur, next)) {
+				Music_CloseTrack(cur);
+				tmp = cur; cur = next; next = tmp;
+
+				file = StringsBuffer_UNSAFE_Get(&files, cur->fileIdx);
+				Platform_Log1("playing music file: %s", &file);
+				res = Music_Decode(cur, buffer, maxSamples, &count);
+			}
+
+			if (count) {
+				if (Audio_MusicVolume < 100) { Volume_Mix16(buffer, count, Audio_MusicVolume); }
+				bufferFrames[idx] = count / fmt.Channels;
+
+				if ((res2 = Audio_BufferData(music_out, idx, buffer, count * 2))) { res = res2; break; }
+				/* output stops when it runs out of buffers, so restart it */
+				if ((res2 = Audio_IsFinished(music_out, &finished)))             { res = res2; break; }
+				if (finished && (res2 = Audio_Play(music_out)))                  { res = res2; break; }
+			}
+
+			if (res) break;
+			if (!next->open && (res = Music_Prefetch(next))) break;
+		}
+
+		if (music_pendingStop) {
+			/* remember where to resume track from, minus what is still waiting to be played */
+			if (res) break;
+			queued = 0;
+			for (i = 0; i < AUDIO_MAX_BUFFERS; i++) {
+				if ((res = Audio_IsCompleted(music_out, i, &completed))) break;
+				if (!completed) queued += bufferFrames[i];
+			}
+
+			music_resumeIdx    = cur->fileIdx;
+			music_resumeSample = cur->decoded > queued ? cur->decoded - queued : 0;
+			Audio_Stop(music_out);
+			break;
+		}
+		if (res != ERR_END_OF_STREAM) break;
+		res = 0;
+
+		/* track finished, so swap over to the next track that was already decoded ahead */
+		if (!gapless || !Music_SameFormat(cur, next)) {
+			if ((res = Music_WaitFinished())) break;
+		}
+		Music_CloseTrack(cur);
+		tmp = cur; cur = next; next = tmp;
+
+		if (!gapless) {
+			delay = 1000 * 120 + Random_Range(&music_rnd, 0, 1000 * 300);
+			Music_Sleep(delay);
 		}
+	}
 
-		res = stream.Close(&stream);
-		if (res) { Logger_Warn2(res, "closing", &path); break; }
+	Music_CloseTrack(&music_tracks[0]);
+	Music_CloseTrack(&music_tracks[1]);
+	Mem_Free(data);
+	return res == ERR_END_OF_STREAM ? 0 : res;
+}
+
+static void Music_RunLoop(void) {
+	const static String ogg = String_FromConst(".ogg");
+	String file;
+	int i;
+	ReturnCode res;
 
-		if (music_pendingStop) break;
-		delay = 1000 * 120 + Random_Range(&rnd, 0, 1000 * 300);
-		Waitable_WaitFor(music_waitable, delay);
+	music_filesCount = 0;
+	for (i = 0; i < files.Count && music_filesCount < MUSIC_MAX_FILES; i++) {
+		file = StringsBuffer_UNSAFE_Get(&files, i);
+		if (!String_CaselessEnds(&file, &ogg)) continue;
+		music_files[music_filesCount++] = i;
 	}
+	if (!music_filesCount) goto finished;
+
+	Random_InitFromCurrentTime(&music_rnd);
+	Audio_Init(&music_out, AUDIO_MAX_BUFFERS);
+	music_signalled = Audio_SetWaitable(music_out, music_waitable);
+	res = Music_PlayAll();
 
 	if (res) {
+		Logger_Warn(res, "playing music");
 		Chat_AddRaw("&cDisabling music");
 		Audio_MusicVolume = 0;
+		music_resumeIdx   = -1;
 	}
 	Audio_StopAndFree(music_out);
 
+finished:
 	if (music_joining) return;
 	Thread_Detach(music_thread);
 	music_thread = NULL;
@@ -541,19 +1123,22 @@ static void AudioManager_Init(void) {
 		Directory_Enum(&path, NULL, AudioManager_FilesCallback);
 	}
 	music_waitable = Waitable_Create();
+	mixer_waitable = Waitable_Create();
 
 	volume = AudioManager_GetVolume(OPT_MUSIC_VOLUME, OPT_USE_MUSIC);
 	Audio_SetMusic(volume);
 	volume = AudioManager_GetVolume(OPT_SOUND_VOLUME, OPT_USE_SOUND);
 	Audio_SetSounds(volume);
-	Event_RegisterBlock(&UserEvents.BlockChanged, NULL, Audio_PlayBlockSound);
+	sounds_serverBlocks = Options_GetBool(OPT_SERVER_BLOCK_SOUNDS, false);
+	Event_RegisterBlock(&UserEvents.BlockChanged, NULL, Audio_OnBlockChanged);
 }
 
 static void AudioManager_Free(void) {
 	Music_Free();
 	Sounds_Free();
 	Waitable_Free(music_waitable);
-	Event_UnregisterBlock(&UserEvents.BlockChanged, NULL, Audio_PlayBlockSound);
+	Waitable_Free(mixer_waitable);
+	Event_UnregisterBlock(&UserEvents.BlockChanged, NULL, Audio_OnBlockChanged);
 }
 
 struct IGameComponent Audio_Component = {
@@ -17,4 +17,11 @@ void Audio_SetMusic(int volume);
 void Audio_SetSounds(int volume);
 void Audio_PlayDigSound(uint8_t type);
 void Audio_PlayStepSound(uint8_t type);
+/* Plays the sound of the block at the given coordinates changing from old to now. */
+/* Sound gets quieter the further away it is from the player, and is panned towards the side it is on. */
+void Audio_PlayBlockSound(int x, int y, int z, BlockID old, BlockID now);
+/* Plays the sound of a block the server changed. (e.g. placed or deleted by another player) */
+/* NOTE: Only plays if the sounds-serverblocks option is enabled, and only a few times a second, */
+/*  since servers may change many blocks at once. (e.g. for drawing commands) */
+void Audio_PlayServerBlockSound(int x, int y, int z, BlockID old, BlockID now);
 #endif
@@ -41,7 +41,6 @@ void Bitmap_AllocateClearedPow2(Bitmap* bmp, int width, int height) {
 /*########################################################################################################################*
 *------------------------------------------------------PNG decoder--------------------------------------------------------*
 *#########################################################################################################################*/
-#define PNG_SIG_SIZE 8
 #define PNG_IHDR_SIZE 13
 #define PNG_RGB_MASK 0xFFFFFFUL
 #define PNG_PALETTE 256
@@ -69,6 +68,32 @@ bool Png_Detect(const uint8_t* data, uint32_t len) {
 	return true;
 }
 
+/* Returns whichever of left (a), above (b) or upper left (c) is closest to a + b - c */
+/* Written without branches, since which one is picked is essentially random per byte */
+static CC_INLINE uint8_t Png_Paeth(int a, int b, int c) {
+	int pa = b - c, pb = a - c, pc = a + b - c - c; /* p - a, p - b, p - c */
+	int bc;
+	pa = pa < 0 ? -pa : pa;
+	pb = pb < 0 ? -pb : pb;
+	pc = pc < 0 ? -pc : pc;
+
+	bc = pb <= pc ? b : c;
+	return (pa <= pb && pa <= pc) ? a : bc;
+}
+
+/* Adds each byte of the prior row to the line. Prior row is loaded before writing each block */
+/* of 16 bytes, so compilers can prove the two don't overlap and use 16 byte vector adds */
+static void Png_ReconstructUp(uint8_t* line, uint8_t* prior, uint32_t lineLen) {
+	uint8_t above[16];
+	uint32_t i; int k;
+
+	for (i = 0; i < (lineLen & ~0x0F); i += 16) {
+		for (k = 0; k < 16; k++) { above[k] = prior[i + k]; }
+		for (k = 0; k < 16; k++) { line[i + k] += above[k]; }
+	}
+	for (; i < lineLen; i++) { line[i] += prior[i]; }
+}
+
 static void Png_Reconstruct(uint8_t type, uint8_t bytesPerPixel, uint8_t* line, uint8_t* prior, uint32_t lineLen) {
 	uint32_t i, j;
 	switch (type) {
@@ -82,9 +107,7 @@ static void Png_Reconstruct(uint8_t type, uint8_t bytesPerPixel, uint8_t* line,
 		return;
 
 	case PNG_FILTER_UP:
-		for (i = 0; i < lineLen; i++) {
-			line[i] += prior[i];
-		}
+		Png_ReconstructUp(line, prior, lineLen);
 		return;
 
 	case PNG_FILTER_AVERAGE:
@@ -97,20 +120,11 @@ static void Png_Reconstruct(uint8_t type, uint8_t bytesPerPixel, uint8_t* line,
 		return;
 
 	case PNG_FILTER_PAETH:
-		/* TODO: verify this is right */
 		for (i = 0; i < bytesPerPixel; i++) {
 			line[i] += prior[i];
 		}
 		for (j = 0; i < lineLen; i++, j++) {
-			uint8_t a = line[j], b = prior[i], c = prior[j];
-			int p = a + b - c;
-			int pa = Math_AbsI(p - a);
-			int pb = Math_AbsI(p - b);
-			int pc = Math_AbsI(p - c);
-
-			if (pa <= pb && pa <= pc) { line[i] += a; } 
-			else if (pb <= pc) {        line[i] += b; } 
-			else {                      line[i] += c; }
+			line[i] += Png_Paeth(line[j], prior[i], prior[j]);
 		}
 		return;
 
@@ -120,6 +134,43 @@ static void Png_Reconstruct(uint8_t type, uint8_t bytesPerPixel, uint8_t* line,
 	}
 }
 
+/* Reconstructs a scanline whose pixels are exactly 'bpp' bytes (e.g. 3 for RGB, 4 for RGBA) */
+/* The left and upper left pixels are kept in locals, instead of being reloaded from the line, */
+/* and with a constant bpp compilers unroll the per channel loops (and vectorise sub over a pixel) */
+static CC_INLINE void Png_ReconstructPixels(uint8_t type, const int bpp, uint8_t* line, uint8_t* prior, uint32_t lineLen) {
+	uint8_t a[4] = { 0 }, c[4] = { 0 };
+	uint32_t i; int k;
+
+	switch (type) {
+	case PNG_FILTER_SUB:
+		for (i = 0; i < lineLen; i += bpp) {
+			for (k = 0; k < bpp; k++) { a[k] = line[i + k] += a[k]; }
+		}
+		return;
+
+	case PNG_FILTER_PAETH:
+		for (i = 0; i < lineLen; i += bpp) {
+			for (k = 0; k < bpp; k++) {
+				a[k] = line[i + k] += Png_Paeth(a[k], prior[i + k], c[k]);
+				c[k] = prior[i + k];
+			}
+		}
+		return;
+
+	default:
+		/* no faster path for average, as each byte depends on byte of previous pixel */
+		Png_Reconstruct(type, bpp, line, prior, lineLen);
+		return;
+	}
+}
+
+static void Png_Reconstruct3(uint8_t type, uint8_t* line, uint8_t* prior, uint32_t lineLen) {
+	Png_ReconstructPixels(type, 3, line, prior, lineLen);
+}
+static void Png_Reconstruct4(uint8_t type, uint8_t* line, uint8_t* prior, uint32_t lineLen) {
+	Png_ReconstructPixels(type, 4, line, prior, lineLen);
+}
+
 #define Bitmap_Set(dst, r,g,b,a) dst.B = b; dst.G = g; dst.R = r; dst.A = a;
 
 #define PNG_Do_Grayscale(dstI, src, scale)  rgb = (src) * scale; Bitmap_Set(dst[dstI], rgb, rgb, rgb, 255);
@@ -318,7 +369,8 @@ static void Png_ComputeTransparency(Bitmap* bmp, BitmapCol col) {
 #define PNG_BUFFER_SIZE ((PNG_MAX_DIMS * 2 * 4 + 1) * 2)
 
 /* TODO: Test a lot of .png files and ensure output is right */
-ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
+/* If pow2 is set, bitmap is padded to power of two dimensions, with the image in its top left */
+static ReturnCode Png_DecodeImage(Bitmap* bmp, struct Stream* stream, bool pow2, int* imgWidth, int* imgHeight) {
 	uint8_t tmp[PNG_PALETTE * 3];
 	uint32_t dataSize, fourCC;
 	ReturnCode res;
@@ -328,6 +380,7 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 	uint8_t col, bitsPerSample, bytesPerPixel;
 	Png_RowExpander rowExpander;
 	uint32_t scanlineSize, scanlineBytes;
+	int width = 0, height = 0;
 
 	/* palette data */
 	BitmapCol black = BITMAPCOL_CONST(0, 0, 0, 255);
@@ -348,6 +401,7 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 
 	bmp->Width = 0; bmp->Height = 0;
 	bmp->Scan0 = NULL;
+	*imgWidth  = 0; *imgHeight = 0;
 
 	res = Stream_Read(stream, tmp, PNG_SIG_SIZE);
 	if (res) return res;
@@ -371,12 +425,22 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 			res = Stream_Read(stream, tmp, PNG_IHDR_SIZE);
 			if (res) return res;
 
-			bmp->Width  = (int)Stream_GetU32_BE(&tmp[0]);
-			bmp->Height = (int)Stream_GetU32_BE(&tmp[4]);
-			if (bmp->Width  < 0 || bmp->Width  > PNG_MAX_DIMS) return PNG_ERR_TOO_WIDE;
-			if (bmp->Height < 0 || bmp->Height > PNG_MAX_DIMS) return PNG_ERR_TOO_TALL;
-
-			bmp->Scan0 = Mem_Alloc(bmp->Width * bmp->Height, 4, "PNG bitmap data");
+			width  = (int)Stream_GetU32_BE(&tmp[0]);
+			height = (int)Stream_GetU32_BE(&tmp[4]);
+			if (width  < 0 || width  > PNG_MAX_DIMS) return PNG_ERR_TOO_WIDE;
+			if (height < 0 || height > PNG_MAX_DIMS) return PNG_ERR_TOO_TALL;
+			*imgWidth = width; *imgHeight = height;
+
+			if (pow2) {
+				/* decode straight into texture sized bitmap, rather than copying into one afterwards */
+				bmp->Width  = Math_NextPowOf2(width);
+				bmp->Height = Math_NextPowOf2(height);
+				bmp->Scan0  = Mem_AllocCleared(bmp->Width * bmp->Height, 4, "PNG bitmap data");
+			} else {
+				bmp->Width  = width;
+				bmp->Height = height;
+				bmp->Scan0  = Mem_Alloc(width * height, 4, "PNG bitmap data");
+			}
 			bitsPerSample = tmp[8]; col = tmp[9];
 			rowExpander = Png_GetExpander(col, bitsPerSample);
 			if (rowExpander == NULL) return PNG_ERR_INVALID_COL_BPP;
@@ -386,7 +450,7 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 			if (tmp[12] != 0) return PNG_ERR_INTERLACED;
 
 			bytesPerPixel = ((samplesPerPixel[col] * bitsPerSample) + 7) >> 3;
-			scanlineSize  = ((samplesPerPixel[col] * bitsPerSample * bmp->Width) + 7) >> 3;
+			scanlineSize  = ((samplesPerPixel[col] * bitsPerSample * width) + 7) >> 3;
 			scanlineBytes = scanlineSize + 1; /* Add 1 byte for filter byte of each scanline */
 
 			Mem_Set(buffer, 0, scanlineBytes); /* Prior row should be 0 per PNG spec */
@@ -449,7 +513,7 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 			}
 			if (!bmp->Scan0) return PNG_ERR_NO_DATA;
 
-			while (curY < bmp->Height) {
+			while (curY < height) {
 				/* Need to leave one row in buffer untouched for storing prior scanline. Illustrated example of process:
 				*          |=====|        #-----|        |-----|        #-----|        |-----|
 				* initial  #-----| read 3 |-----| read 3 |-----| read 1 |-----| read 3 |-----| etc
@@ -480,8 +544,14 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 					uint8_t* prior    = &buffer[(priorY - 1) * scanlineBytes];
 					uint8_t* scanline = &buffer[rowY         * scanlineBytes];
 
-					Png_Reconstruct(scanline[0], bytesPerPixel, &scanline[1], &prior[1], scanlineSize);
-					rowExpander(bmp->Width, palette, &scanline[1], Bitmap_GetRow(bmp, curY));
+					if (bytesPerPixel == 4) {
+						Png_Reconstruct4(scanline[0], &scanline[1], &prior[1], scanlineSize);
+					} else if (bytesPerPixel == 3) {
+						Png_Reconstruct3(scanline[0], &scanline[1], &prior[1], scanlineSize);
+					} else {
+						Png_Reconstruct(scanline[0], bytesPerPixel, &scanline[1], &prior[1], scanlineSize);
+					}
+					rowExpander(width, palette, &scanline[1], Bitmap_GetRow(bmp, curY));
 				}
 			}
 		} break;
@@ -501,6 +571,15 @@ ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
 	}
 }
 
+ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream) {
+	int width, height;
+	return Png_DecodeImage(bmp, stream, false, &width, &height);
+}
+
+ReturnCode Png_DecodePow2(Bitmap* bmp, struct Stream* stream, int* width, int* height) {
+	return Png_DecodeImage(bmp, stream, true, width, height);
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------PNG encoder--------------------------------------------------------*
@@ -48,6 +48,7 @@ void Bitmap_Allocate(Bitmap* bmp, int width, int height);
 /* NOTE: You are responsible for freeing its memory! */
 void Bitmap_AllocateClearedPow2(Bitmap* bmp, int width, int height);
 
+#define PNG_SIG_SIZE 8
 /* Whether data starts with PNG format signature/identifier. */
 bool Png_Detect(const uint8_t* data, uint32_t len);
 typedef int (*Png_RowSelector)(Bitmap* bmp, int row);
@@ -57,6 +58,10 @@ typedef int (*Png_RowSelector)(Bitmap* bmp, int row);
      https://github.com/nothings/stb/blob/master/stb_image.h
 */
 CC_API ReturnCode Png_Decode(Bitmap* bmp, struct Stream* stream);
+/* Decodes a bitmap in PNG format, into a bitmap padded to power of two dimensions. */
+/* width and height are set to the size of the image, padding beyond that is transparent black. */
+/* NOTE: This avoids needing to copy the image into a new bitmap before using it as a texture. */
+CC_API ReturnCode Png_DecodePow2(Bitmap* bmp, struct Stream* stream, int* width, int* height);
 /* Encodes a bitmap in PNG format. */
 /* selectRow is optional. Can be used to modify how rows are encoded. (e.g. flip image) */
 /* if alpha is non-zero, RGBA channels are saved, otherwise only RGB channels are. */
@@ -185,6 +185,30 @@ static void Block_RecalcIsLiquid(BlockID b) {
 		(collide == COLLIDE_LIQUID_LAVA  && Blocks.Draw[b] == DRAW_TRANSPARENT);
 }
 
+static void Block_CalcPhysicsDesc(BlockID block) {
+	struct BlockPhysicsDesc* desc = &Blocks.Physics[block];
+	uint8_t flags = 0;
+
+	desc->MinBB = Blocks.MinBB[block];
+	desc->MaxBB = Blocks.MaxBB[block];
+	desc->Collide         = Blocks.Collide[block];
+	desc->ExtendedCollide = Blocks.ExtendedCollide[block];
+	desc->Draw            = Blocks.Draw[block];
+
+	switch (desc->ExtendedCollide) {
+	case COLLIDE_LIQUID_WATER: flags = COLLISION_FLAG_WATER;        break;
+	case COLLIDE_LIQUID_LAVA:  flags = COLLISION_FLAG_LAVA;         break;
+	case COLLIDE_CLIMB_ROPE:   flags = COLLISION_FLAG_ROPE;         break;
+	case COLLIDE_SLIPPERY_ICE: flags = COLLISION_FLAG_SLIPPERY_ICE; break;
+	}
+
+	switch (desc->Collide) {
+	case COLLIDE_SOLID:  flags |= COLLISION_FLAG_SOLID;  break;
+	case COLLIDE_LIQUID: flags |= COLLISION_FLAG_LIQUID; break;
+	}
+	desc->Flags = flags;
+}
+
 void Block_SetCollide(BlockID block, CollideType collide) {
 	/* necessary if servers redefined core blocks, before extended collide types were added */
 	collide = DefaultSet_MapOldCollide(block, collide);
@@ -198,6 +222,7 @@ void Block_SetCollide(BlockID block, CollideType collide) {
 	if (collide == COLLIDE_LIQUID_WATER) collide = COLLIDE_LIQUID;
 	if (collide == COLLIDE_LIQUID_LAVA)  collide = COLLIDE_LIQUID;
 	Blocks.Collide[block] = collide;
+	Block_CalcPhysicsDesc(block);
 }
 
 void Block_SetDrawType(BlockID block, DrawType draw) {
@@ -211,6 +236,7 @@ void Block_SetDrawType(BlockID block, DrawType draw) {
 	Blocks.FullOpaque[block] = draw == DRAW_OPAQUE
 		&& Vector3_Equals(&Blocks.MinBB[block], &zero)
 		&& Vector3_Equals(&Blocks.MaxBB[block], &one);
+	Block_CalcPhysicsDesc(block);
 }
 
 
@@ -433,6 +459,7 @@ void Block_RecalculateBB(BlockID block) {
 	Vector3_Add(&Blocks.MinBB[block], &minRaw, &centre);
 	Vector3_Add(&Blocks.MaxBB[block], &maxRaw, &centre);
 	Block_CalcRenderBounds(block);
+	Block_CalcPhysicsDesc(block);
 }
 
 
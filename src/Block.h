@@ -40,6 +40,22 @@ typedef enum CollideType_ {
 	COLLIDE_CLIMB_ROPE    /* Rope/Ladder style climbing interaction when player collides. */
 } CollideType;
 
+/* Flags for how a block collides, see BlockPhysicsDesc */
+enum COLLISION_FLAGS {
+	COLLISION_FLAG_SOLID = 0x01, COLLISION_FLAG_LIQUID = 0x02, COLLISION_FLAG_WATER = 0x04,
+	COLLISION_FLAG_LAVA  = 0x08, COLLISION_FLAG_ROPE   = 0x10, COLLISION_FLAG_SLIPPERY_ICE = 0x20
+};
+
+/* Collision related properties of a block, packed together so that collision and picking loops */
+/* only need to read one small struct per block, instead of from several separate arrays. */
+struct BlockPhysicsDesc {
+	Vector3 MinBB, MaxBB;    /* Same as Blocks.MinBB and Blocks.MaxBB */
+	uint8_t Collide;         /* Same as Blocks.Collide */
+	uint8_t ExtendedCollide; /* Same as Blocks.ExtendedCollide */
+	uint8_t Draw;            /* Same as Blocks.Draw */
+	uint8_t Flags;           /* Combination of COLLISION_FLAG_ values */
+};
+
 CC_VAR extern struct _BlockLists {
 	/* Whether this block is a liquid. (Like water/lava) */
 	bool IsLiquid[BLOCK_COUNT];
@@ -100,6 +116,9 @@ CC_VAR extern struct _BlockLists {
 	uint8_t Hidden[BLOCK_COUNT * BLOCK_COUNT];
 	/* Bit flags of which faces of this block can stretch with greedy meshing. */
 	uint8_t CanStretch[BLOCK_COUNT];
+	/* Packed collision related properties of this block. */
+	/* NOTE: Kept in sync by Block_SetCollide, Block_SetDrawType and Block_RecalculateBB. */
+	struct BlockPhysicsDesc Physics[BLOCK_COUNT];
 } Blocks;
 
 #define Block_Tint(col, block)\
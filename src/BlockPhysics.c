@@ -13,8 +13,9 @@
 #include "Logger.h"
 #include "Vectors.h"
 #include "Chat.h"
+#include "Utils.h"
 
-/* Data for a resizable queue, used for liquid physic tick entries. */
+/* Data for a resizable queue, used for liquid spreading between regions. */
 struct TickQueue {
 	uint32_t* Entries;     /* Buffer holding the items in the tick queue */
 	int EntriesSize; /* Max number of elements in the buffer */
@@ -39,12 +40,16 @@ static void TickQueue_Clear(struct TickQueue* queue) {
 	TickQueue_Init(queue);
 }
 
+/* Set when a tick queue or wheel grew too large and had to be cleared */
+/* (Chat can't be used from here, as liquid regions may be ticked on other threads) */
+static volatile bool tickQueue_overflowed;
+
 static void TickQueue_Resize(struct TickQueue* queue) {
 	uint32_t* entries;
 	int i, idx, capacity;
 
 	if (queue->EntriesSize >= (Int32_MaxValue / 4)) {
-		Chat_AddRaw("&cToo many physics entries, clearing");
+		tickQueue_overflowed = true;
 		TickQueue_Clear(queue);
 		return;
 	}
@@ -69,6 +74,7 @@ static void TickQueue_Resize(struct TickQueue* queue) {
 static void TickQueue_Enqueue(struct TickQueue* queue, uint32_t item) {
 	if (queue->Size == queue->EntriesSize)
 		TickQueue_Resize(queue);
+	if (!queue->Entries) return;
 
 	queue->Entries[queue->Tail] = item;
 	queue->Tail = (queue->Tail + 1) & queue->EntriesMask;
@@ -83,6 +89,150 @@ static uint32_t TickQueue_Dequeue(struct TickQueue* queue) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Tick wheel--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Hierarchical timing wheel, used to schedule physics ticks of blocks. Scheduling is O(1), and scheduled */
+/*  ticks are not touched at all until the wheel slot they are in comes around. Ticks are never cancelled, */
+/*  instead handlers check the block is still the same kind when its tick fires. */
+/* Level 0 has a slot for each of the next 64 ticks, level 1 for each of the next 64 lots of 64 ticks, etc. */
+/* Whenever a lower level wraps around, the next slot of the level above is redistributed into the levels below. */
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE  (1U << (WHEEL_BITS * WHEEL_LEVELS))
+#define WHEEL_NONE   -1
+
+struct TickNode {
+	int Index;      /* Index of the block in the world */
+	uint32_t Due;   /* Tick this node fires at */
+	int Next;       /* Next node in the same slot (or next free node) */
+};
+
+struct TickWheel {
+	struct TickNode* Nodes; /* Buffer holding all the nodes of the wheel */
+	uint32_t NodesCapacity; /* Max number of nodes in the buffer */
+	int FreeHead; /* First unused node in the buffer, or WHEEL_NONE */
+	int Count;    /* Number of scheduled nodes */
+	uint32_t Now; /* Tick the wheel was last advanced to */
+	int Due, DueCount; /* List of nodes that fired when the wheel was last advanced */
+	int Slots[WHEEL_LEVELS * WHEEL_SLOTS]; /* First node in each slot, or WHEEL_NONE */
+};
+
+static void TickWheel_Init(struct TickWheel* w) {
+	int i;
+	w->Nodes = NULL;
+	w->NodesCapacity = 0;
+	w->FreeHead = WHEEL_NONE;
+	w->Count    = 0;
+	w->Now      = 0;
+	w->Due      = WHEEL_NONE;
+	w->DueCount = 0;
+	for (i = 0; i < Array_Elems(w->Slots); i++) { w->Slots[i] = WHEEL_NONE; }
+}
+
+static void TickWheel_Clear(struct TickWheel* w) {
+	Mem_Free(w->Nodes);
+	TickWheel_Init(w);
+}
+
+static int TickWheel_AllocNode(struct TickWheel* w) {
+	uint32_t i, oldCapacity = w->NodesCapacity;
+	int node;
+
+	if (w->FreeHead == WHEEL_NONE) {
+		if (oldCapacity >= (Int32_MaxValue / 64)) {
+			tickQueue_overflowed = true;
+			TickWheel_Clear(w);
+			return WHEEL_NONE;
+		}
+
+		w->Nodes = Utils_Resize(w->Nodes, &w->NodesCapacity, sizeof(struct TickNode),
+								0, oldCapacity ? oldCapacity : 256);
+		for (i = oldCapacity; i < w->NodesCapacity; i++) {
+			w->Nodes[i].Next = (i + 1 < w->NodesCapacity) ? (int)(i + 1) : WHEEL_NONE;
+		}
+		w->FreeHead = oldCapacity;
+	}
+
+	node = w->FreeHead;
+	w->FreeHead = w->Nodes[node].Next;
+	w->Count++;
+	return node;
+}
+
+static void TickWheel_FreeNode(struct TickWheel* w, int node) {
+	w->Nodes[node].Next = w->FreeHead;
+	w->FreeHead = node;
+	w->Count--;
+}
+
+/* Links a node into the slot of the level that covers how far in the future the node is due */
+static void TickWheel_Link(struct TickWheel* w, int node) {
+	struct TickNode* n = &w->Nodes[node];
+	uint32_t due = n->Due, delta = due - w->Now;
+	int level, slot;
+
+	/* Nodes due beyond the range of the wheel wait in the furthest slot, and get relinked from there */
+	if (delta >= WHEEL_RANGE) { due = w->Now + WHEEL_RANGE - 1; delta = WHEEL_RANGE - 1; }
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++) {
+		if (delta < (1U << ((level + 1) * WHEEL_BITS))) break;
+	}
+	slot = level * WHEEL_SLOTS + ((due >> (level * WHEEL_BITS)) & WHEEL_MASK);
+
+	n->Next = w->Slots[slot];
+	w->Slots[slot] = node;
+}
+
+/* Schedules the block at the given index to fire after the given number of ticks have been skipped. */
+/* NOTE: If the wheel is full, it is cleared and tickQueue_overflowed is set instead. */
+static void TickWheel_Schedule(struct TickWheel* w, int index, uint32_t delay) {
+	int node = TickWheel_AllocNode(w);
+	if (node == WHEEL_NONE) return;
+
+	w->Nodes[node].Index = index;
+	w->Nodes[node].Due   = w->Now + delay + 1;
+	TickWheel_Link(w, node);
+}
+
+/* Advances the wheel by one tick, moving the nodes which are now due into the Due list */
+static void TickWheel_Advance(struct TickWheel* w) {
+	int level, slot, node, next;
+	w->Now++;
+
+	for (level = WHEEL_LEVELS - 1; level > 0; level--) {
+		if (w->Now & ((1U << (level * WHEEL_BITS)) - 1)) continue;
+		slot = level * WHEEL_SLOTS + ((w->Now >> (level * WHEEL_BITS)) & WHEEL_MASK);
+
+		node = w->Slots[slot];
+		w->Slots[slot] = WHEEL_NONE;
+		for (; node != WHEEL_NONE; node = next) {
+			next = w->Nodes[node].Next;
+			TickWheel_Link(w, node);
+		}
+	}
+
+	slot = w->Now & WHEEL_MASK;
+	w->Due      = w->Slots[slot];
+	w->DueCount = 0;
+	w->Slots[slot] = WHEEL_NONE;
+	for (node = w->Due; node != WHEEL_NONE; node = w->Nodes[node].Next) { w->DueCount++; }
+}
+
+/* Removes the next node from the Due list, returning the index of its block */
+static int TickWheel_NextDue(struct TickWheel* w) {
+	int node  = w->Due;
+	int index = w->Nodes[node].Index;
+
+	w->Due = w->Nodes[node].Next;
+	w->DueCount--;
+	TickWheel_FreeNode(w, node);
+	return index;
+}
+
+
 typedef void (*PhysicsHandler)(int index, BlockID block);
 static PhysicsHandler Physics_OnActivate[BLOCK_COUNT];
 static PhysicsHandler Physics_OnRandomTick[BLOCK_COUNT];
@@ -93,18 +243,66 @@ bool Physics_Enabled;
 static RNGState physics_rnd;
 static int physics_tickCount;
 static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
-static struct TickQueue physics_lavaQ, physics_waterQ;
+/* Number of blocks with a random tick handler, in each 16x16x16 section of the world */
+static uint16_t* physics_sectionTicks;
+static int physics_sectionsX, physics_sectionsY, physics_sectionsZ;
+
+#define PHYSICS_LAVA_DELAY  30
+#define PHYSICS_WATER_DELAY 5
 
-#define PHYSICS_DELAY_MASK 0xF8000000UL
-#define PHYSICS_POS_MASK   0x07FFFFFFUL
-#define PHYSICS_DELAY_SHIFT 27
-#define PHYSICS_ONE_DELAY   (1U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
+#define Physics_SectionIndex(x, y, z) ((((y) >> CHUNK_SHIFT) * physics_sectionsZ + ((z) >> CHUNK_SHIFT)) * physics_sectionsX + ((x) >> CHUNK_SHIFT))
+
+static void Physics_FreeSections(void) {
+	Mem_Free(physics_sectionTicks);
+	physics_sectionTicks = NULL;
+}
 
+/* Counts how many blocks in each section of the world have a random tick handler */
+static void Physics_CountSections(void) {
+	int x, y, z, row, index = 0;
+	Physics_FreeSections();
+	if (!Physics_Enabled || !World_Blocks) return;
+
+	physics_sectionsX = (World_Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	physics_sectionsY = (World_Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	physics_sectionsZ = (World_Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	physics_sectionTicks = Mem_AllocCleared(physics_sectionsX * physics_sectionsY * physics_sectionsZ, 
+											2, "physics sections");
+
+	for (y = 0; y < World_Height; y++) {
+		for (z = 0; z < World_Length; z++) {
+			row = Physics_SectionIndex(0, y, z);
+
+			for (x = 0; x < World_Width; x++, index++) {
+				if (!Physics_OnRandomTick[World_Blocks[index]]) continue;
+				physics_sectionTicks[row + (x >> CHUNK_SHIFT)]++;
+			}
+		}
+	}
+}
+
+/* Updates count of random tickable blocks in the section the changed block is in */
+static void Physics_TrackBlock(int x, int y, int z, BlockID old, BlockID now) {
+	int i;
+	if (!physics_sectionTicks) return;
+	i = Physics_SectionIndex(x, y, z);
+
+	if (Physics_OnRandomTick[old]) physics_sectionTicks[i]--;
+	if (Physics_OnRandomTick[now]) physics_sectionTicks[i]++;
+}
+
+/* Changes a block in the world, keeping track of random tickable blocks */
+static void Physics_UpdateBlock(int x, int y, int z, BlockID block) {
+	Physics_TrackBlock(x, y, z, World_GetBlock(x, y, z), block);
+	Game_UpdateBlock(x, y, z, block);
+}
+
+static void Physics_OnNewMap(void* obj) { Physics_FreeSections(); }
+
+static void Physics_InitRegions(void);
 static void Physics_OnNewMapLoaded(void* obj) {
-	TickQueue_Clear(&physics_lavaQ);
-	TickQueue_Clear(&physics_waterQ);
+	Physics_InitRegions();
+	Physics_CountSections();
 
 	physics_maxWaterX = World_MaxX - 2;
 	physics_maxWaterY = World_MaxY - 2;
@@ -148,10 +346,11 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	PhysicsHandler handler;
 	int index;
 	if (!Physics_Enabled) return;
+	Physics_TrackBlock(x, y, z, old, now);
 
 	if (now == BLOCK_AIR && Physics_IsEdgeWater(x, y, z)) {
 		now = BLOCK_STILL_WATER;
-		Game_UpdateBlock(x, y, z, BLOCK_STILL_WATER);
+		Physics_UpdateBlock(x, y, z, BLOCK_STILL_WATER);
 	}
 	index = World_Pack(x, y, z);
 
@@ -165,37 +364,31 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	Physics_ActivateNeighbours(x, y, z, index);
 }
 
+/* Performs 3 random ticks in each section of the world that has random tickable blocks */
 static void Physics_TickRandomBlocks(void) {
-	int lo, hi, index;
+	int i, r, index, section = 0;
 	BlockID block;
 	PhysicsHandler tick;
-	int x, y, z, x2, y2, z2;
+	int x, y, z, xx, yy, zz;
+	if (!physics_sectionTicks) return;
 
 	for (y = 0; y < World_Height; y += CHUNK_SIZE) {
-		y2 = min(y + CHUNK_MAX, World_MaxY);
 		for (z = 0; z < World_Length; z += CHUNK_SIZE) {
-			z2 = min(z + CHUNK_MAX, World_MaxZ);
-			for (x = 0; x < World_Width; x += CHUNK_SIZE) {
-				x2 = min(x + CHUNK_MAX, World_MaxX);
-
-				/* Inlined 3 random ticks for this chunk */
-				lo = World_Pack( x,  y,  z);
-				hi = World_Pack(x2, y2, z2);
-				
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World_Blocks[index];
-				tick = Physics_OnRandomTick[block];
-				if (tick) tick(index, block);
+			for (x = 0; x < World_Width; x += CHUNK_SIZE, section++) {
+				if (!physics_sectionTicks[section]) continue;
 
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World_Blocks[index];
-				tick = Physics_OnRandomTick[block];
-				if (tick) tick(index, block);
+				for (i = 0; i < 3; i++) {
+					r  = Random_Next(&physics_rnd, CHUNK_SIZE_3);
+					xx = x + (r & CHUNK_MASK);
+					zz = z + ((r >> CHUNK_SHIFT) & CHUNK_MASK);
+					yy = y + (r >> (CHUNK_SHIFT * 2));
+					if (xx >= World_Width || yy >= World_Height || zz >= World_Length) continue;
 
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World_Blocks[index];
-				tick = Physics_OnRandomTick[block];
-				if (tick) tick(index, block);
+					index = World_Pack(xx, yy, zz);
+					block = World_Blocks[index];
+					tick  = Physics_OnRandomTick[block];
+					if (tick) tick(index, block);
+				}
 			}
 		}
 	}
@@ -220,26 +413,13 @@ static void Physics_DoFalling(int index, BlockID block) {
 
 	if (found == -1) return;
 	World_Unpack(found, x, y, z);
-	Game_UpdateBlock(x, y, z, block);
+	Physics_UpdateBlock(x, y, z, block);
 
 	World_Unpack(start, x, y, z);
-	Game_UpdateBlock(x, y, z, BLOCK_AIR);
+	Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
-static bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
-	uint32_t item = TickQueue_Dequeue(queue);
-	*posIndex     = (int)(item & PHYSICS_POS_MASK);
-
-	if (item >= PHYSICS_ONE_DELAY) {
-		item -= PHYSICS_ONE_DELAY;
-		TickQueue_Enqueue(queue, item);
-		return false;
-	}
-	return true;
-}
-
-
 static void Physics_HandleSapling(int index, BlockID block) {
 	Vector3I coords[TREE_MAX_COUNT];
 	BlockRaw blocks[TREE_MAX_COUNT];
@@ -254,16 +434,16 @@ static void Physics_HandleSapling(int index, BlockID block) {
 	if (below != BLOCK_GRASS) return;
 
 	height = 5 + Random_Next(&physics_rnd, 3);
-	Game_UpdateBlock(x, y, z, BLOCK_AIR);
+	Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 
 	if (TreeGen_CanGrow(x, y, z, height)) {	
 		count = TreeGen_Grow(x, y, z, height, coords, blocks);
 
 		for (i = 0; i < count; i++) {
-			Game_UpdateBlock(coords[i].X, coords[i].Y, coords[i].Z, blocks[i]);
+			Physics_UpdateBlock(coords[i].X, coords[i].Y, coords[i].Z, blocks[i]);
 		}
 	} else {
-		Game_UpdateBlock(x, y, z, BLOCK_SAPLING);
+		Physics_UpdateBlock(x, y, z, BLOCK_SAPLING);
 	}
 }
 
@@ -272,7 +452,7 @@ static void Physics_HandleDirt(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	if (Lighting_IsLit(x, y, z)) {
-		Game_UpdateBlock(x, y, z, BLOCK_GRASS);
+		Physics_UpdateBlock(x, y, z, BLOCK_GRASS);
 	}
 }
 
@@ -281,7 +461,7 @@ static void Physics_HandleGrass(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	if (!Lighting_IsLit(x, y, z)) {
-		Game_UpdateBlock(x, y, z, BLOCK_DIRT);
+		Physics_UpdateBlock(x, y, z, BLOCK_DIRT);
 	}
 }
 
@@ -291,7 +471,7 @@ static void Physics_HandleFlower(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	if (!Lighting_IsLit(x, y, z)) {
-		Game_UpdateBlock(x, y, z, BLOCK_AIR);
+		Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
 		return;
 	}
@@ -299,7 +479,7 @@ static void Physics_HandleFlower(int index, BlockID block) {
 	below = BLOCK_DIRT;
 	if (y > 0) below = World_Blocks[index - World_OneY];
 	if (!(below == BLOCK_DIRT || below == BLOCK_GRASS)) {
-		Game_UpdateBlock(x, y, z, BLOCK_AIR);
+		Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
 	}
 }
@@ -310,7 +490,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	if (Lighting_IsLit(x, y, z)) {
-		Game_UpdateBlock(x, y, z, BLOCK_AIR);
+		Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
 		return;
 	}
@@ -318,62 +498,261 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 	below = BLOCK_STONE;
 	if (y > 0) below = World_Blocks[index - World_OneY];
 	if (!(below == BLOCK_STONE || below == BLOCK_COBBLE)) {
-		Game_UpdateBlock(x, y, z, BLOCK_AIR);
+		Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
 	}
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Liquid regions------------------------------------------------------*
+*#########################################################################################################################*/
+/* Liquids are simulated separately in regions, which are slabs of the world along the X axis. */
+/* While ticking, a region only ever changes blocks inside itself, so regions can be ticked in parallel. */
+/* Liquid spreading into a neighbouring region is put in the outbox instead, which is processed */
+/*  on the main thread in region order afterwards, so the result never depends on thread timing. */
+#define PHYSICS_MAX_REGIONS 8
+/* Regions are only ticked on separate threads when at least this many liquid entries are queued */
+#define PHYSICS_PARALLEL_THRESHOLD 512
+
+struct LiquidChange { int Index; BlockID Old, New; };
+struct LiquidRegion {
+	struct TickWheel LavaTicks, WaterTicks;
+	struct TickQueue Outbox;      /* Positions in neighbouring regions that liquid spread into */
+	struct LiquidChange* Changes; /* Blocks changed by liquids in this region during current tick */
+	uint32_t ChangesCount, ChangesCapacity;
+	int MinX, MaxX;
+	void* StartWaitable; /* Signalled by main thread when the worker should tick this region */
+	void* DoneWaitable;  /* Signalled by the worker when it has finished ticking this region */
+};
+typedef void (*LiquidTicker)(struct LiquidRegion* region);
+
+static struct LiquidRegion physics_regions[PHYSICS_MAX_REGIONS];
+static int physics_regionsCount, physics_regionWidth;
+static void* physics_workers[PHYSICS_MAX_REGIONS];
+static int physics_workersCount;
+static volatile bool physics_terminate;
+static LiquidTicker physics_curTicker;
+/* Whether liquids spreading across region borders are being handled, on the main thread only */
+static bool physics_exchanging;
+
+#define Physics_RegionAt(x) (&physics_regions[(x) / physics_regionWidth])
+
+static void Physics_FreeRegions(void) {
+	struct LiquidRegion* r;
+	int i;
+
+	for (i = 0; i < PHYSICS_MAX_REGIONS; i++) {
+		r = &physics_regions[i];
+		TickWheel_Clear(&r->LavaTicks);
+		TickWheel_Clear(&r->WaterTicks);
+		TickQueue_Clear(&r->Outbox);
+
+		Mem_Free(r->Changes);
+		r->Changes = NULL;
+		r->ChangesCount = 0; r->ChangesCapacity = 0;
+	}
+}
+
+/* Splits the world into regions, whose widths are multiples of 16 so that they never share a section */
+static void Physics_InitRegions(void) {
+	struct LiquidRegion* r;
+	int i, sections, perRegion, maxRegions;
+
+	Physics_FreeRegions();
+	maxRegions = Options_GetInt(OPT_PHYSICS_WORKERS, 1, PHYSICS_MAX_REGIONS, 4);
+	sections   = (World_Width + CHUNK_MAX) >> CHUNK_SHIFT;
+	if (!sections) sections = 1;
+
+	perRegion = (sections + maxRegions - 1) / maxRegions;
+	physics_regionWidth  = perRegion << CHUNK_SHIFT;
+	physics_regionsCount = (sections + perRegion - 1) / perRegion;
+
+	for (i = 0; i < physics_regionsCount; i++) {
+		r = &physics_regions[i];
+		r->MinX = i * physics_regionWidth;
+		r->MaxX = r->MinX + physics_regionWidth - 1;
+	}
+}
+
+/* Changes a block in the world on behalf of a liquid. If a region is given, the change is only recorded */
+/*  in the world for now, with lighting and rendering being updated later by Physics_ApplyChanges */
+static void Physics_SetLiquidBlock(struct LiquidRegion* r, int index, int x, int y, int z, BlockID block) {
+	struct LiquidChange* change;
+	if (!r) { Physics_UpdateBlock(x, y, z, block); return; }
+
+	if (r->ChangesCount == r->ChangesCapacity) {
+		r->Changes = Utils_Resize(r->Changes, &r->ChangesCapacity, 
+								sizeof(struct LiquidChange), 0, 512);
+	}
+	change = &r->Changes[r->ChangesCount++];
+	change->Index = index;
+	change->Old   = World_GetBlock(x, y, z);
+	change->New   = block;
+
+	Physics_TrackBlock(x, y, z, change->Old, block);
+	/* Not World_SetBlock, as solid bits for different regions can share the same word. */
+	/* (Physics_ApplyChanges later changes the block through World_SetBlock on the main thread) */
+	World_Blocks[index] = (BlockRaw)block;
+#ifdef EXTENDED_BLOCKS
+	if (World_Blocks != World_Blocks2) World_Blocks2[index] = (BlockRaw)(block >> 8);
+#endif
+}
+
+/* Updates lighting and rendering for all the blocks that liquids changed this tick */
+static void Physics_ApplyChanges(void) {
+	struct LiquidRegion* r;
+	struct LiquidChange* change;
+	int i, j, x, y, z;
+
+	/* Lighting expects to see the world as it was just before each change, */
+	/*  so undo all the changes, then properly redo them one by one */
+	for (i = physics_regionsCount - 1; i >= 0; i--) {
+		r = &physics_regions[i];
+		for (j = (int)r->ChangesCount - 1; j >= 0; j--) {
+			change = &r->Changes[j];
+			World_Unpack(change->Index, x, y, z);
+			World_SetBlock(x, y, z, change->Old);
+		}
+	}
+
+	for (i = 0; i < physics_regionsCount; i++) {
+		r = &physics_regions[i];
+		for (j = 0; j < (int)r->ChangesCount; j++) {
+			change = &r->Changes[j];
+			World_Unpack(change->Index, x, y, z);
+			Game_UpdateBlock(x, y, z, change->New);
+		}
+		r->ChangesCount = 0;
+	}
+}
+
+static void Physics_WorkerLoop(void* arg) {
+	struct LiquidRegion* r = (struct LiquidRegion*)arg;
+	for (;;) {
+		Waitable_Wait(r->StartWaitable);
+		if (physics_terminate) return;
+
+		physics_curTicker(r);
+		Waitable_Signal(r->DoneWaitable);
+	}
+}
+
+/* Starts worker threads for any regions that do not have one yet */
+/* NOTE: Region 0 is always ticked on the main thread */
+static void Physics_StartWorkers(void) {
+	int i;
+	if (!physics_workersCount) physics_terminate = false;
+
+	for (i = physics_workersCount + 1; i < physics_regionsCount; i++) {
+		physics_regions[i].StartWaitable = Waitable_Create();
+		physics_regions[i].DoneWaitable  = Waitable_Create();
+		physics_workers[i] = Thread_StartArg(Physics_WorkerLoop, &physics_regions[i], false);
+		physics_workersCount++;
+	}
+}
+
+static void Physics_StopWorkers(void) {
+	int i;
+	if (!physics_workersCount) return;
+	physics_terminate = true;
+
+	for (i = 1; i <= physics_workersCount; i++) {
+		Waitable_Signal(physics_regions[i].StartWaitable);
+		Thread_Join(physics_workers[i]);
+	}
+	for (i = 1; i <= physics_workersCount; i++) {
+		Waitable_Free(physics_regions[i].StartWaitable);
+		Waitable_Free(physics_regions[i].DoneWaitable);
+	}
+
+	physics_workersCount = 0;
+}
+
+static void Physics_TickRegions(LiquidTicker ticker, int queued) {
+	int i;
+	if (queued < PHYSICS_PARALLEL_THRESHOLD || physics_regionsCount == 1) {
+		for (i = 0; i < physics_regionsCount; i++) { ticker(&physics_regions[i]); }
+		return;
+	}
+
+	Physics_StartWorkers();
+	physics_curTicker = ticker;
+	for (i = 1; i < physics_regionsCount; i++) {
+		Waitable_Signal(physics_regions[i].StartWaitable);
+	}
+
+	ticker(&physics_regions[0]);
+	for (i = 1; i < physics_regionsCount; i++) {
+		Waitable_Wait(physics_regions[i].DoneWaitable);
+	}
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Liquids---------------------------------------------------------*
+*#########################################################################################################################*/
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&physics_lavaQ, PHYSICS_LAVA_DELAY | index);
+	int x = index % World_Width;
+	TickWheel_Schedule(&Physics_RegionAt(x)->LavaTicks, index, PHYSICS_LAVA_DELAY);
 }
 
-static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
-	BlockID block = World_Blocks[posIndex];
+static void Physics_PropagateLava(struct LiquidRegion* r, int posIndex, int x, int y, int z) {
+	BlockID block;
+	if (r && (x < r->MinX || x > r->MaxX)) {
+		TickQueue_Enqueue(&r->Outbox, posIndex); return;
+	}
+
+	block = World_Blocks[posIndex];
 	if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-		Game_UpdateBlock(x, y, z, BLOCK_STONE);
+		Physics_SetLiquidBlock(r, posIndex, x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_GAS) {
-		TickQueue_Enqueue(&physics_lavaQ, PHYSICS_LAVA_DELAY | posIndex);
-		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
+		TickWheel_Schedule(&Physics_RegionAt(x)->LavaTicks, posIndex, PHYSICS_LAVA_DELAY);
+		Physics_SetLiquidBlock(r, posIndex, x, y, z, BLOCK_LAVA);
 	}
 }
 
-static void Physics_ActivateLava(int index, BlockID block) {
+static void Physics_SpreadLava(struct LiquidRegion* r, int index) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateLava(index - 1, x - 1, y, z);
-	if (x < World_MaxX) Physics_PropagateLava(index + 1, x + 1, y, z);
-	if (z > 0)          Physics_PropagateLava(index - World_Width, x, y, z - 1);
-	if (z < World_MaxZ) Physics_PropagateLava(index + World_Width, x, y, z + 1);
-	if (y > 0)          Physics_PropagateLava(index - World_OneY, x, y - 1, z);
-}
-
-static void Physics_TickLava(void) {
-	int i, count = physics_lavaQ.Size;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&physics_lavaQ, &index)) {
-			BlockID block = World_Blocks[index];
-			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
-			Physics_ActivateLava(index, block);
-		}
+	if (x > 0)          Physics_PropagateLava(r, index - 1, x - 1, y, z);
+	if (x < World_MaxX) Physics_PropagateLava(r, index + 1, x + 1, y, z);
+	if (z > 0)          Physics_PropagateLava(r, index - World_Width, x, y, z - 1);
+	if (z < World_MaxZ) Physics_PropagateLava(r, index + World_Width, x, y, z + 1);
+	if (y > 0)          Physics_PropagateLava(r, index - World_OneY, x, y - 1, z);
+}
+
+static void Physics_ActivateLava(int index, BlockID block) { Physics_SpreadLava(NULL, index); }
+
+static void Physics_TickLavaRegion(struct LiquidRegion* r) {
+	while (r->LavaTicks.DueCount) {
+		int index = TickWheel_NextDue(&r->LavaTicks);
+		BlockID block = World_Blocks[index];
+		if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+		Physics_SpreadLava(r, index);
 	}
 }
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&physics_waterQ, PHYSICS_WATER_DELAY | index);
+	int x = index % World_Width;
+	TickWheel_Schedule(&Physics_RegionAt(x)->WaterTicks, index, PHYSICS_WATER_DELAY);
 }
 
-static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World_Blocks[posIndex];
+static void Physics_PropagateWater(struct LiquidRegion* r, int posIndex, int x, int y, int z) {
+	BlockID block;
 	int xx, yy, zz;
+	/* Sponge check reads blocks up to 2 away, so blocks that near another region are left for the serial */
+	/*  border exchange, rather than reading blocks that another region's worker may be changing */
+	if (r && !physics_exchanging && ((r->MinX && x < r->MinX + 2) || (r->MaxX < World_MaxX && x > r->MaxX - 2))) {
+		TickQueue_Enqueue(&r->Outbox, posIndex); return;
+	}
 
+	block = World_Blocks[posIndex];
 	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
-		Game_UpdateBlock(x, y, z, BLOCK_STONE);
+		Physics_SetLiquidBlock(r, posIndex, x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_GAS && block != BLOCK_ROPE) {
-		/* Sponge check */		
 		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World_MaxY : y + 2); yy++) {
 			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World_MaxZ : z + 2); zz++) {
 				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World_MaxX : x + 2); xx++) {
@@ -383,32 +762,68 @@ static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
 			}
 		}
 
-		TickQueue_Enqueue(&physics_waterQ, PHYSICS_WATER_DELAY | posIndex);
-		Game_UpdateBlock(x, y, z, BLOCK_WATER);
+		TickWheel_Schedule(&Physics_RegionAt(x)->WaterTicks, posIndex, PHYSICS_WATER_DELAY);
+		Physics_SetLiquidBlock(r, posIndex, x, y, z, BLOCK_WATER);
 	}
 }
 
-static void Physics_ActivateWater(int index, BlockID block) {
+static void Physics_SpreadWater(struct LiquidRegion* r, int index) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z);
-	if (x < World_MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z);
-	if (z > 0)          Physics_PropagateWater(index - World_Width, x,     y,     z - 1);
-	if (z < World_MaxZ) Physics_PropagateWater(index + World_Width, x,     y,     z + 1);
-	if (y > 0)          Physics_PropagateWater(index - World_OneY,  x,     y - 1, z);
-}
-
-static void Physics_TickWater(void) {
-	int i, count = physics_waterQ.Size;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&physics_waterQ, &index)) {
-			BlockID block = World_Blocks[index];
-			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
+	if (x > 0)          Physics_PropagateWater(r, index - 1,           x - 1, y,     z);
+	if (x < World_MaxX) Physics_PropagateWater(r, index + 1,           x + 1, y,     z);
+	if (z > 0)          Physics_PropagateWater(r, index - World_Width, x,     y,     z - 1);
+	if (z < World_MaxZ) Physics_PropagateWater(r, index + World_Width, x,     y,     z + 1);
+	if (y > 0)          Physics_PropagateWater(r, index - World_OneY,  x,     y - 1, z);
+}
+
+static void Physics_ActivateWater(int index, BlockID block) { Physics_SpreadWater(NULL, index); }
+
+static void Physics_TickWaterRegion(struct LiquidRegion* r) {
+	while (r->WaterTicks.DueCount) {
+		int index = TickWheel_NextDue(&r->WaterTicks);
+		BlockID block = World_Blocks[index];
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+		Physics_SpreadWater(r, index);
+	}
+}
+
+static void Physics_TickLiquid(bool lava) {
+	struct LiquidRegion* r;
+	struct TickWheel* ticks;
+	int i, index, queued = 0;
+	int x, y, z;
+
+	for (i = 0; i < physics_regionsCount; i++) {
+		ticks = lava ? &physics_regions[i].LavaTicks : &physics_regions[i].WaterTicks;
+		TickWheel_Advance(ticks);
+		queued += ticks->DueCount;
+	}
+	if (!queued) return;
+	Physics_TickRegions(lava ? Physics_TickLavaRegion : Physics_TickWaterRegion, queued);
+
+	/* Exchange liquid spreading across region borders */
+	physics_exchanging = true;
+	for (i = 0; i < physics_regionsCount; i++) {
+		r = &physics_regions[i];
+		while (r->Outbox.Size) {
+			index = TickQueue_Dequeue(&r->Outbox);
+			World_Unpack(index, x, y, z);
+
+			if (lava) {
+				Physics_PropagateLava(Physics_RegionAt(x), index, x, y, z);
+			} else {
+				Physics_PropagateWater(Physics_RegionAt(x), index, x, y, z);
+			}
 		}
 	}
+	physics_exchanging = false;
+	Physics_ApplyChanges();
+
+	if (!tickQueue_overflowed) return;
+	Chat_AddRaw("&cToo many physics entries, clearing");
+	tickQueue_overflowed = false;
 }
 
 
@@ -423,7 +838,7 @@ static void Physics_PlaceSponge(int index, BlockID block) {
 
 				block = World_GetBlock(xx, yy, zz);
 				if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-					Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
+					Physics_UpdateBlock(xx, yy, zz, BLOCK_AIR);
 				}
 			}
 		}
@@ -443,7 +858,7 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					index = World_Pack(xx, yy, zz);
 					block = World_Blocks[index];
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&physics_waterQ, index | PHYSICS_ONE_DELAY);
+						TickWheel_Schedule(&Physics_RegionAt(xx)->WaterTicks, index, 1);
 					}
 				}
 			}
@@ -458,8 +873,8 @@ static void Physics_HandleSlab(int index, BlockID block) {
 	if (index < World_OneY) return;
 
 	if (World_Blocks[index - World_OneY] != BLOCK_SLAB) return;
-	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
-	Game_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
+	Physics_UpdateBlock(x, y,     z, BLOCK_AIR);
+	Physics_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
 }
 
 static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
@@ -468,8 +883,8 @@ static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
 	if (index < World_OneY) return;
 
 	if (World_Blocks[index - World_OneY] != BLOCK_COBBLE_SLAB) return;
-	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
-	Game_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
+	Physics_UpdateBlock(x, y,     z, BLOCK_AIR);
+	Physics_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
 }
 
 
@@ -485,7 +900,7 @@ static void Physics_Explode(int x, int y, int z, int power) {
 	BlockID block;
 	int dx, dy, dz, xx, yy, zz;
 
-	Game_UpdateBlock(x, y, z, BLOCK_AIR);
+	Physics_UpdateBlock(x, y, z, BLOCK_AIR);
 	Physics_ActivateNeighbours(x, y, z, index);
 	
 	for (dy = -power; dy <= power; dy++) {
@@ -500,7 +915,7 @@ static void Physics_Explode(int x, int y, int z, int power) {
 				block = World_Blocks[index];
 				if (block < BLOCK_CPE_COUNT && physics_blocksTnt[block]) continue;
 
-				Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
+				Physics_UpdateBlock(xx, yy, zz, BLOCK_AIR);
 				Physics_ActivateNeighbours(xx, yy, zz, index);
 			}
 		}
@@ -514,10 +929,10 @@ static void Physics_HandleTnt(int index, BlockID block) {
 }
 
 void Physics_Init(void) {
+	Event_RegisterVoid(&WorldEvents.NewMap,       NULL, Physics_OnNewMap);
 	Event_RegisterVoid(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
 	Physics_Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
-	TickQueue_Init(&physics_lavaQ);
-	TickQueue_Init(&physics_waterQ);
+	Physics_InitRegions();
 
 	Physics_OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics_OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -557,15 +972,19 @@ void Physics_Init(void) {
 }
 
 void Physics_Free(void) {
+	Event_UnregisterVoid(&WorldEvents.NewMap,       NULL, Physics_OnNewMap);
 	Event_UnregisterVoid(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Physics_FreeSections();
+	Physics_StopWorkers();
+	Physics_FreeRegions();
 }
 
 void Physics_Tick(void) {
 	if (!Physics_Enabled || !World_Blocks) return;
 
 	/*if ((tickCount % 5) == 0) {*/
-	Physics_TickLava();
-	Physics_TickWater();
+	Physics_TickLiquid(true);
+	Physics_TickLiquid(false);
 	/*}*/
 	physics_tickCount++;
 	Physics_TickRandomBlocks();
@@ -14,6 +14,14 @@
 #include "Block.h"
 #include "EnvRenderer.h"
 #include "GameStructs.h"
+#include "ExtMath.h"
+#include "Particle.h"
+#include "MapGenerator.h"
+#include "Vorbis.h"
+#include "Errors.h"
+#include "Bitmap.h"
+#include "Deflate.h"
+#include "Http.h"
 
 static char msgs[10][STRING_SIZE];
 String Chat_Status[3]       = { String_FromArray(msgs[0]), String_FromArray(msgs[1]), String_FromArray(msgs[2]) };
@@ -550,6 +558,578 @@ static struct ChatCommand TeleportCommand = {
 };
 
 
+#ifdef CC_BUILD_DEVCOMMANDS
+/*########################################################################################################################*
+*---------------------------------------------------CollisionBenchCommand-------------------------------------------------*
+*#########################################################################################################################*/
+#define COLLBENCH_ENTITIES 256
+static int CollisionBenchCommand_Run(struct Entity* entities, bool useCache, int iterations) {
+	struct AABB bb, extentBB;
+	uint64_t beg, end;
+	int i, j;
+
+	beg = Stopwatch_Measure();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < COLLBENCH_ENTITIES; j++) {
+			if (useCache) {
+				Entity_GetBounds(&entities[j], &bb);
+				bb.Min.X -= 2.0f; bb.Min.Y -= 2.0f; bb.Min.Z -= 2.0f;
+				bb.Max.X += 2.0f; bb.Max.Y += 2.0f; bb.Max.Z += 2.0f;
+				CollisionCache_Build(&bb);
+			}
+
+			Searcher_FindReachableBlocks(&entities[j], &bb, &extentBB);
+			Entity_TouchesAnyWater(&entities[j]);
+			Entity_TouchesAnyLava(&entities[j]);
+			Entity_TouchesAnyRope(&entities[j]);
+			CollisionCache_Clear();
+		}
+	}
+	end = Stopwatch_Measure();
+	return Stopwatch_ElapsedMicroseconds(beg, end);
+}
+
+static void CollisionBenchCommand_Execute(const String* args, int argsCount) {
+	struct Entity* entities;
+	RNGState rnd;
+	int i, iterations = 100, uncached, cached;
+
+	if (argsCount && (!Convert_ParseInt(&args[0], &iterations) || iterations <= 0)) {
+		Chat_AddRaw("&e/client collbench: &cNumber of iterations must be a positive integer");
+		return;
+	}
+
+	/* Scatter copies of the player through the lower half of the map, which is usually dense terrain */
+	entities = Mem_Alloc(COLLBENCH_ENTITIES, sizeof(struct Entity), "benchmark entities");
+	Random_Init(&rnd, 1234);
+	for (i = 0; i < COLLBENCH_ENTITIES; i++) {
+		entities[i] = LocalPlayer_Instance.Base;
+		entities[i].Position.X = Random_Float(&rnd) * World_Width;
+		entities[i].Position.Y = Random_Float(&rnd) * World_Height * 0.5f;
+		entities[i].Position.Z = Random_Float(&rnd) * World_Length;
+
+		entities[i].Velocity.X = Random_Float(&rnd) - 0.5f;
+		entities[i].Velocity.Y = Random_Float(&rnd) - 0.5f;
+		entities[i].Velocity.Z = Random_Float(&rnd) - 0.5f;
+	}
+
+	uncached = CollisionBenchCommand_Run(entities, false, iterations) / 1000;
+	cached   = CollisionBenchCommand_Run(entities, true,  iterations) / 1000;
+	Mem_Free(entities);
+	Chat_Add3("&e%i iterations: %i ms without collision cache, %i ms with", &iterations, &uncached, &cached);
+}
+
+static struct ChatCommand CollisionBenchCommand = {
+	"CollBench", CollisionBenchCommand_Execute, false,
+	{
+		"&a/client collbench [iterations]",
+		"&eMeasures how long collision queries take for 256 entities",
+		"&e  spread through the map, with and without the collision cache.",
+		"&eIf no number of iterations is given, 100 iterations are run.",
+	}
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------EntityLodCommand----------------------------------------------------*
+*#########################################################################################################################*/
+static void EntityLodCommand_Execute(const String* args, int argsCount) {
+	int nearCount, mediumCount, farCount, hiddenCount;
+	int nearBlocks, mediumBlocks;
+	float nearDist, mediumDist;
+
+	if (argsCount == 2) {
+		if (!Convert_ParseFloat(&args[0], &nearDist) || !Convert_ParseFloat(&args[1], &mediumDist)
+			|| nearDist < 0.0f || mediumDist < nearDist) {
+			Chat_AddRaw("&e/client entitylod: &cDistances must be numbers, with near <= medium");
+			return;
+		}
+
+		Entities.LodNearDist   = nearDist;
+		Entities.LodMediumDist = mediumDist;
+		Options_Set(OPT_ENTITY_LOD_NEAR,   &args[0]);
+		Options_Set(OPT_ENTITY_LOD_MEDIUM, &args[1]);
+	} else if (argsCount) {
+		Chat_AddRaw("&e/client entitylod: &cEither no distances or both distances must be given");
+		return;
+	}
+
+	nearCount   = Entities.LodCounts[ENTITY_LOD_NEAR];
+	mediumCount = Entities.LodCounts[ENTITY_LOD_MEDIUM];
+	farCount    = Entities.LodCounts[ENTITY_LOD_FAR];
+	hiddenCount = Entities.LodCounts[ENTITY_LOD_HIDDEN];
+	Chat_Add4("&eEntities: %i near, %i medium, %i far, %i hidden",
+		&nearCount, &mediumCount, &farCount, &hiddenCount);
+
+	nearBlocks = (int)Entities.LodNearDist; mediumBlocks = (int)Entities.LodMediumDist;
+	Chat_Add2("&eNear is within %i blocks, medium within %i blocks", &nearBlocks, &mediumBlocks);
+}
+
+static struct ChatCommand EntityLodCommand = {
+	"EntityLod", EntityLodCommand_Execute, false,
+	{
+		"&a/client entitylod [near medium]",
+		"&eShows how many entities are in each level of detail tier.",
+		"&eIf distances are given, changes the maximum distance of entities",
+		"&e  in the near and medium tiers. Medium and far entities animate",
+		"&e  less often, and far entities have no limb animation or shadow.",
+	}
+};
+
+
+/*########################################################################################################################*
+*---------------------------------------------------ParticleBenchCommand--------------------------------------------------*
+*#########################################################################################################################*/
+#define PARTICLEBENCH_TICKS 100
+static void ParticleBenchCommand_Execute(const String* args, int argsCount) {
+	struct ScheduledTask task = { 0 };
+	struct LocalPlayer* p = &LocalPlayer_Instance;
+	Vector3I coords;
+	RNGState rnd;
+	uint64_t beg, end;
+	int i, alive, count = 10000, elapsed = 0, total = 0, average;
+
+	if (argsCount && (!Convert_ParseInt(&args[0], &count) || count <= 0)) {
+		Chat_AddRaw("&e/client particlebench: &cNumber of particles must be a positive integer");
+		return;
+	}
+
+	Random_Init(&rnd, 1234);
+	task.Interval = GAME_DEF_TICKS;
+
+	for (i = 0; i < PARTICLEBENCH_TICKS; i++) {
+		/* Top up particles that died last tick, by pretending blocks around the player were broken */
+		/* Pool replaces old particles once full, so stop when count no longer grows */
+		for (alive = -1; Particles_Count() < count && Particles_Count() != alive;) {
+			alive    = Particles_Count();
+			coords.X = (int)p->Base.Position.X + Random_Range(&rnd, -16, 16);
+			coords.Y = (int)p->Base.Position.Y + Random_Range(&rnd, -8, 8);
+			coords.Z = (int)p->Base.Position.Z + Random_Range(&rnd, -16, 16);
+			Particles_BreakBlockEffect(coords, BLOCK_STONE, BLOCK_AIR);
+		}
+
+		total += Particles_Count();
+		beg = Stopwatch_Measure();
+		Particles_Tick(&task);
+		end = Stopwatch_Measure();
+		elapsed += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+
+	i = PARTICLEBENCH_TICKS; average = total / PARTICLEBENCH_TICKS;
+	Chat_Add3("&e%i ticks of %i particles took %i microseconds", &i, &average, &elapsed);
+}
+
+static struct ChatCommand ParticleBenchCommand = {
+	"ParticleBench", ParticleBenchCommand_Execute, false,
+	{
+		"&a/client particlebench [particles]",
+		"&eMeasures how long 100 particle ticks take, with the given number",
+		"&e  of block break particles scattered around you.",
+		"&eIf no number of particles is given, 10000 particles are used.",
+	}
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------NoiseBenchCommand---------------------------------------------------*
+*#########################################################################################################################*/
+enum NoiseBenchType { NOISEBENCH_IMPROVED, NOISEBENCH_OCTAVE, NOISEBENCH_COMBINED };
+static struct CombinedNoise noiseBench_noise;
+
+/* Returns thousands of samples evaluated per second */
+static int NoiseBenchCommand_Run(int type, bool batched, float* xs, float* ys, float* out, int count) {
+	struct OctaveNoise* octave = &noiseBench_noise.noise1;
+	uint64_t beg, end;
+	int i, elapsed;
+
+	beg = Stopwatch_Measure();
+	if (batched) {
+		if (type == NOISEBENCH_IMPROVED) {
+			for (i = 0; i < count; i++) { out[i] = 0.0f; }
+			ImprovedNoise_CalcBatch(octave->p[0], xs, ys, 1.0f, 1.0f, out, count);
+		} else if (type == NOISEBENCH_OCTAVE) {
+			OctaveNoise_CalcBatch(octave, xs, ys, out, count);
+		} else {
+			CombinedNoise_CalcBatch(&noiseBench_noise, xs, ys, out, count);
+		}
+	} else {
+		for (i = 0; i < count; i++) {
+			if (type == NOISEBENCH_IMPROVED) {
+				out[i] = ImprovedNoise_Calc(octave->p[0], xs[i], ys[i]);
+			} else if (type == NOISEBENCH_OCTAVE) {
+				out[i] = OctaveNoise_Calc(octave, xs[i], ys[i]);
+			} else {
+				out[i] = CombinedNoise_Calc(&noiseBench_noise, xs[i], ys[i]);
+			}
+		}
+	}
+	end = Stopwatch_Measure();
+
+	elapsed = max(Stopwatch_ElapsedMicroseconds(beg, end), 1);
+	return (int)((uint64_t)count * 1000 / elapsed);
+}
+
+static void NoiseBenchCommand_Execute(const String* args, int argsCount) {
+	static const char* names[3] = { "&eImproved", "&eOctave", "&eCombined" };
+	float* xs; float* ys; float* out;
+	RNGState rnd;
+	int i, count = 250000, scalar, batched;
+
+	if (argsCount && (!Convert_ParseInt(&args[0], &count) || count <= 0)) {
+		Chat_AddRaw("&e/client noisebench: &cNumber of samples must be a positive integer");
+		return;
+	}
+
+	/* Sample along rows, as the map generator does */
+	xs = Mem_Alloc(count, sizeof(float), "noise bench xs");
+	ys = Mem_Alloc(count, sizeof(float), "noise bench ys");
+	out = Mem_Alloc(count, sizeof(float), "noise bench out");
+	Random_Init(&rnd, 1234);
+	CombinedNoise_Init(&noiseBench_noise, &rnd, 8, 8);
+
+	for (i = 0; i < count; i++) {
+		xs[i] = (float)(i % 256) * 1.3f;
+		ys[i] = (float)(i / 256) * 1.3f;
+	}
+
+	for (i = NOISEBENCH_IMPROVED; i <= NOISEBENCH_COMBINED; i++) {
+		scalar  = NoiseBenchCommand_Run(i, false, xs, ys, out, count);
+		batched = NoiseBenchCommand_Run(i, true,  xs, ys, out, count);
+		Chat_Add3("%c: %i thousand samples/sec, %i thousand batched", names[i], &scalar, &batched);
+	}
+
+	Mem_Free(xs);
+	Mem_Free(ys);
+	Mem_Free(out);
+}
+
+static struct ChatCommand NoiseBenchCommand = {
+	"NoiseBench", NoiseBenchCommand_Execute, false,
+	{
+		"&a/client noisebench [samples]",
+		"&eMeasures how many samples of each type of noise used by the map",
+		"&e  generator are calculated per second, one at a time and batched.",
+		"&eIf no number of samples is given, 250000 samples are used.",
+	}
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------FloodBenchCommand---------------------------------------------------*
+*#########################################################################################################################*/
+static void FloodBenchCommand_Execute(const String* args, int argsCount) {
+	struct FloodFill fill;
+	BlockRaw* blocks;
+	uint64_t beg, end;
+	int x, z, y = Env_EdgeHeight - 1;
+	int filled = 0, elapsed;
+
+	if (!World_Blocks || y < 0 || y >= World_Height) {
+		Chat_AddRaw("&e/client floodbench: &cEdge water level must be inside the map");
+		return;
+	}
+
+	/* Flood a copy of the map from its edges at water level, as the map generator does */
+	blocks = Mem_Alloc(World_BlocksSize, 1, "flood bench blocks");
+	Mem_Copy(blocks, World_Blocks, World_BlocksSize);
+	FloodFill_Init(&fill, blocks, World_Width, World_Height, World_Length);
+
+	beg = Stopwatch_Measure();
+	for (x = 0; x < World_Width; x++) {
+		filled += FloodFill_Run(&fill, World_Pack(x, y, 0),          BLOCK_AIR, BLOCK_WATER);
+		filled += FloodFill_Run(&fill, World_Pack(x, y, World_MaxZ), BLOCK_AIR, BLOCK_WATER);
+	}
+	for (z = 0; z < World_Length; z++) {
+		filled += FloodFill_Run(&fill, World_Pack(0, y, z),          BLOCK_AIR, BLOCK_WATER);
+		filled += FloodFill_Run(&fill, World_Pack(World_MaxX, y, z), BLOCK_AIR, BLOCK_WATER);
+	}
+	end = Stopwatch_Measure();
+
+	FloodFill_Free(&fill);
+	Mem_Free(blocks);
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, end) / 1000;
+	Chat_Add2("&eFlooded %i air blocks from the map edges in %i ms", &filled, &elapsed);
+}
+
+static struct ChatCommand FloodBenchCommand = {
+	"FloodBench", FloodBenchCommand_Execute, false,
+	{
+		"&a/client floodbench",
+		"&eMeasures how long flood filling a copy of the map with water",
+		"&e  from its edges at water level takes, like the map generator does.",
+		"&eThe map itself is not changed.",
+	}
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------GenStagesCommand----------------------------------------------------*
+*#########################################################################################################################*/
+static void GenStagesCommand_Execute(const String* args, int argsCount) {
+	struct GenStage* stage;
+	int i, ms, kb;
+
+	for (i = 0; (stage = NotchyGen_GetStage(i)); i++) {
+		ms = stage->Time / 1000;
+		kb = stage->Memory / 1024;
+		Chat_Add3("&e%c: &f%i ms, %i KB", stage->Name, &ms, &kb);
+	}
+}
+
+static struct ChatCommand GenStagesCommand = {
+	"GenStages", GenStagesCommand_Execute, false,
+	{
+		"&a/client genstages",
+		"&eShows how long each stage of the vanilla map generator took,",
+		"&e  and how much memory it allocated, the last time it ran.",
+	}
+};
+
+
+/*########################################################################################################################*
+*----------------------------------------------------VorbisBenchCommand---------------------------------------------------*
+*#########################################################################################################################*/
+struct VorbisBenchTotals { int Files, AudioMs, DecodeMs; };
+
+static void VorbisBenchCommand_Decode(const String* path, void* obj) {
+	const static String ogg = String_FromConst(".ogg");
+	struct VorbisBenchTotals* totals = (struct VorbisBenchTotals*)obj;
+	uint8_t buffer[OGG_BUFFER_SIZE];
+	struct VorbisState ctx = { 0 };
+	struct Stream file, stream;
+	int16_t* data = NULL;
+	uint64_t beg, end, samples = 0;
+	int audioMs, decodeMs, factor;
+	ReturnCode res;
+	String name;
+
+	if (!String_CaselessEnds(path, &ogg)) return;
+	res = Stream_OpenFile(&file, path);
+	if (res) { Logger_Warn2(res, "opening", path); return; }
+
+	Ogg_MakeStream(&stream, buffer, &file);
+	ctx.Source = &stream;
+	beg = Stopwatch_Measure();
+
+	if ((res = Vorbis_DecodeHeaders(&ctx))) goto cleanup;
+	/* a frame outputs at most half of the largest block size samples per channel */
+	data = Mem_Alloc(ctx.BlockSizes[1] * ctx.Channels, 2, "Vorbis bench PCM");
+
+	while (!(res = Vorbis_DecodeFrame(&ctx))) {
+		samples += Vorbis_OutputFrame(&ctx, data);
+	}
+	end = Stopwatch_Measure();
+
+	if (res == ERR_END_OF_STREAM) {
+		res      = 0;
+		audioMs  = (int)(samples / ctx.Channels * 1000 / ctx.SampleRate);
+		decodeMs = max(Stopwatch_ElapsedMicroseconds(beg, end) / 1000, 1);
+		factor   = audioMs / decodeMs;
+
+		name = *path; Utils_UNSAFE_GetFilename(&name);
+		Chat_Add4("&e%s: %i ms of audio decoded in %i ms (%ix real time)",
+			&name, &audioMs, &decodeMs, &factor);
+
+		totals->Files++;
+		totals->AudioMs  += audioMs;
+		totals->DecodeMs += decodeMs;
+	}
+
+cleanup:
+	if (res) Logger_Warn2(res, "decoding", path);
+	Mem_Free(data);
+	Vorbis_Free(&ctx);
+	file.Close(&file);
+}
+
+static void VorbisBenchCommand_Execute(const String* args, int argsCount) {
+	const static String path = String_FromConst("audio");
+	struct VorbisBenchTotals totals = { 0 };
+	int factor;
+
+	if (!Directory_Exists(&path)) {
+		Chat_AddRaw("&e/client vorbisbench: &cNo audio folder to decode music from");
+		return;
+	}
+	Directory_Enum(&path, &totals, VorbisBenchCommand_Decode);
+
+	if (!totals.Files) {
+		Chat_AddRaw("&e/client vorbisbench: &cNo music files could be decoded");
+		return;
+	}
+	factor = totals.AudioMs / max(totals.DecodeMs, 1);
+	Chat_Add4("&e%i files, %i ms of audio decoded in %i ms (%ix real time)",
+		&totals.Files, &totals.AudioMs, &totals.DecodeMs, &factor);
+}
+
+static struct ChatCommand VorbisBenchCommand = {
+	"VorbisBench", VorbisBenchCommand_Execute, false,
+	{
+		"&a/client vorbisbench",
+		"&eDecodes every music file in the audio folder, without playing it,",
+		"&e  and shows how much faster than real time each was decoded.",
+	}
+};
+
+
+/*########################################################################################################################*
+*------------------------------------------------------PngBenchCommand----------------------------------------------------*
+*#########################################################################################################################*/
+struct PngBenchTotals { int Files, Pixels, DecodeUs; };
+
+/* Reads all of the stream's data into memory, so only decoding is measured and not disk access */
+static ReturnCode PngBenchCommand_ReadAll(struct Stream* src, uint8_t** data, uint32_t* length) {
+	uint32_t capacity = 64 * 1024, read;
+	ReturnCode res;
+
+	*data   = Mem_Alloc(capacity, 1, "PNG bench data");
+	*length = 0;
+	for (;;) {
+		if (*length == capacity) {
+			capacity *= 2;
+			*data = Mem_Realloc(*data, capacity, 1, "PNG bench data");
+		}
+
+		res = src->Read(src, *data + *length, capacity - *length, &read);
+		if (res || !read) return res;
+		*length += read;
+	}
+}
+
+static void PngBenchCommand_Decode(const String* name, struct Stream* src, struct PngBenchTotals* totals) {
+	struct Stream stream;
+	uint8_t* data;
+	uint32_t length;
+	uint64_t beg, end;
+	int decodeUs;
+	Bitmap bmp;
+	ReturnCode res;
+
+	res = PngBenchCommand_ReadAll(src, &data, &length);
+	if (res) { Logger_Warn2(res, "reading", name); Mem_Free(data); return; }
+
+	/* same decoding as texture pack images */
+	Stream_ReadonlyMemory(&stream, data, length);
+	beg = Stopwatch_Measure();
+	res = Png_Decode(&bmp, &stream);
+	end = Stopwatch_Measure();
+
+	if (!res) {
+		decodeUs = Stopwatch_ElapsedMicroseconds(beg, end);
+		Chat_Add4("&e%s: %ix%i decoded in %i us",
+			name, &bmp.Width, &bmp.Height, &decodeUs);
+
+		totals->Files++;
+		totals->Pixels   += bmp.Width * bmp.Height;
+		totals->DecodeUs += decodeUs;
+	} else {
+		Logger_Warn2(res, "decoding", name);
+	}
+
+	Mem_Free(bmp.Scan0);
+	Mem_Free(data);
+}
+
+static void PngBenchCommand_DecodeFile(const String* path, void* obj) {
+	const static String png = String_FromConst(".png");
+	struct Stream file;
+	ReturnCode res;
+	String name;
+	if (!String_CaselessEnds(path, &png)) return;
+
+	res = Stream_OpenFile(&file, path);
+	if (res) { Logger_Warn2(res, "opening", path); return; }
+
+	name = *path; Utils_UNSAFE_GetFilename(&name);
+	PngBenchCommand_Decode(&name, &file, (struct PngBenchTotals*)obj);
+	file.Close(&file);
+}
+
+static bool PngBenchCommand_SelectEntry(const String* path) {
+	const static String png = String_FromConst(".png");
+	return String_CaselessEnds(path, &png);
+}
+
+static ReturnCode PngBenchCommand_DecodeEntry(const String* path, struct Stream* data, struct ZipState* state) {
+	String name = *path;
+	Utils_UNSAFE_GetFilename(&name);
+	PngBenchCommand_Decode(&name, data, (struct PngBenchTotals*)state->Obj);
+	return 0;
+}
+
+/* Decodes the .png files in the current texture pack (or the terrain.png, if the map uses one instead) */
+static void PngBenchCommand_DecodePack(struct PngBenchTotals* totals) {
+	const static String zipExt  = String_FromConst(".zip");
+	const static String terrain = String_FromConst("terrain.png");
+	String path; char pathBuffer[FILENAME_SIZE];
+	struct ZipState state;
+	struct Stream stream;
+	ReturnCode res;
+
+	if (World_TextureUrl.length) {
+		path = World_TextureUrl;
+		if (!Http_OpenCached(&path, &stream)) {
+			Chat_AddRaw("&e/client pngbench: &cCurrent texture pack is not cached");
+			return;
+		}
+	} else {
+		String_InitArray(path, pathBuffer);
+		String_AppendConst(&path, "texpacks/");
+		Game_GetDefaultTexturePack(&path);
+
+		res = Stream_OpenFile(&stream, &path);
+		if (res) { Logger_Warn2(res, "opening", &path); return; }
+	}
+
+	if (World_TextureUrl.length && !String_ContainsString(&path, &zipExt)) {
+		PngBenchCommand_Decode(&terrain, &stream, totals);
+	} else {
+		Zip_Init(&state, &stream);
+		state.SelectEntry  = PngBenchCommand_SelectEntry;
+		state.ProcessEntry = PngBenchCommand_DecodeEntry;
+		state.Obj          = totals;
+
+		res = Zip_Extract(&state);
+		if (res) Logger_Warn2(res, "extracting", &path);
+	}
+	stream.Close(&stream);
+}
+
+static void PngBenchCommand_Execute(const String* args, int argsCount) {
+	struct PngBenchTotals totals = { 0 };
+	int decodeMs, rate;
+
+	if (!argsCount) {
+		PngBenchCommand_DecodePack(&totals);
+	} else if (Directory_Exists(&args[0])) {
+		Directory_Enum(&args[0], &totals, PngBenchCommand_DecodeFile);
+	} else {
+		Chat_Add1("&e/client pngbench: &cNo folder named &f%s", &args[0]);
+		return;
+	}
+
+	if (!totals.Files) {
+		Chat_AddRaw("&e/client pngbench: &cNo .png files could be decoded");
+		return;
+	}
+	decodeMs = totals.DecodeUs / 1000;
+	/* pixels per microsecond is the same as megapixels per second */
+	rate     = totals.Pixels / max(totals.DecodeUs, 1);
+	Chat_Add4("&e%i files, %i pixels decoded in %i ms (%i megapixels/s)",
+		&totals.Files, &totals.Pixels, &decodeMs, &rate);
+}
+
+static struct ChatCommand PngBenchCommand = {
+	"PngBench", PngBenchCommand_Execute, false,
+	{
+		"&a/client pngbench [folder]",
+		"&eDecodes every .png file in the current texture pack, or in the",
+		"&e  given folder, and shows how long decoding each one took.",
+	}
+};
+#endif
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Generic chat------------------------------------------------------*
 *#########################################################################################################################*/
@@ -573,6 +1153,16 @@ static void Chat_Init(void) {
 	Commands_Register(&ModelCommand);
 	Commands_Register(&CuboidCommand);
 	Commands_Register(&TeleportCommand);
+#ifdef CC_BUILD_DEVCOMMANDS
+	Commands_Register(&CollisionBenchCommand);
+	Commands_Register(&EntityLodCommand);
+	Commands_Register(&ParticleBenchCommand);
+	Commands_Register(&NoiseBenchCommand);
+	Commands_Register(&FloodBenchCommand);
+	Commands_Register(&GenStagesCommand);
+	Commands_Register(&VorbisBenchCommand);
+	Commands_Register(&PngBenchCommand);
+#endif
 
 	Chat_Logging = Options_GetBool(OPT_CHAT_LOGGING, true);
 }
@@ -79,6 +79,8 @@ typedef struct FontDesc_ { void* Handle; uint16_t Size, Style; } FontDesc;
 typedef struct TextureRec_ { float U1, V1, U2, V2; } TextureRec;
 
 /*#define CC_BUILD_GL11*/
+/* Adds /client commands for benchmarking and tuning, e.g. collbench, noisebench, pngbench */
+/*#define CC_BUILD_DEVCOMMANDS*/
 /*#define CC_BUILD_SOLARIS*/
 #ifndef CC_BUILD_MANUAL
 #ifdef _WIN32
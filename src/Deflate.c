@@ -137,9 +137,12 @@ enum INFLATE_STATE_ {
 	INFLATE_STATE_DYNAMIC_LITSDISTSREPEAT, INFLATE_STATE_COMPRESSED_LIT,
 	INFLATE_STATE_COMPRESSED_LITREPEAT, INFLATE_STATE_COMPRESSED_DIST,
 	INFLATE_STATE_COMPRESSED_DISTREPEAT, INFLATE_STATE_COMPRESSED_DATA,
-	INFLATE_STATE_FASTCOMPRESSED, INFLATE_STATE_DONE
+	INFLATE_STATE_FASTCOMPRESSED, INFLATE_STATE_DONE, INFLATE_STATE_FAILED
 };
 
+/* Stops decompressing because data is invalid. (Data may be from an untrusted source) */
+#define Inflate_Fail(state, res) state->Error = res; state->State = INFLATE_STATE_FAILED;
+
 /* Insert next byte into the bit buffer */
 #define Inflate_GetByte(state) state->AvailIn--; state->Bits |= (uint32_t)(*state->NextIn++) << state->NumBits; state->NumBits += 8;
 /* Retrieves bits from the bit buffer */
@@ -173,7 +176,7 @@ static uint32_t Huffman_ReverseBits(uint32_t n, uint8_t bits) {
 }
 
 /* Builds a huffman tree, based on input lengths of each codeword */
-static void Huffman_Build(struct HuffmanTable* table, const uint8_t* bitLens, int count) {
+static ReturnCode Huffman_Build(struct HuffmanTable* table, const uint8_t* bitLens, int count) {
 	int bl_count[INFLATE_MAX_BITS], bl_offsets[INFLATE_MAX_BITS];
 	int code, offset, value;
 	int i, j;
@@ -192,9 +195,7 @@ static void Huffman_Build(struct HuffmanTable* table, const uint8_t* bitLens, in
 	/* Ensure huffman tree actually makes sense */
 	bl_count[0] = 0;
 	for (i = 1; i < INFLATE_MAX_BITS; i++) {
-		if (bl_count[i] > (1 << i)) {
-			Logger_Abort("Too many huffman codes for bit length");
-		}
+		if (bl_count[i] > (1 << i)) return INF_ERR_NUM_CODES;
 	}
 
 	/* Compute the codewords for the huffman tree.
@@ -252,10 +253,11 @@ static void Huffman_Build(struct HuffmanTable* table, const uint8_t* bitLens, in
 		}
 		bl_offsets[len]++;
 	}
+	return 0;
 }
 
 /* Attempts to read the next huffman encoded value from the bitstream, using given table */
-/* Returns -1 if there are insufficient bits to read the value */
+/* Returns -1 if there are insufficient bits to read the value, or if the value is invalid */
 static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table) {
 	uint32_t i, j, codeword;
 	int packed, bits, offset;
@@ -289,11 +291,12 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 		}
 	}
 
-	Logger_Abort("DEFLATE - Invalid huffman code");
+	Inflate_Fail(state, INF_ERR_INVALID_CODE);
 	return -1;
 }
 
 /* Inline the common <= 9 bits case */
+/* NOTE: Breaks out of the enclosing loop when the huffman code is invalid */
 #define Huffman_Unsafe_Decode(state, table, result) \
 {\
 	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
@@ -304,6 +307,7 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 		result = packed & 0x1FF;\
 	} else {\
 		result = Huffman_Unsafe_Decode_Slow(state, &table);\
+		if (state->State == INFLATE_STATE_FAILED) break;\
 	}\
 }
 
@@ -325,13 +329,14 @@ static int Huffman_Unsafe_Decode_Slow(struct InflateState* state, struct Huffman
 		}
 	}
 
-	Logger_Abort("DEFLATE - Invalid huffman code");
+	Inflate_Fail(state, INF_ERR_INVALID_CODE);
 	return -1;
 }
 
 void Inflate_Init(struct InflateState* state, struct Stream* source) {
 	state->State = INFLATE_STATE_HEADER;
 	state->LastBlock = false;
+	state->Error = 0;
 	state->Bits = 0;
 	state->NumBits = 0;
 	state->NextIn  = state->Input;
@@ -471,6 +476,7 @@ void Inflate_Process(struct InflateState* state) {
 	/* window variables */
 	uint32_t startIdx, curIdx;
 	uint32_t copyLen, windowCopyLen;
+	ReturnCode res;
 
 	for (;;) {
 		switch (state->State) {
@@ -496,7 +502,7 @@ void Inflate_Process(struct InflateState* state) {
 			} break;
 
 			case 3: {
-				Logger_Abort("DEFLATE - Invalid block type");
+				Inflate_Fail(state, INF_ERR_BLOCKTYPE);
 			} break;
 
 			}
@@ -509,7 +515,7 @@ void Inflate_Process(struct InflateState* state) {
 			nlen = Inflate_ReadBits(state, 16);
 
 			if (len != (nlen ^ 0xFFFFUL)) {
-				Logger_Abort("DEFLATE - Uncompressed block LEN check failed");
+				Inflate_Fail(state, INF_ERR_LEN_VERIFY); return;
 			}
 			state->Index = len; /* Reuse for 'uncompressed length' */
 			state->State = INFLATE_STATE_UNCOMPRESSED_DATA;
@@ -570,7 +576,8 @@ void Inflate_Process(struct InflateState* state) {
 
 			state->Index = 0;
 			state->State = INFLATE_STATE_DYNAMIC_LITSDISTS;
-			Huffman_Build(&state->Table.CodeLens, state->Buffer, INFLATE_MAX_CODELENS);
+			res = Huffman_Build(&state->Table.CodeLens, state->Buffer, INFLATE_MAX_CODELENS);
+			if (res) { Inflate_Fail(state, res); return; }
 		}
 
 		case INFLATE_STATE_DYNAMIC_LITSDISTS: {
@@ -591,8 +598,11 @@ void Inflate_Process(struct InflateState* state) {
 			if (state->Index == count) {
 				state->Index = 0;
 				state->State = Inflate_NextCompressState(state);
-				Huffman_Build(&state->Table.Lits, state->Buffer, state->NumLits);
-				Huffman_Build(&state->TableDists, &state->Buffer[state->NumLits], state->NumDists);
+
+				res = Huffman_Build(&state->Table.Lits, state->Buffer, state->NumLits);
+				if (res) { Inflate_Fail(state, res); return; }
+				res = Huffman_Build(&state->TableDists, &state->Buffer[state->NumLits], state->NumDists);
+				if (res) { Inflate_Fail(state, res); return; }
 			}
 			break;
 		}
@@ -602,7 +612,7 @@ void Inflate_Process(struct InflateState* state) {
 			case 16:
 				Inflate_EnsureBits(state, 2);
 				repeatCount = Inflate_ReadBits(state, 2);
-				if (!state->Index) Logger_Abort("DEFLATE - Tried to repeat invalid byte");
+				if (!state->Index) { Inflate_Fail(state, INF_ERR_REPEAT_BEG); return; }
 				repeatCount += 3; repeatValue = state->Buffer[state->Index - 1];
 				break;
 
@@ -621,7 +631,7 @@ void Inflate_Process(struct InflateState* state) {
 
 			count = state->NumLits + state->NumDists;
 			if (state->Index + repeatCount > count) {
-				Logger_Abort("DEFLATE - Tried to repeat past end");
+				Inflate_Fail(state, INF_ERR_REPEAT_END); return;
 			}
 
 			Mem_Set(&state->Buffer[state->Index], repeatValue, repeatCount);
@@ -703,6 +713,7 @@ void Inflate_Process(struct InflateState* state) {
 		}
 
 		case INFLATE_STATE_DONE:
+		case INFLATE_STATE_FAILED:
 			return;
 		}
 	}
@@ -744,6 +755,7 @@ static ReturnCode Inflate_StreamRead(struct Stream* stream, uint8_t* data, uint3
 		startAvailOut = state->AvailOut;
 		Inflate_Process(state);
 		*modified += (startAvailOut - state->AvailOut);
+		if (state->State == INFLATE_STATE_FAILED) return state->Error;
 	}
 	return 0;
 }
@@ -41,6 +41,7 @@ struct HuffmanTable {
 struct InflateState {
 	uint8_t State;
 	bool LastBlock;   /* Whether the last DEFLATE block has been encounted in the stream */
+	ReturnCode Error; /* Why decompressing failed, if the data was found to be invalid */
 	uint32_t Bits;    /* Holds bits across byte boundaries */
 	uint32_t NumBits; /* Number of bits in Bits buffer */
 
@@ -69,9 +70,11 @@ struct InflateState {
 CC_API void Inflate_Init(struct InflateState* state, struct Stream* source);
 /* Attempts to decompress as much of the currently pending data as possible. */
 /* NOTE: This is a low level call - usually you treat as a stream via Inflate_MakeStream. */
+/* NOTE: If the data is invalid, decompressing stops and state->Error is set. */
 void Inflate_Process(struct InflateState* state);
 /* Deompresses input data read from another stream using DEFLATE. Read only stream. */
 /* NOTE: This only uncompresses pure DEFLATE compressed data. */
+/* Reading returns an INF_ERR error once invalid DEFLATE data is encountered. */
 /* If data starts with a GZIP or ZLIB header, use GZipHeader_Read or ZLibHeader_Read to first skip it. */
 CC_API void Inflate_MakeStream(struct Stream* stream, struct InflateState* state, struct Stream* underlying);
 
@@ -166,6 +166,7 @@ bool Entity_TouchesAny(struct AABB* bounds, Entity_TouchesCondition condition) {
 	BlockID block;
 	struct AABB blockBB;
 	Vector3 v;
+	bool useCache;
 	int x, y, z;
 
 	Vector3I_Floor(&bbMin, &bounds->Min);
@@ -174,14 +175,15 @@ bool Entity_TouchesAny(struct AABB* bounds, Entity_TouchesCondition condition) {
 	bbMin.X = max(bbMin.X, 0); bbMax.X = min(bbMax.X, World_MaxX);
 	bbMin.Y = max(bbMin.Y, 0); bbMax.Y = min(bbMax.Y, World_MaxY);
 	bbMin.Z = max(bbMin.Z, 0); bbMax.Z = min(bbMax.Z, World_MaxZ);
+	useCache = CollisionCache_Covers(&bbMin, &bbMax);
 
 	for (y = bbMin.Y; y <= bbMax.Y; y++) { v.Y = (float)y;
 		for (z = bbMin.Z; z <= bbMax.Z; z++) { v.Z = (float)z;
 			for (x = bbMin.X; x <= bbMax.X; x++) { v.X = (float)x;
 
-				block = World_GetBlock(x, y, z);
-				Vector3_Add(&blockBB.Min, &v, &Blocks.MinBB[block]);
-				Vector3_Add(&blockBB.Max, &v, &Blocks.MaxBB[block]);
+				block = useCache ? CollisionCache_Get(x, y, z) : World_GetBlock(x, y, z);
+				Vector3_Add(&blockBB.Min, &v, &Blocks.Physics[block].MinBB);
+				Vector3_Add(&blockBB.Max, &v, &Blocks.Physics[block].MaxBB);
 
 				if (!AABB_Intersects(&blockBB, bounds)) continue;
 				if (condition(block)) return true;
@@ -195,6 +197,8 @@ static bool Entity_IsRope(BlockID b) { return Blocks.ExtendedCollide[b] == COLLI
 bool Entity_TouchesAnyRope(struct Entity* e) {
 	struct AABB bounds; Entity_GetBounds(e, &bounds);
 	bounds.Max.Y += 0.5f / 16.0f;
+
+	if (CollisionCache_Lacks(&bounds, COLLISION_FLAG_ROPE)) return false;
 	return Entity_TouchesAny(&bounds, Entity_IsRope);
 }
 
@@ -203,6 +207,8 @@ static bool Entity_IsLava(BlockID b) { return Blocks.ExtendedCollide[b] == COLLI
 bool Entity_TouchesAnyLava(struct Entity* e) {
 	struct AABB bounds; Entity_GetBounds(e, &bounds);
 	AABB_Offset(&bounds, &bounds, &entity_liqExpand);
+
+	if (CollisionCache_Lacks(&bounds, COLLISION_FLAG_LAVA)) return false;
 	return Entity_TouchesAny(&bounds, Entity_IsLava);
 }
 
@@ -210,6 +216,8 @@ static bool Entity_IsWater(BlockID b) { return Blocks.ExtendedCollide[b] == COLL
 bool Entity_TouchesAnyWater(struct Entity* e) {
 	struct AABB bounds; Entity_GetBounds(e, &bounds);
 	AABB_Offset(&bounds, &bounds, &entity_liqExpand);
+
+	if (CollisionCache_Lacks(&bounds, COLLISION_FLAG_WATER)) return false;
 	return Entity_TouchesAny(&bounds, Entity_IsWater);
 }
 
@@ -220,8 +228,35 @@ bool Entity_TouchesAnyWater(struct Entity* e) {
 struct _EntitiesData Entities;
 static EntityID entities_closestId;
 
+static void Entities_UpdateLod(void) {
+	struct Entity* e;
+	float nearSq, mediumSq, dist;
+	int i;
+
+	nearSq   = Entities.LodNearDist   * Entities.LodNearDist;
+	mediumSq = Entities.LodMediumDist * Entities.LodMediumDist;
+	for (i = 0; i < ENTITY_LOD_COUNT; i++) { Entities.LodCounts[i] = 0; }
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
+		e = Entities.List[i];
+		if (!e) continue;
+
+		if (i == ENTITIES_SELF_ID) {
+			e->Lod = ENTITY_LOD_NEAR;
+		} else if (!Model_ShouldRender(e)) {
+			e->Lod = ENTITY_LOD_HIDDEN;
+		} else {
+			dist   = Model_RenderDistance(e);
+			e->Lod = dist <= nearSq ? ENTITY_LOD_NEAR : (dist <= mediumSq ? ENTITY_LOD_MEDIUM : ENTITY_LOD_FAR);
+		}
+		Entities.LodCounts[e->Lod]++;
+	}
+}
+
 void Entities_Tick(struct ScheduledTask* task) {
 	int i;
+	NetInterpComp_AdvanceAll();
+	Entities_UpdateLod();
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->Interval);
@@ -232,16 +267,36 @@ void Entities_RenderModels(double delta, float t) {
 	int i;
 	Gfx_SetTexturing(true);
 	Gfx_SetAlphaTest(true);
+	Models_BeginBatch();
 	
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->RenderModel(Entities.List[i], delta, t);
 	}
+	Models_EndBatch();
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaTest(false);
 }
 	
 
+/* Names of entities are all drawn from the shared text cache, so can be drawn at once */
+static GfxResourceID entities_namesVb;
+static VertexP3fT2fC4b entities_namesVertices[ENTITIES_MAX_COUNT * 4];
+static int entities_namesCount;
+
+static void Entities_BeginNames(void) {
+	TextCache_NextBatch();
+	entities_namesCount = 0;
+}
+
+static void Entities_EndNames(void) {
+	if (!entities_namesCount) return;
+	Gfx_BindTexture(TextCache_TexId);
+	Gfx_SetVertexFormat(VERTEX_FORMAT_P3FT2FC4B);
+	Gfx_UpdateDynamicVb_IndexedTris(entities_namesVb, entities_namesVertices, entities_namesCount * 4);
+	entities_namesCount = 0;
+}
+
 void Entities_RenderNames(double delta) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	bool hadFog;
@@ -256,12 +311,14 @@ void Entities_RenderNames(double delta) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
+	Entities_BeginNames();
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		if (i != entities_closestId || i == ENTITIES_SELF_ID) {
 			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
 		}
 	}
+	Entities_EndNames();
 
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaTest(false);
@@ -283,12 +340,14 @@ void Entities_RenderHoveredNames(double delta) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
+	Entities_BeginNames();
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		if ((i == entities_closestId || allNames) && i != ENTITIES_SELF_ID) {
 			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
 		}
 	}
+	Entities_EndNames();
 
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaTest(false);
@@ -303,10 +362,12 @@ static void Entities_ContextLost(void* obj) {
 		Entities.List[i]->VTABLE->ContextLost(Entities.List[i]);
 	}
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
+	Gfx_DeleteVb(&entities_namesVb);
 }
 
 static void Entities_ContextRecreated(void* obj) {
 	int i;
+	entities_namesVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_P3FT2FC4B, ENTITIES_MAX_COUNT * 4);
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->ContextRecreated(Entities.List[i]);
@@ -366,6 +427,8 @@ void Entities_DrawShadows(void) {
 		for (i = 0; i < ENTITIES_SELF_ID; i++) {
 			if (!Entities.List[i]) continue;
 			if (Entities.List[i]->EntityType != ENTITY_TYPE_PLAYER) continue;
+			/* Shadows of far away entities are too small to notice */
+			if (Entities.List[i]->Lod > ENTITY_LOD_MEDIUM) continue;
 			ShadowComponent_Draw(Entities.List[i]);
 		}
 	}
@@ -488,13 +551,15 @@ static void Player_MakeNameTexture(struct Player* player) {
 	size = Drawer2D_MeasureText(&args);
 
 	if (size.Width == 0) {
-		player->NameTex.ID = GFX_NULL;
-		player->NameTex.X  = PLAYER_NAME_EMPTY_TEX;
+		player->NameTex.Gen   = 0;
+		player->NameTex.Width = PLAYER_NAME_EMPTY_TEX;
 	} else {
 		String_InitArray(colorlessName, colorlessBuffer);
 		size.Width += NAME_OFFSET; size.Height += NAME_OFFSET;
 
-		Bitmap_AllocateClearedPow2(&bmp, size.Width, size.Height);
+		/* Bitmap is packed into the text cache as is, so must be exactly the size of the text */
+		Bitmap_Allocate(&bmp, size.Width, size.Height);
+		Mem_Set(bmp.Scan0, 0, Bitmap_DataSize(size.Width, size.Height));
 		{
 			origWhiteCol = Drawer2D_Cols['f'];
 
@@ -507,7 +572,7 @@ static void Player_MakeNameTexture(struct Player* player) {
 			args.Text = name;
 			Drawer2D_DrawText(&bmp, &args, 0, 0);
 		}
-		Drawer2D_Make2DTexture(&player->NameTex, &bmp, size, 0, 0);
+		TextCache_Add(&player->NameTex, &bmp);
 		Mem_Free(bmp.Scan0);
 	}
 	Drawer2D_BitmappedText = bitmapped;
@@ -515,14 +580,11 @@ static void Player_MakeNameTexture(struct Player* player) {
 
 void Player_UpdateNameTex(struct Player* player) {
 	struct Entity* e = &player->Base;
+	/* Player_DrawName remakes the text, so names of players never seen are never made */
 	e->VTABLE->ContextLost(e);
-
-	if (Gfx_LostContext) return;
-	Player_MakeNameTexture(player);
 }
 
 static void Player_DrawName(struct Player* p) {
-	VertexP3fT2fC4b vertices[4];
 	PackedCol col = PACKEDCOL_WHITE;
 
 	struct Entity* e = &p->Base;
@@ -532,9 +594,14 @@ static void Player_DrawName(struct Player* p) {
 	float scale;
 	Vector2 size;	
 
-	if (p->NameTex.X == PLAYER_NAME_EMPTY_TEX) return;
-	if (!p->NameTex.ID) Player_MakeNameTexture(p);
-	Gfx_BindTexture(p->NameTex.ID);
+	if (p->NameTex.Width == PLAYER_NAME_EMPTY_TEX) return;
+	if (entities_namesCount == ENTITIES_MAX_COUNT) return;
+
+	if (!TextCache_Use(&p->NameTex)) {
+		Player_MakeNameTexture(p);
+		/* Text cache is full of names drawn this frame, so try again next frame */
+		if (!p->NameTex.Gen) return;
+	}
 
 	model = e->Model;
 	Vector3_TransformY(&pos, model->GetNameY(e), &e->Transform);
@@ -550,9 +617,8 @@ static void Player_DrawName(struct Player* p) {
 		size.X *= scale * 0.2f; size.Y *= scale * 0.2f;
 	}
 
-	Particle_DoRender(&size, &pos, &p->NameTex.uv, col, vertices);
-	Gfx_SetVertexFormat(VERTEX_FORMAT_P3FT2FC4B);
-	Gfx_UpdateDynamicVb_IndexedTris(Gfx_texVb, vertices, 4);
+	Particle_DoRender(&size, &pos, &p->NameTex.uv, col, &entities_namesVertices[entities_namesCount * 4]);
+	entities_namesCount++;
 }
 
 static struct Player* Player_FirstOtherWithSameSkin(struct Player* player) {
@@ -669,30 +735,18 @@ static void Player_ClearHat(Bitmap* bmp, uint8_t skinType) {
 	}
 }
 
-/* Ensures skin is a power of two size, resizing if needed. */
-static void Player_EnsurePow2(struct Player* p, Bitmap* bmp) {
-	uint32_t stride;
-	int width, height;
-	Bitmap scaled;
-	int y;
-
-	width  = Math_NextPowOf2(bmp->Width);
-	height = Math_NextPowOf2(bmp->Height);
-	if (width == bmp->Width && height == bmp->Height) return;
-
-	Bitmap_Allocate(&scaled, width, height);
-	p->Base.uScale = (float)bmp->Width  / width;
-	p->Base.vScale = (float)bmp->Height / height;
-	stride = bmp->Width * 4;
-
-	for (y = 0; y < bmp->Height; y++) {
-		BitmapCol* src = Bitmap_GetRow(bmp, y);
-		BitmapCol* dst = Bitmap_GetRow(&scaled, y);
-		Mem_Copy(dst, src, stride);
-	}
+/* Decodes a skin on the http worker thread, as its contents are downloaded */
+/* Skin is decoded straight into a power of two sized bitmap, so it can be used as a texture as is */
+static ReturnCode Player_DecodeSkin(struct HttpRequest* req, struct Stream* body) {
+	Bitmap bmp;
+	ReturnCode res = Png_DecodePow2(&bmp, body, &req->ImageWidth, &req->ImageHeight);
+	if (res) { Mem_Free(bmp.Scan0); return res; }
 
-	Mem_Free(bmp->Scan0);
-	*bmp = scaled;
+	req->Data = bmp.Scan0;
+	req->Size = Bitmap_DataSize(bmp.Width, bmp.Height);
+	req->BitmapWidth  = bmp.Width;
+	req->BitmapHeight = bmp.Height;
+	return 0;
 }
 
 static void Player_CheckSkin(struct Player* p) {
@@ -701,14 +755,12 @@ static void Player_CheckSkin(struct Player* p) {
 	String url, skin = String_FromRawArray(e->SkinNameRaw);
 
 	struct HttpRequest item;
-	struct Stream mem;
 	Bitmap bmp;
-	ReturnCode res;
 
 	if (!p->FetchedSkin && e->Model->UsesSkin) {
 		first = Player_FirstOtherWithSameSkinAndFetchedSkin(p);
 		if (!first) {
-			Http_AsyncGetSkin(&skin, &skin);
+			Http_AsyncGetSkin(&skin, &skin, Player_DecodeSkin);
 		} else {
 			Player_CopySkin(p, first);
 		}
@@ -716,18 +768,19 @@ static void Player_CheckSkin(struct Player* p) {
 	}
 
 	if (!Http_GetResult(&skin, &item)) return;
-	if (!item.Success) { Player_SetSkinAll(p, true); return; }
-	Stream_ReadonlyMemory(&mem, item.Data, item.Size);
-
-	if ((res = Png_Decode(&bmp, &mem))) {
+	if (item.StatusCode == 200 && item.Result) {
 		url = String_FromRawArray(item.URL);
-		Logger_Warn2(res, "decoding", &url);
-		Mem_Free(bmp.Scan0); return;
+		Logger_Warn2(item.Result, "decoding", &url);
+		return;
 	}
+	if (!item.Success) { Player_SetSkinAll(p, true); return; }
+
+	Bitmap_Init(bmp, item.BitmapWidth, item.BitmapHeight, item.Data);
 
 	Gfx_DeleteTexture(&e->TextureId);
 	Player_SetSkinAll(p, true);
-	Player_EnsurePow2(p, &bmp);
+	e->uScale = (float)item.ImageWidth  / bmp.Width;
+	e->vScale = (float)item.ImageHeight / bmp.Height;
 	e->SkinType = Utils_GetSkinType(&bmp);
 
 	if (bmp.Width > Gfx_MaxTexWidth || bmp.Height > Gfx_MaxTexHeight) {
@@ -753,8 +806,9 @@ static void Player_Despawn(struct Entity* e) {
 
 static void Player_ContextLost(struct Entity* e) {
 	struct Player* player = (struct Player*)e;
-	Gfx_DeleteTexture(&player->NameTex.ID);
-	player->NameTex.X = 0; /* X is used as an 'empty name' flag */
+	/* Text is left in the text cache, to be evicted when space is needed */
+	player->NameTex.Gen   = 0;
+	player->NameTex.Width = 0; /* Width is used as an 'empty name' flag */
 }
 
 static void Player_ContextRecreated(struct Entity* e) {
@@ -837,12 +891,20 @@ static void LocalPlayer_SetLocation(struct Entity* e, struct LocationUpdate* upd
 	LocalInterpComp_SetLocation(&p->Interp, update, interpolate);
 }
 
+/* Moves the given corner of the bounds outwards by the velocity along each axis, plus one block */
+static void LocalPlayer_ExpandBounds(Vector3* corner, const Vector3* vel, float dir) {
+	corner->X += dir * (Math_AbsF(vel->X) + 1.0f);
+	corner->Y += dir * (Math_AbsF(vel->Y) + 1.0f);
+	corner->Z += dir * (Math_AbsF(vel->Z) + 1.0f);
+}
+
 static void LocalPlayer_Tick(struct Entity* e, double delta) {
 	struct LocalPlayer* p = (struct LocalPlayer*)e;
 	struct HacksComp* hacks = &p->Hacks;
 	float xMoving = 0, zMoving = 0;
 	bool wasOnGround;
 	Vector3 headingVelocity;
+	struct AABB bounds;
 
 	if (!World_Blocks) return;
 	e->StepSize = hacks->FullBlockStep && hacks->Enabled && hacks->CanAnyHacks && hacks->CanSpeed ? 1.0f : 0.5f;
@@ -859,6 +921,12 @@ static void LocalPlayer_Tick(struct Entity* e, double delta) {
 		e->Velocity = Vector3_Zero();
 	}
 
+	/* Cache the blocks the player can possibly touch this tick */
+	Entity_GetBounds(e, &bounds);
+	LocalPlayer_ExpandBounds(&bounds.Min, &e->Velocity, -1.0f);
+	LocalPlayer_ExpandBounds(&bounds.Max, &e->Velocity,  1.0f);
+	CollisionCache_Build(&bounds);
+
 	PhysicsComp_UpdateVelocityState(&p->Physics);
 	headingVelocity = Vector3_RotateY3(xMoving, 0, zMoving, e->HeadY * MATH_DEG2RAD);
 	PhysicsComp_PhysicsTick(&p->Physics, headingVelocity);
@@ -872,6 +940,7 @@ static void LocalPlayer_Tick(struct Entity* e, double delta) {
 
 	Player_CheckSkin((struct Player*)p);
 	SoundComp_Tick(wasOnGround);
+	CollisionCache_Clear();
 }
 
 static void LocalPlayer_RenderModel(struct Entity* e, double deltaTime, float t) {
@@ -1082,24 +1151,26 @@ struct NetPlayer NetPlayers_List[ENTITIES_SELF_ID];
 
 static void NetPlayer_SetLocation(struct Entity* e, struct LocationUpdate* update, bool interpolate) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
-	NetInterpComp_SetLocation(&p->Interp, update, interpolate);
+	NetInterpComp_SetLocation(NetPlayer_Id(p), update, interpolate);
 }
 
 static void NetPlayer_Tick(struct Entity* e, double delta) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
+	EntityID id = NetPlayer_Id(p);
+	/* NOTE: Interpolation state was already advanced by NetInterpComp_AdvanceAll in Entities_Tick */
 	Player_CheckSkin((struct Player*)p);
-	NetInterpComp_AdvanceState(&p->Interp);
-	AnimatedComp_Update(e, p->Interp.Prev.Pos, p->Interp.Next.Pos, delta);
+	AnimatedComp_Update(e, NetInterp.Prev[id].Pos, NetInterp.Next[id].Pos, delta);
 }
 
 static void NetPlayer_RenderModel(struct Entity* e, double deltaTime, float t) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
-	Vector3_Lerp(&e->Position, &p->Interp.Prev.Pos, &p->Interp.Next.Pos, t);
-	InterpComp_LerpAngles((struct InterpComp*)(&p->Interp), e, t);
+	NetInterpComp_GetCurrent(NetPlayer_Id(p), e, t);
 
-	AnimatedComp_GetCurrent(e, t);
 	p->ShouldRender = Model_ShouldRender(e);
-	if (p->ShouldRender) Model_Render(e->Model, e);
+	if (!p->ShouldRender) return;
+
+	AnimatedComp_GetCurrent(e, t);
+	Model_Render(e->Model, e);
 }
 
 static void NetPlayer_RenderName(struct Entity* e) {
@@ -1119,6 +1190,7 @@ struct EntityVTABLE netPlayer_VTABLE = {
 };
 void NetPlayer_Init(struct NetPlayer* p, const String* displayName, const String* skinName) {
 	Mem_Set(p, 0, sizeof(struct NetPlayer));
+	NetInterpComp_Reset(NetPlayer_Id(p));
 	Player_Init(&p->Base);
 	Player_SetName((struct Player*)p, displayName, skinName);
 	p->Base.VTABLE = &netPlayer_VTABLE;
@@ -1142,8 +1214,12 @@ static void Entities_Init(void) {
 		ShadowMode_Names, Array_Elems(ShadowMode_Names));
 	if (Game_ClassicMode) Entities.ShadowsMode = SHADOW_MODE_NONE;
 
+	Entities.LodNearDist   = Options_GetFloat(OPT_ENTITY_LOD_NEAR,   0.0f, 8192.0f, 32.0f);
+	Entities.LodMediumDist = Options_GetFloat(OPT_ENTITY_LOD_MEDIUM, 0.0f, 8192.0f, 96.0f);
+
 	Entities.List[ENTITIES_SELF_ID] = &LocalPlayer_Instance.Base;
 	LocalPlayer_Init();
+	entities_namesVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_P3FT2FC4B, ENTITIES_MAX_COUNT * 4);
 }
 
 static void Entities_Free(void) {
@@ -1160,6 +1236,7 @@ static void Entities_Free(void) {
 	if (ShadowComponent_ShadowTex) {
 		Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
 	}
+	Gfx_DeleteVb(&entities_namesVb);
 }
 
 struct IGameComponent Entities_Component = {
@@ -5,6 +5,7 @@
 #include "Constants.h"
 #include "Input.h"
 #include "PackedCol.h"
+#include "Gui.h"
 /* Represents an in-game entity.
    Copyright 2014-2017 ClassicalSharp | Licensed under BSD-3
 */
@@ -29,6 +30,12 @@ enum ShadowMode {
 };
 extern const char* ShadowMode_Names[SHADOW_MODE_COUNT];
 
+/* How detailed an entity is animated and rendered, based on its distance and visibility. */
+/* Further tiers update animation less often, skip limb animation and don't draw shadows. */
+enum EntityLod {
+	ENTITY_LOD_NEAR, ENTITY_LOD_MEDIUM, ENTITY_LOD_FAR, ENTITY_LOD_HIDDEN, ENTITY_LOD_COUNT
+};
+
 enum EntityType { ENTITY_TYPE_NONE, ENTITY_TYPE_PLAYER };
 
 #define LOCATIONUPDATE_FLAG_POS   0x01
@@ -79,6 +86,7 @@ struct Entity {
 	float StepSize;
 	
 	uint8_t SkinType, EntityType;
+	uint8_t Lod; /* Level of detail tier, recalculated every tick. (see enum EntityLod) */
 	bool NoShade, OnGround;
 	GfxResourceID TextureId, MobTextureId;
 	float uScale, vScale;
@@ -119,6 +127,10 @@ bool Entity_TouchesAnyWater(struct Entity* e);
 CC_VAR extern struct _EntitiesData {
 	struct Entity* List[ENTITIES_MAX_COUNT];
 	uint8_t NamesMode, ShadowsMode;
+	/* Maximum distance from the camera of entities in the near and medium LOD tiers. */
+	float LodNearDist, LodMediumDist;
+	/* Number of entities in each LOD tier as of the last tick. */
+	int LodCounts[ENTITY_LOD_COUNT];
 } Entities;
 
 /* Ticks all entities. */
@@ -161,25 +173,48 @@ CC_API void TabList_Set(EntityID id, const String* player, const String* list, c
 #define TabList_UNSAFE_GetPlayer(id) StringsBuffer_UNSAFE_Get(&TabList.Buffer, TabList.PlayerNames[id]);
 #define TabList_UNSAFE_GetList(id)   StringsBuffer_UNSAFE_Get(&TabList.Buffer, TabList.ListNames[id]);
 #define TabList_UNSAFE_GetGroup(id)  StringsBuffer_UNSAFE_Get(&TabList.Buffer, TabList.GroupNames[id]);
-#define Player_Layout struct Entity Base; char DisplayNameRaw[STRING_SIZE]; bool FetchedSkin; struct Texture NameTex;
+#define Player_Layout struct Entity Base; char DisplayNameRaw[STRING_SIZE]; bool FetchedSkin; struct TextCacheEntry NameTex;
 
 /* Represents a player entity. */
 struct Player { Player_Layout };
 /* Sets the display name (name tag above entity) and skin name of the given player. */
 void Player_SetName(struct Player* player, const String* name, const String* skin);
-/* Remakes the texture for the name tag of the entity. */
+/* Discards the name tag text of the entity, so it is remade when next drawn. */
 void Player_UpdateNameTex(struct Player* player);
 /* Resets the skin of the entity to default. */
 void Player_ResetSkin(struct Player* player);
 
 /* Represents another entity in multiplayer */
+/* NOTE: Interpolation state is stored separately in NetInterp, indexed by entity ID. */
 struct NetPlayer {
 	Player_Layout
-	struct NetInterpComp Interp;
 	bool ShouldRender;
 };
 void NetPlayer_Init(struct NetPlayer* player, const String* displayName, const String* skinName);
 extern struct NetPlayer NetPlayers_List[ENTITIES_SELF_ID];
+/* Returns the entity ID of the given network player. */
+#define NetPlayer_Id(p) ((EntityID)((p) - NetPlayers_List))
+
+/* Max number of position states, and of body rotation states, buffered for a network player. */
+/* When full, the oldest state is dropped, which limits how far a player can lag behind. */
+#define NETINTERP_MAX_STATES 10
+#define NETINTERP_MAX_ROTY   15
+/* Size of each ring buffer of states. Must be a power of two. */
+#define NETINTERP_RING_SIZE  16
+/* Interpolation state of network players, stored as structure of arrays indexed by entity ID. */
+/* This way NetInterpComp_AdvanceAll can step every network player in one tight loop. */
+CC_VAR extern struct _NetInterpData {
+	struct InterpState Prev[ENTITIES_SELF_ID], Next[ENTITIES_SELF_ID];
+	float PrevRotY[ENTITIES_SELF_ID], NextRotY[ENTITIES_SELF_ID];
+	/* Last known position and orientation sent by the server */
+	struct InterpState Cur[ENTITIES_SELF_ID];
+
+	/* Ring buffers of states not yet interpolated to */
+	uint8_t StatesHead[ENTITIES_SELF_ID], StatesCount[ENTITIES_SELF_ID];
+	uint8_t RotYHead[ENTITIES_SELF_ID],   RotYCount[ENTITIES_SELF_ID];
+	struct InterpState States[ENTITIES_SELF_ID][NETINTERP_RING_SIZE];
+	float RotYStates[ENTITIES_SELF_ID][NETINTERP_RING_SIZE];
+} NetInterp;
 
 /* Represents the user/player's own entity. */
 struct LocalPlayer {
@@ -56,45 +56,74 @@ static void AnimatedComp_CalcHumanAnim(struct AnimatedComp* anim, float idleXRot
 void AnimatedComp_Init(struct AnimatedComp* anim) {
 	Mem_Set(anim, 0, sizeof(struct AnimatedComp));
 	anim->BobStrength = 1.0f; anim->BobStrengthO = 1.0f; anim->BobStrengthN = 1.0f;
+	anim->LodSpan = 1;
 }
 
+/* Number of ticks between animation updates for each LOD tier */
+static const uint8_t anim_lodIntervals[ENTITY_LOD_COUNT] = { 1, 2, 4, 8 };
+
 void AnimatedComp_Update(struct Entity* e, Vector3 oldPos, Vector3 newPos, double delta) {
 	struct AnimatedComp* anim = &e->Anim;
-	float dx = newPos.X - oldPos.X;
-	float dz = newPos.Z - oldPos.Z;
-	float distance = Math_SqrtF(dx * dx + dz * dz);
-	int i;
+	float dx, dz, distance;
+	int i, ticks;
 
 	float walkDelta;
+	if (!anim->LodTicks) anim->LodPos = oldPos;
+	anim->LodTicks++;
+	if (anim->LodTicks < anim_lodIntervals[e->Lod]) return;
+
+	/* Treat movement since last update as evenly spread over the ticks since then */
+	ticks = anim->LodTicks;
+	dx    = newPos.X - anim->LodPos.X;
+	dz    = newPos.Z - anim->LodPos.Z;
+	distance = Math_SqrtF(dx * dx + dz * dz) / ticks;
+
+	anim->LodTicks  = 0;
+	anim->LodSpan   = ticks;
 	anim->WalkTimeO = anim->WalkTimeN;
 	anim->SwingO    = anim->SwingN;
 
 	if (distance > 0.05f) {
 		walkDelta = distance * 2 * (float)(20 * delta);
-		anim->WalkTimeN += walkDelta;
-		anim->SwingN += (float)delta * 3;
+		anim->WalkTimeN += walkDelta * ticks;
+		anim->SwingN += (float)delta * 3 * ticks;
 	} else {
-		anim->SwingN -= (float)delta * 3;
+		anim->SwingN -= (float)delta * 3 * ticks;
 	}
 	Math_Clamp(anim->SwingN, 0.0f, 1.0f);
 
 	/* TODO: the Tilt code was designed for 60 ticks/second, fix it up for 20 ticks/second */
 	anim->BobStrengthO = anim->BobStrengthN;
-	for (i = 0; i < 3; i++) {
+	for (i = 0; i < 3 * ticks; i++) {
 		AnimatedComp_DoTilt(&anim->BobStrengthN, !Game_ViewBobbing || !e->OnGround);
 	}
 }
 
 void AnimatedComp_GetCurrent(struct Entity* e, float t) {
 	struct AnimatedComp* anim = &e->Anim;
-	float idleTime = (float)Game.Time;
-	float idleXRot = Math_SinF(idleTime * ANIM_IDLE_XPERIOD) * ANIM_IDLE_MAX;
-	float idleZRot = Math_CosF(idleTime * ANIM_IDLE_ZPERIOD) * ANIM_IDLE_MAX + ANIM_IDLE_MAX;
+	float idleTime, idleXRot, idleZRot;
 
+	/* Interpolate across all the ticks the last animation update covered */
+	if (anim->LodSpan > 1) {
+		t = (anim->LodTicks + t) / anim->LodSpan;
+		if (t > 1.0f) t = 1.0f;
+	}
 	anim->Swing       = Math_Lerp(anim->SwingO,       anim->SwingN,       t);
 	anim->WalkTime    = Math_Lerp(anim->WalkTimeO,    anim->WalkTimeN,    t);
 	anim->BobStrength = Math_Lerp(anim->BobStrengthO, anim->BobStrengthN, t);
 
+	/* Limbs are too small to notice moving on far away entities */
+	if (e->Lod >= ENTITY_LOD_FAR) {
+		anim->LeftLegX  = 0; anim->LeftLegZ  = 0; anim->RightLegX = 0; anim->RightLegZ = 0;
+		anim->LeftArmX  = 0; anim->LeftArmZ  = 0; anim->RightArmX = 0; anim->RightArmZ = 0;
+		anim->BobbingHor = 0; anim->BobbingVer = 0; anim->BobbingModel = 0;
+		return;
+	}
+
+	idleTime = (float)Game.Time;
+	idleXRot = Math_SinF(idleTime * ANIM_IDLE_XPERIOD) * ANIM_IDLE_MAX;
+	idleZRot = Math_CosF(idleTime * ANIM_IDLE_ZPERIOD) * ANIM_IDLE_MAX + ANIM_IDLE_MAX;
+
 	anim->LeftArmX =  (Math_CosF(anim->WalkTime) * anim->Swing * ANIM_ARM_MAX) - idleXRot;
 	anim->LeftArmZ = -idleZRot;
 	anim->LeftLegX = -(Math_CosF(anim->WalkTime) * anim->Swing * ANIM_LEG_MAX);
@@ -321,17 +350,18 @@ static void InterpComp_AdvanceRotY(struct InterpComp* interp) {
 	InterpComp_RemoveOldestRotY(interp);
 }
 
-void InterpComp_LerpAngles(struct InterpComp* interp, struct Entity* e, float t) {
-	struct InterpState* prev = &interp->Prev;
-	struct InterpState* next = &interp->Next;
-
+static void InterpComp_Lerp(struct InterpState* prev, struct InterpState* next, float prevRotY, float nextRotY, struct Entity* e, float t) {
 	e->HeadX = Math_LerpAngle(prev->HeadX, next->HeadX, t);
 	e->HeadY = Math_LerpAngle(prev->HeadY, next->HeadY, t);
 	e->RotX  = Math_LerpAngle(prev->RotX,  next->RotX, t);
-	e->RotY  = Math_LerpAngle(interp->PrevRotY, interp->NextRotY, t);
+	e->RotY  = Math_LerpAngle(prevRotY,    nextRotY, t);
 	e->RotZ  = Math_LerpAngle(prev->RotZ,  next->RotZ, t);
 }
 
+void InterpComp_LerpAngles(struct InterpComp* interp, struct Entity* e, float t) {
+	InterpComp_Lerp(&interp->Prev, &interp->Next, interp->PrevRotY, interp->NextRotY, e, t);
+}
+
 static void InterpComp_SetPos(struct InterpState* state, struct LocationUpdate* update) {
 	if (update->RelativePos) {
 		Vector3_AddBy(&state->Pos, &update->Pos);
@@ -344,24 +374,42 @@ static void InterpComp_SetPos(struct InterpState* state, struct LocationUpdate*
 /*########################################################################################################################*
 *----------------------------------------------NetworkInterpolationComponent----------------------------------------------*
 *#########################################################################################################################*/
-static void NetInterpComp_RemoveOldestState(struct NetInterpComp* interp) {
-	int i;
-	for (i = 0; i < Array_Elems(interp->States); i++) {
-		interp->States[i] = interp->States[i + 1];
+struct _NetInterpData NetInterp;
+#define NETINTERP_MASK (NETINTERP_RING_SIZE - 1)
+
+static void NetInterpComp_AddState(EntityID id, struct InterpState* state) {
+	int count = NetInterp.StatesCount[id];
+	/* Overwrite oldest state when ring buffer is full */
+	if (count == NETINTERP_MAX_STATES) {
+		NetInterp.StatesHead[id] = (NetInterp.StatesHead[id] + 1) & NETINTERP_MASK; count--;
 	}
-	interp->StatesCount--;
+
+	NetInterp.States[id][(NetInterp.StatesHead[id] + count) & NETINTERP_MASK] = *state;
+	NetInterp.StatesCount[id] = count + 1;
 }
 
-static void NetInterpComp_AddState(struct NetInterpComp* interp, struct InterpState state) {
-	if (interp->StatesCount == Array_Elems(interp->States)) {
-		NetInterpComp_RemoveOldestState(interp);
+static void NetInterpComp_AddRotY(EntityID id, float state) {
+	int count = NetInterp.RotYCount[id];
+	if (count == NETINTERP_MAX_ROTY) {
+		NetInterp.RotYHead[id] = (NetInterp.RotYHead[id] + 1) & NETINTERP_MASK; count--;
 	}
-	interp->States[interp->StatesCount] = state; interp->StatesCount++;
+
+	NetInterp.RotYStates[id][(NetInterp.RotYHead[id] + count) & NETINTERP_MASK] = state;
+	NetInterp.RotYCount[id] = count + 1;
+}
+
+void NetInterpComp_Reset(EntityID id) {
+	static struct InterpState empty;
+	NetInterp.Prev[id] = empty; NetInterp.Next[id] = empty; NetInterp.Cur[id] = empty;
+	NetInterp.PrevRotY[id]   = 0.0f; NetInterp.NextRotY[id]  = 0.0f;
+	NetInterp.StatesHead[id] = 0;    NetInterp.StatesCount[id] = 0;
+	NetInterp.RotYHead[id]   = 0;    NetInterp.RotYCount[id]   = 0;
 }
 
-void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpdate* update, bool interpolate) {
-	struct InterpState last = interp->Cur;
-	struct InterpState* cur = &interp->Cur;
+void NetInterpComp_SetLocation(EntityID id, struct LocationUpdate* update, bool interpolate) {
+	struct InterpState* cur = &NetInterp.Cur[id];
+	struct InterpState last = *cur;
+	struct InterpState mid;
 	uint8_t flags = update->Flags;
 
 	if (flags & LOCATIONUPDATE_FLAG_POS)   InterpComp_SetPos(cur, update);
@@ -371,34 +419,56 @@ void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpda
 	if (flags & LOCATIONUPDATE_FLAG_HEADY) cur->HeadY = update->HeadY;
 
 	if (!interpolate) {
-		interp->Prev = *cur; interp->PrevRotY = cur->HeadY;
-		interp->Next = *cur; interp->NextRotY = cur->HeadY;
-		interp->RotYCount = 0; interp->StatesCount = 0;
+		NetInterp.Prev[id] = *cur; NetInterp.PrevRotY[id] = cur->HeadY;
+		NetInterp.Next[id] = *cur; NetInterp.NextRotY[id] = cur->HeadY;
+		NetInterp.RotYCount[id] = 0; NetInterp.StatesCount[id] = 0;
 	} else {
 		/* Smoother interpolation by also adding midpoint. */
-		struct InterpState mid;
 		Vector3_Lerp(&mid.Pos, &last.Pos, &cur->Pos, 0.5f);
 		mid.RotX  = Math_LerpAngle(last.RotX,  cur->RotX,  0.5f);
 		mid.RotZ  = Math_LerpAngle(last.RotZ,  cur->RotZ,  0.5f);
 		mid.HeadX = Math_LerpAngle(last.HeadX, cur->HeadX, 0.5f);
 		mid.HeadY = Math_LerpAngle(last.HeadY, cur->HeadY, 0.5f);
-		NetInterpComp_AddState(interp, mid);
-		NetInterpComp_AddState(interp, *cur);
+		NetInterpComp_AddState(id, &mid);
+		NetInterpComp_AddState(id, cur);
 
 		/* Head rotation lags behind body a tiny bit */
-		InterpComp_AddRotY((struct InterpComp*)interp, Math_LerpAngle(last.HeadY, cur->HeadY, 0.33333333f));
-		InterpComp_AddRotY((struct InterpComp*)interp, Math_LerpAngle(last.HeadY, cur->HeadY, 0.66666667f));
-		InterpComp_AddRotY((struct InterpComp*)interp, Math_LerpAngle(last.HeadY, cur->HeadY, 1.00000000f));
+		NetInterpComp_AddRotY(id, Math_LerpAngle(last.HeadY, cur->HeadY, 0.33333333f));
+		NetInterpComp_AddRotY(id, Math_LerpAngle(last.HeadY, cur->HeadY, 0.66666667f));
+		NetInterpComp_AddRotY(id, Math_LerpAngle(last.HeadY, cur->HeadY, 1.00000000f));
 	}
 }
 
-void NetInterpComp_AdvanceState(struct NetInterpComp* interp) {
-	interp->Prev = interp->Next;
-	if (interp->StatesCount > 0) {
-		interp->Next = interp->States[0];
-		NetInterpComp_RemoveOldestState(interp);
+void NetInterpComp_AdvanceAll(void) {
+	int i, head;
+	/* Unused slots have no pending states, so are cheap to advance too */
+	for (i = 0; i < ENTITIES_SELF_ID; i++) {
+		NetInterp.Prev[i] = NetInterp.Next[i];
+		if (NetInterp.StatesCount[i]) {
+			head = NetInterp.StatesHead[i];
+			NetInterp.Next[i] = NetInterp.States[i][head];
+
+			NetInterp.StatesHead[i] = (head + 1) & NETINTERP_MASK;
+			NetInterp.StatesCount[i]--;
+		}
+
+		NetInterp.PrevRotY[i] = NetInterp.NextRotY[i];
+		if (NetInterp.RotYCount[i]) {
+			head = NetInterp.RotYHead[i];
+			NetInterp.NextRotY[i] = NetInterp.RotYStates[i][head];
+
+			NetInterp.RotYHead[i] = (head + 1) & NETINTERP_MASK;
+			NetInterp.RotYCount[i]--;
+		}
 	}
-	InterpComp_AdvanceRotY((struct InterpComp*)interp);
+}
+
+void NetInterpComp_GetCurrent(EntityID id, struct Entity* e, float t) {
+	struct InterpState* prev = &NetInterp.Prev[id];
+	struct InterpState* next = &NetInterp.Next[id];
+
+	Vector3_Lerp(&e->Position, &prev->Pos, &next->Pos, t);
+	InterpComp_Lerp(prev, next, NetInterp.PrevRotY[id], NetInterp.NextRotY[id], e, t);
 }
 
 
@@ -948,10 +1018,12 @@ void PhysicsComp_UpdateVelocityState(struct PhysicsComp* comp) {
 		if (bodyY > headY) bodyY = headY;
 
 		bounds.Max.Y = bounds.Min.Y = feetY;
-		liquidFeet   = Entity_TouchesAny(&bounds, PhysicsComp_TouchesLiquid);
+		liquidFeet   = !CollisionCache_Lacks(&bounds, COLLISION_FLAG_LIQUID)
+						&& Entity_TouchesAny(&bounds, PhysicsComp_TouchesLiquid);
 		bounds.Min.Y = min(bodyY, headY);
 		bounds.Max.Y = max(bodyY, headY);
-		liquidRest   = Entity_TouchesAny(&bounds, PhysicsComp_TouchesLiquid);
+		liquidRest   = !CollisionCache_Lacks(&bounds, COLLISION_FLAG_LIQUID)
+						&& Entity_TouchesAny(&bounds, PhysicsComp_TouchesLiquid);
 
 		pastJumpPoint = liquidFeet && !liquidRest && (Math_Mod1(entity->Position.Y) >= 0.4f);
 		if (!pastJumpPoint) {
@@ -1007,6 +1079,8 @@ static bool PhysicsComp_OnIce(struct Entity* e) {
 
 	Entity_GetBounds(e, &bounds);
 	bounds.Min.Y -= 0.01f; bounds.Max.Y = bounds.Min.Y;
+
+	if (CollisionCache_Lacks(&bounds, COLLISION_FLAG_SLIPPERY_ICE)) return false;
 	return Entity_TouchesAny(&bounds, PhysicsComp_TouchesSlipperyIce);
 }
 
@@ -1065,8 +1139,9 @@ static float PhysicsComp_LowestModifier(struct PhysicsComp* comp, struct AABB* b
 	float modifier = MATH_POS_INF;
 	struct AABB blockBB;
 	BlockID block;
-	uint8_t collide;
+	struct BlockPhysicsDesc* desc;
 	Vector3 v;
+	bool useCache;
 	int x, y, z;
 
 	Vector3I_Floor(&bbMin, &bounds->Min);
@@ -1075,22 +1150,23 @@ static float PhysicsComp_LowestModifier(struct PhysicsComp* comp, struct AABB* b
 	bbMin.X = max(bbMin.X, 0); bbMax.X = min(bbMax.X, World_MaxX);
 	bbMin.Y = max(bbMin.Y, 0); bbMax.Y = min(bbMax.Y, World_MaxY);
 	bbMin.Z = max(bbMin.Z, 0); bbMax.Z = min(bbMax.Z, World_MaxZ);
+	useCache = CollisionCache_Covers(&bbMin, &bbMax);
 	
 	for (y = bbMin.Y; y <= bbMax.Y; y++) { v.Y = (float)y;
 		for (z = bbMin.Z; z <= bbMax.Z; z++) { v.Z = (float)z;
 			for (x = bbMin.X; x <= bbMax.X; x++) { v.X = (float)x;
-				block = World_GetBlock(x, y, z);
+				block = useCache ? CollisionCache_Get(x, y, z) : World_GetBlock(x, y, z);
 
 				if (block == BLOCK_AIR) continue;
-				collide = Blocks.Collide[block];
-				if (collide == COLLIDE_SOLID && !checkSolid) continue;
+				desc = &Blocks.Physics[block];
+				if (desc->Collide == COLLIDE_SOLID && !checkSolid) continue;
 
-				Vector3_Add(&blockBB.Min, &v, &Blocks.MinBB[block]);
-				Vector3_Add(&blockBB.Max, &v, &Blocks.MaxBB[block]);
+				Vector3_Add(&blockBB.Min, &v, &desc->MinBB);
+				Vector3_Add(&blockBB.Max, &v, &desc->MaxBB);
 				if (!AABB_Intersects(&blockBB, bounds)) continue;
 
 				modifier = min(modifier, Blocks.SpeedMultiplier[block]);
-				if (Blocks.ExtendedCollide[block] == COLLIDE_LIQUID) {
+				if (desc->ExtendedCollide == COLLIDE_LIQUID) {
 					comp->UseLiquidGravity = true;
 				}
 			}
@@ -18,6 +18,11 @@ struct AnimatedComp {
 
 	float LeftLegX, LeftLegZ, RightLegX, RightLegZ;
 	float LeftArmX, LeftArmZ, RightArmX, RightArmZ;
+	/* Entities in further LOD tiers only update animation every few ticks. */
+	/* LodPos is where the entity was when animation was last updated, LodTicks is */
+	/* number of ticks since then, and LodSpan is ticks covered by the last update. */
+	Vector3 LodPos;
+	uint8_t LodTicks, LodSpan;
 };
 
 void AnimatedComp_Init(struct AnimatedComp* anim);
@@ -87,16 +92,15 @@ void LocalInterpComp_SetLocation(struct InterpComp* interp, struct LocationUpdat
 void LocalInterpComp_AdvanceState(struct InterpComp* interp);
 
 /* Entity component that performs interpolation for network players */
-struct NetInterpComp {
-	InterpComp_Layout
-	/* Last known position and orientation sent by the server */
-	struct InterpState Cur;
-	int StatesCount;
-	struct InterpState States[10];
-};
-
-void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpdate* update, bool interpolate);
-void NetInterpComp_AdvanceState(struct NetInterpComp* interp);
+/* NOTE: State for all network players is stored in NetInterp, indexed by entity ID. (See Entity.h) */
+/* Resets interpolation state of the given network entity. */
+void NetInterpComp_Reset(EntityID id);
+/* Applies the given location update to the given network entity. */
+void NetInterpComp_SetLocation(EntityID id, struct LocationUpdate* update, bool interpolate);
+/* Advances interpolation state of all network entities by one tick. */
+void NetInterpComp_AdvanceAll(void);
+/* Sets entity's current position and orientation, interpolated between previous and next tick. */
+void NetInterpComp_GetCurrent(EntityID id, struct Entity* entity, float t);
 
 /* Entity component that draws square and circle shadows beneath entities */
 
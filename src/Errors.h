@@ -35,6 +35,11 @@ enum ERRORS_ALL {
 	GZIP_ERR_HEADER1, GZIP_ERR_HEADER2, GZIP_ERR_METHOD, GZIP_ERR_FLAGS,
 	/* ZLIB header decoding errors */
 	ZLIB_ERR_METHOD, ZLIB_ERR_WINDOW_SIZE, ZLIB_ERR_FLAGS,
+	/* DEFLATE decompression errors */
+	INF_ERR_BLOCKTYPE, INF_ERR_LEN_VERIFY, INF_ERR_REPEAT_BEG, INF_ERR_REPEAT_END,
+	INF_ERR_INVALID_CODE, INF_ERR_NUM_CODES,
+	/* Compressed network stream errors */
+	NET_ERR_COMP_FINAL_BLOCK,
 	/* FCM map decoding errors */
 	FCM_ERR_IDENTIFIER, FCM_ERR_REVISION,
 	/* LVL map decoding errors */
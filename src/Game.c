@@ -448,6 +448,7 @@ static void Game_Load(void) {
 
 	InputHandler_Init();
 	Game_AddComponent(&Blocks_Component);
+	Game_AddComponent(&World_Component);
 	Game_AddComponent(&Drawer2D_Component);
 
 	Game_AddComponent(&Chat_Component);
@@ -120,9 +120,11 @@ static void Gui_FileChanged(void* obj, struct Stream* stream, const String* name
 	}
 }
 
+static void TextCache_ContextLost(void* obj);
 static void Gui_Init(void) {
 	Event_RegisterVoid(&ChatEvents.FontChanged,     NULL, Gui_FontChanged);
 	Event_RegisterEntry(&TextureEvents.FileChanged, NULL, Gui_FileChanged);
+	Event_RegisterVoid(&GfxEvents.ContextLost,      NULL, TextCache_ContextLost);
 	Gui_LoadOptions();
 
 	Gui_Status = StatusScreen_MakeInstance();
@@ -142,6 +144,8 @@ static void Gui_Reset(void) {
 static void Gui_Free(void) {
 	Event_UnregisterVoid(&ChatEvents.FontChanged,     NULL, Gui_FontChanged);
 	Event_UnregisterEntry(&TextureEvents.FileChanged, NULL, Gui_FileChanged);
+	Event_UnregisterVoid(&GfxEvents.ContextLost,      NULL, TextCache_ContextLost);
+	TextCache_ContextLost(NULL);
 	Gui_CloseActive();
 	Elem_TryFree(Gui_Status);
 	Elem_TryFree(Gui_HUD);
@@ -347,3 +351,109 @@ void TextAtlas_AddInt(struct TextAtlas* atlas, int value, VertexP3fT2fC4b** vert
 		TextAtlas_Add(atlas, digits[i] - '0' , vertices);
 	}
 }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------TextCache---------------------------------------------------------*
+*#########################################################################################################################*/
+#define TEXTCACHE_MAX_SHELVES (TEXTCACHE_HEIGHT / 8)
+struct TextCacheShelf { int16_t Y, Height, CurX; uint32_t Gen, LastUsed; };
+
+GfxResourceID TextCache_TexId;
+static struct TextCacheShelf textCache_shelves[TEXTCACHE_MAX_SHELVES];
+static int textCache_shelvesCount, textCache_usedY;
+static uint32_t textCache_batch = 1, textCache_gen;
+
+void TextCache_NextBatch(void) { textCache_batch++; }
+
+static void TextCache_MakeTexture(void) {
+	Bitmap bmp;
+	Bitmap_AllocateClearedPow2(&bmp, TEXTCACHE_WIDTH, TEXTCACHE_HEIGHT);
+	{
+		TextCache_TexId = Gfx_CreateTexture(&bmp, false, false);
+	}
+	Mem_Free(bmp.Scan0);
+}
+
+/* Returns index of the shelf text of the given size should be packed into, or -1 if none */
+static int TextCache_FindShelf(int width, int height) {
+	struct TextCacheShelf* shelf;
+	uint32_t oldest = textCache_batch;
+	int i, evict = -1;
+
+	for (i = 0; i < textCache_shelvesCount; i++) {
+		shelf = &textCache_shelves[i];
+		/* Don't put short text in much taller shelves, as that wastes the space below it */
+		if (height > shelf->Height || height + 8 < shelf->Height) continue;
+		if (shelf->CurX + width <= TEXTCACHE_WIDTH) return i;
+	}
+
+	if (textCache_shelvesCount < TEXTCACHE_MAX_SHELVES && textCache_usedY + height <= TEXTCACHE_HEIGHT) {
+		shelf = &textCache_shelves[textCache_shelvesCount];
+		shelf->Y      = textCache_usedY;
+		shelf->Height = (height + 7) & ~7;
+		shelf->CurX   = 0;
+		shelf->Gen    = ++textCache_gen;
+		textCache_usedY += shelf->Height;
+		return textCache_shelvesCount++;
+	}
+
+	/* Atlas is full, so throw away all the text in the least recently used shelf */
+	for (i = 0; i < textCache_shelvesCount; i++) {
+		shelf = &textCache_shelves[i];
+		if (height > shelf->Height || shelf->LastUsed >= oldest) continue;
+		evict = i; oldest = shelf->LastUsed;
+	}
+	if (evict == -1) return -1;
+
+	shelf = &textCache_shelves[evict];
+	shelf->CurX = 0;
+	shelf->Gen  = ++textCache_gen;
+	return evict;
+}
+
+bool TextCache_Add(struct TextCacheEntry* entry, Bitmap* bmp) {
+	struct TextCacheShelf* shelf;
+	int i, x;
+
+	entry->Gen = 0;
+	/* Leave a 1 pixel gap between text, so text is never sampled from neighbouring text */
+	if (bmp->Width + 1 > TEXTCACHE_WIDTH || bmp->Height > TEXTCACHE_HEIGHT) return false;
+	if (!TextCache_TexId) TextCache_MakeTexture();
+
+	i = TextCache_FindShelf(bmp->Width + 1, bmp->Height);
+	if (i == -1) return false;
+	shelf = &textCache_shelves[i];
+
+	x = shelf->CurX;
+	Gfx_UpdateTexturePart(TextCache_TexId, x, shelf->Y, bmp, false);
+	shelf->CurX    += bmp->Width + 1;
+	shelf->LastUsed = textCache_batch;
+
+	entry->uv.U1  = (float)x / TEXTCACHE_WIDTH;
+	entry->uv.V1  = (float)shelf->Y / TEXTCACHE_HEIGHT;
+	entry->uv.U2  = (float)(x + bmp->Width) / TEXTCACHE_WIDTH;
+	entry->uv.V2  = (float)(shelf->Y + bmp->Height) / TEXTCACHE_HEIGHT;
+	entry->Width  = bmp->Width;
+	entry->Height = bmp->Height;
+	entry->Shelf  = i;
+	entry->Gen    = shelf->Gen;
+	return true;
+}
+
+bool TextCache_Use(struct TextCacheEntry* entry) {
+	struct TextCacheShelf* shelf;
+	if (!entry->Gen || entry->Shelf >= textCache_shelvesCount) return false;
+
+	shelf = &textCache_shelves[entry->Shelf];
+	if (shelf->Gen != entry->Gen) return false;
+	shelf->LastUsed = textCache_batch;
+	return true;
+}
+
+static void TextCache_ContextLost(void* obj) {
+	Gfx_DeleteTexture(&TextCache_TexId);
+	/* Text in the cache is lost too, and shelves are given new generations when remade */
+	textCache_shelvesCount = 0;
+	textCache_usedY        = 0;
+}
@@ -3,6 +3,7 @@
 #include "Input.h"
 #include "Event.h"
 #include "VertexStructs.h"
+#include "Bitmap.h"
 /* Describes and manages 2D GUI elements on screen.
    Copyright 2014-2017 ClassicalSharp | Licensed under BSD-3
 */
@@ -139,6 +140,27 @@ void TextAtlas_Free(struct TextAtlas* atlas);
 void TextAtlas_Add(struct TextAtlas* atlas, int charI, VertexP3fT2fC4b** vertices);
 void TextAtlas_AddInt(struct TextAtlas* atlas, int value, VertexP3fT2fC4b** vertices);
 
+/* Dynamic texture atlas shared by short lived text, such as names above entities. */
+/* Text is packed into shelves (horizontal rows), and when the atlas is full, the shelf */
+/*  least recently drawn from is evicted. Owners must then re-add their text. */
+#define TEXTCACHE_WIDTH  1024
+#define TEXTCACHE_HEIGHT 2048
+struct TextCacheEntry {
+	TextureRec uv;
+	int16_t Width, Height;
+	int16_t Shelf;
+	uint32_t Gen; /* Generation of the shelf the text was packed into, 0 if none */
+};
+/* Texture containing all the text in the cache. */
+extern GfxResourceID TextCache_TexId;
+/* Starts a new batch of text to be drawn. Text used in the current batch is never evicted. */
+void TextCache_NextBatch(void);
+/* Packs the given bitmap into the atlas, marking it as used in the current batch. */
+/* Returns false if there was no room, as all large enough shelves are used in this batch. */
+bool TextCache_Add(struct TextCacheEntry* entry, Bitmap* bmp);
+/* Returns whether the given text is still in the atlas, also marking it as used in the current batch. */
+bool TextCache_Use(struct TextCacheEntry* entry);
+
 
 #define Elem_Init(elem)           (elem)->VTABLE->Init(elem)
 #define Elem_Render(elem, delta)  (elem)->VTABLE->Render(elem, delta)
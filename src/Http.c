@@ -4,6 +4,8 @@
 #include "Logger.h"
 #include "Stream.h"
 #include "GameStructs.h"
+#include "Options.h"
+#include "Errors.h"
 
 #ifdef CC_BUILD_WIN
 #define WIN32_LEAN_AND_MEAN
@@ -29,6 +31,31 @@
 #include <time.h>
 #endif
 
+/* Maximum number of threads that perform HTTP requests. (see OPT_HTTP_WORKERS) */
+#define HTTP_MAX_WORKERS 8
+/* State for a thread that performs HTTP requests */
+struct HttpWorker {
+	void* Thread;
+	struct HttpRequest Request; /* Copy of request currently being processed */
+	volatile int Progress;      /* Progress of request currently being processed */
+	bool PriorityOnly;          /* Whether this worker only processes priority requests */
+	int Index;                  /* Index of this worker, used to give it its own temp files */
+	struct HttpRequest* Cur;    /* Request currently being processed */
+#ifdef CC_BUILD_WIN
+	void* Handle;           /* Handle of response currently being streamed */
+	uint32_t Received;      /* Number of bytes of streamed response read so far */
+#endif
+#ifdef CC_BUILD_POSIX
+	CURL* Curl;
+	CURLM* Multi;           /* Drives Curl when response contents are streamed */
+	uint32_t BufferSize;    /* Size of buffer allocated for response data */
+	uint8_t* Pending;       /* Streamed response data not yet read by the processor */
+	uint32_t PendingCapacity, PendingBeg, PendingEnd;
+	bool Done;              /* Whether the streamed transfer has finished */
+	CURLcode TransferResult;
+#endif
+};
+
 void HttpRequest_Free(struct HttpRequest* request) {
 	Mem_Free(request->Data);
 	request->Data = NULL;
@@ -36,6 +63,614 @@ void HttpRequest_Free(struct HttpRequest* request) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------------Disk cache-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Response contents are stored in files named by their CRC32 and size, so identical contents share a file. */
+/* httpcache/index.txt is a log of changes to entries, and is only rewritten in full when it gets too long. */
+struct DiskCacheEntry {
+	char URL[URL_MAX_SIZE];  /* URL contents were downloaded from */
+	char Etag[STRING_SIZE];  /* ETag of contents (if any) */
+	TimeMS LastModified;     /* Last modified time of contents (if any) */
+	TimeMS LastAccessed;     /* Time contents were last downloaded or used */
+	uint32_t Hash, Size;     /* CRC32 and size of contents */
+	uint32_t UrlHash;        /* CRC32 of URL (not saved in index) */
+};
+
+#define DISKCACHE_DEF_ELEMS 32
+#define DISKCACHE_DEF_SLOTS (DISKCACHE_DEF_ELEMS * 2)
+static struct DiskCacheEntry diskCache_defEntries[DISKCACHE_DEF_ELEMS];
+static struct DiskCacheEntry* diskCache_entries = diskCache_defEntries;
+static uint32_t diskCache_count, diskCache_capacity = DISKCACHE_DEF_ELEMS;
+/* Open addressing hash table of entries by URL. Each slot is index of entry + 1, or 0 if empty. */
+static int diskCache_defSlots[DISKCACHE_DEF_SLOTS];
+static int* diskCache_slots = diskCache_defSlots;
+static uint32_t diskCache_slotsMask = DISKCACHE_DEF_SLOTS - 1;
+static int diskCache_logLines;
+/* Whether last accessed time of any entry changed since the index was last written in full */
+static bool diskCache_touched;
+static uint64_t diskCache_size, diskCache_maxSize;
+static void* diskCache_mutex;
+const static String diskCache_index = String_FromConst("httpcache/index.txt");
+
+static void DiskCache_MakePath(String* path, uint32_t hash, uint32_t size) {
+	String_Format2(path, "httpcache/%h-%i", &hash, &size);
+}
+
+/* Contents are first written to a temp file, since their hash isn't known until they've all been downloaded */
+/* NOTE: Same URL may be downloaded by several workers at once, so each worker has its own temp file */
+static void DiskCache_MakePartPath(String* path, const String* url, struct HttpWorker* w) {
+	uint32_t hash = Utils_CRC32((const uint8_t*)url->buffer, url->length);
+	String_Format2(path, "httpcache/%h-%i.part", &hash, &w->Index);
+}
+
+static uint32_t DiskCache_HashUrl(const String* url) {
+	return Utils_CRC32((const uint8_t*)url->buffer, url->length);
+}
+
+static int DiskCache_Find(const String* url) {
+	uint32_t slot = DiskCache_HashUrl(url) & diskCache_slotsMask;
+	String entryUrl;
+	int i;
+
+	/* Different URLs may have the same hash, so the full URL must always be compared */
+	for (; diskCache_slots[slot]; slot = (slot + 1) & diskCache_slotsMask) {
+		i = diskCache_slots[slot] - 1;
+		entryUrl = String_FromRawArray(diskCache_entries[i].URL);
+		if (String_Equals(url, &entryUrl)) return i;
+	}
+	return -1;
+}
+
+static uint32_t DiskCache_SlotOf(int i) {
+	uint32_t slot = diskCache_entries[i].UrlHash & diskCache_slotsMask;
+	while (diskCache_slots[slot] != i + 1) { slot = (slot + 1) & diskCache_slotsMask; }
+	return slot;
+}
+
+static void DiskCache_Link(int i) {
+	uint32_t slot = diskCache_entries[i].UrlHash & diskCache_slotsMask;
+	while (diskCache_slots[slot]) { slot = (slot + 1) & diskCache_slotsMask; }
+	diskCache_slots[slot] = i + 1;
+}
+
+/* Clears the slot of the given entry, moving back later slots so lookups don't stop early at the empty slot */
+static void DiskCache_Unlink(int i) {
+	uint32_t mask = diskCache_slotsMask, hole = DiskCache_SlotOf(i), slot, home;
+	diskCache_slots[hole] = 0;
+
+	for (slot = (hole + 1) & mask; diskCache_slots[slot]; slot = (slot + 1) & mask) {
+		home = diskCache_entries[diskCache_slots[slot] - 1].UrlHash & mask;
+		/* Can only move back if the hole is between home slot and this slot */
+		if (((slot - home) & mask) < ((slot - hole) & mask)) continue;
+
+		diskCache_slots[hole] = diskCache_slots[slot];
+		diskCache_slots[slot] = 0;
+		hole = slot;
+	}
+}
+
+/* Rebuilds the hash table, growing it if it would be over half full at current capacity */
+static void DiskCache_Rehash(void) {
+	uint32_t size = diskCache_slotsMask + 1;
+	int i;
+
+	if (size < diskCache_capacity * 2) {
+		while (size < diskCache_capacity * 2) size *= 2;
+		if (diskCache_slots != diskCache_defSlots) Mem_Free(diskCache_slots);
+
+		diskCache_slots     = Mem_Alloc(size, sizeof(int), "http cache slots");
+		diskCache_slotsMask = size - 1;
+	}
+
+	Mem_Set(diskCache_slots, 0, size * sizeof(int));
+	for (i = 0; i < diskCache_count; i++) { DiskCache_Link(i); }
+}
+
+/* Adds the given entry, or replaces the existing entry for the same URL */
+static void DiskCache_Put(struct DiskCacheEntry* e) {
+	String url = String_FromRawArray(e->URL);
+	int i = DiskCache_Find(&url);
+	e->UrlHash = DiskCache_HashUrl(&url);
+
+	if (i == -1) {
+		if (diskCache_count == diskCache_capacity) {
+			diskCache_entries = Utils_Resize(diskCache_entries, &diskCache_capacity,
+										sizeof(struct DiskCacheEntry), DISKCACHE_DEF_ELEMS, 32);
+			DiskCache_Rehash();
+		}
+		i = diskCache_count++;
+		diskCache_entries[i] = *e;
+		DiskCache_Link(i);
+	} else {
+		diskCache_size -= diskCache_entries[i].Size;
+		diskCache_entries[i] = *e;
+	}
+	diskCache_size += e->Size;
+}
+
+/* Whether any entry has contents with the given hash and size */
+static bool DiskCache_Shared(uint32_t hash, uint32_t size, int ignore) {
+	int i;
+	for (i = 0; i < diskCache_count; i++) {
+		if (i == ignore) continue;
+		if (diskCache_entries[i].Hash == hash && diskCache_entries[i].Size == size) return true;
+	}
+	return false;
+}
+
+/* Removes the given entry, also deleting its file if no other entry shares it */
+static void DiskCache_RemoveAt(int i, bool deleteFile) {
+	String path; char pathBuffer[FILENAME_SIZE];
+	struct DiskCacheEntry* e = &diskCache_entries[i];
+	int last;
+	diskCache_size -= e->Size;
+
+	if (deleteFile && !DiskCache_Shared(e->Hash, e->Size, i)) {
+		String_InitArray(path, pathBuffer);
+		DiskCache_MakePath(&path, e->Hash, e->Size);
+		File_Delete(&path);
+	}
+
+	DiskCache_Unlink(i);
+	last = --diskCache_count;
+	if (i == last) return;
+
+	/* Move last entry into the gap, instead of shifting down all the later entries */
+	diskCache_slots[DiskCache_SlotOf(last)] = i + 1;
+	diskCache_entries[i] = diskCache_entries[last];
+}
+
+/* Formats an entry as: [url] [hash] [size] [last accessed] [last modified] [etag] */
+static void DiskCache_Format(String* line, struct DiskCacheEntry* e) {
+	String url  = String_FromRawArray(e->URL);
+	String etag = String_FromRawArray(e->Etag);
+
+	String_AppendString(line, &url);           String_Append(line, ' ');
+	String_AppendUInt32(line, e->Hash);         String_Append(line, ' ');
+	String_AppendUInt32(line, e->Size);         String_Append(line, ' ');
+	String_AppendUInt64(line, e->LastAccessed); String_Append(line, ' ');
+	String_AppendUInt64(line, e->LastModified); String_Append(line, ' ');
+	String_AppendString(line, &etag);
+}
+
+static bool DiskCache_Parse(const String* line, struct DiskCacheEntry* e) {
+	String parts[6], tmp;
+	uint64_t hash, size;
+
+	if (String_UNSAFE_Split(line, ' ', parts, 6) != 6) return false;
+	if (parts[0].length >= URL_MAX_SIZE || parts[5].length >= STRING_SIZE) return false;
+
+	if (!Convert_ParseUInt64(&parts[1], &hash))            return false;
+	if (!Convert_ParseUInt64(&parts[2], &size))            return false;
+	if (!Convert_ParseUInt64(&parts[3], &e->LastAccessed)) return false;
+	if (!Convert_ParseUInt64(&parts[4], &e->LastModified)) return false;
+	e->Hash = (uint32_t)hash;
+	e->Size = (uint32_t)size;
+
+	tmp = String_ClearedArray(e->URL);
+	String_AppendString(&tmp, &parts[0]);
+	tmp = String_ClearedArray(e->Etag);
+	String_AppendString(&tmp, &parts[5]);
+	return true;
+}
+
+/* Rewrites the index, so it only contains a line for each entry */
+static void DiskCache_Compact(void) {
+	const static String path = String_FromConst("httpcache/index.tmp");
+	String line; char lineBuffer[URL_MAX_SIZE + STRING_SIZE + 80];
+	struct Stream stream;
+	ReturnCode res, closeRes;
+	int i;
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Platform_Log2("Error %i creating %s", &res, &path); return; }
+
+	for (i = 0; !res && i < diskCache_count; i++) {
+		String_InitArray(line, lineBuffer);
+		DiskCache_Format(&line, &diskCache_entries[i]);
+		res = Stream_WriteLine(&stream, &line);
+	}
+
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	if (!res) res = File_Rename(&path, &diskCache_index);
+
+	if (res) { Platform_Log2("Error %i writing %s", &res, &path); return; }
+	diskCache_logLines = diskCache_count;
+	diskCache_touched  = false;
+}
+
+/* Appends a line to the index, or compacts the index instead if it has too many outdated lines */
+static void DiskCache_Log(String* line) {
+	FileHandle file;
+	struct Stream stream;
+	ReturnCode res, closeRes;
+
+	if (diskCache_logLines >= diskCache_count * 2 + 64) { DiskCache_Compact(); return; }
+	res = File_Append(&file, &diskCache_index);
+	if (res) { Platform_Log2("Error %i opening %s", &res, &diskCache_index); return; }
+
+	Stream_FromFile(&stream, file);
+	res      = Stream_WriteLine(&stream, line);
+	closeRes = stream.Close(&stream);
+
+	if (!res) res = closeRes;
+	if (res) { Platform_Log2("Error %i writing %s", &res, &diskCache_index); return; }
+	diskCache_logLines++;
+}
+
+/* Removes the entry for the given URL (if any), then logs that it was removed in the index */
+static void DiskCache_Remove(const String* url) {
+	String line; char lineBuffer[URL_MAX_SIZE];
+	int i;
+
+	Mutex_Lock(diskCache_mutex);
+	{
+		if ((i = DiskCache_Find(url)) >= 0) {
+			/* A line with just the URL means the entry was removed */
+			String_InitArray(line, lineBuffer);
+			String_AppendString(&line, url);
+			DiskCache_RemoveAt(i, true);
+			DiskCache_Log(&line);
+		}
+	}
+	Mutex_Unlock(diskCache_mutex);
+}
+
+/* Sorts entries from most to least recently used */
+static void DiskCache_QuickSort(int left, int right) {
+	struct DiskCacheEntry* keys = diskCache_entries; struct DiskCacheEntry key;
+
+	while (left < right) {
+		int i = left, j = right;
+		TimeMS mid = keys[(i + j) >> 1].LastAccessed;
+
+		/* partition the list */
+		while (i <= j) {
+			while (mid < keys[i].LastAccessed) i++;
+			while (mid > keys[j].LastAccessed) j--;
+			QuickSort_Swap_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(DiskCache_QuickSort)
+	}
+}
+
+/* Removes least recently used entries until total size is under the limit. */
+/* NOTE: Most recently used entry is never removed, even if it alone is over the limit. */
+static void DiskCache_Evict(void) {
+	String line; char lineBuffer[URL_MAX_SIZE];
+	String path; char pathBuffer[FILENAME_SIZE];
+	struct DiskCacheEntry* e;
+	uint32_t mask, slot;
+	int i, count, *kept;
+	if (diskCache_size <= diskCache_maxSize || diskCache_count <= 1) return;
+
+	/* Sorting once means the removed entries are just the last ones */
+	DiskCache_QuickSort(0, diskCache_count - 1);
+	for (count = diskCache_count; diskCache_size > diskCache_maxSize && count > 1; count--) {
+		diskCache_size -= diskCache_entries[count - 1].Size;
+	}
+
+	/* Hash table of the contents of kept entries, since removed entries may share their files */
+	for (mask = 1; mask < count * 2; mask *= 2) {}
+	kept = Mem_AllocCleared(mask, sizeof(int), "http cache evict");
+	mask--;
+
+	for (i = 0; i < count; i++) {
+		slot = diskCache_entries[i].Hash & mask;
+		while (kept[slot]) { slot = (slot + 1) & mask; }
+		kept[slot] = i + 1;
+	}
+
+	/* Removed entries must not be written if the index gets compacted while logging them */
+	i = diskCache_count;
+	diskCache_count = count;
+	DiskCache_Rehash();
+
+	for (; i > count; i--) {
+		e = &diskCache_entries[i - 1];
+		for (slot = e->Hash & mask; kept[slot]; slot = (slot + 1) & mask) {
+			if (diskCache_entries[kept[slot] - 1].Hash == e->Hash && diskCache_entries[kept[slot] - 1].Size == e->Size) break;
+		}
+
+		if (!kept[slot]) {
+			String_InitArray(path, pathBuffer);
+			DiskCache_MakePath(&path, e->Hash, e->Size);
+			File_Delete(&path);
+		}
+
+		/* A line with just the URL means the entry was removed */
+		String_InitArray(line, lineBuffer);
+		String_AppendConst(&line, e->URL);
+		DiskCache_Log(&line);
+	}
+	Mem_Free(kept);
+}
+
+/* Copies the entry for the given URL, and marks it as just used. */
+/* NOTE: Access times are only saved when the index is next rewritten, rather than logged on every use */
+static bool DiskCache_Get(const String* url, struct DiskCacheEntry* e, bool touch) {
+	int i;
+
+	Mutex_Lock(diskCache_mutex);
+	{
+		i = DiskCache_Find(url);
+		if (i >= 0 && touch) {
+			diskCache_entries[i].LastAccessed = DateTime_CurrentUTC_MS();
+			diskCache_touched = true;
+		}
+		if (i >= 0) *e = diskCache_entries[i];
+	}
+	Mutex_Unlock(diskCache_mutex);
+	return i >= 0;
+}
+
+static ReturnCode DiskCache_Open(struct DiskCacheEntry* e, struct Stream* stream) {
+	String path; char pathBuffer[FILENAME_SIZE];
+	String_InitArray(path, pathBuffer);
+
+	DiskCache_MakePath(&path, e->Hash, e->Size);
+	return Stream_OpenFile(stream, &path);
+}
+
+/* Whether the two files have exactly the same contents */
+static bool DiskCache_SameFile(const String* pathA, const String* pathB, uint32_t size) {
+	struct Stream a, b;
+	uint8_t bufferA[2048], bufferB[2048];
+	uint32_t count, i;
+	bool same = false;
+
+	if (Stream_OpenFile(&a, pathA)) return false;
+	if (Stream_OpenFile(&b, pathB)) { a.Close(&a); return false; }
+
+	for (; size; size -= count) {
+		count = min(size, sizeof(bufferA));
+		if (Stream_Read(&a, bufferA, count) || Stream_Read(&b, bufferB, count)) break;
+
+		for (i = 0; i < count && bufferA[i] == bufferB[i]; i++) {}
+		if (i < count) break;
+	}
+
+	same = size == 0;
+	a.Close(&a); b.Close(&b);
+	return same;
+}
+
+/* Adds an entry for the given request, whose contents have been written to the given file */
+/* NOTE: CRC32 and size can be the same for different contents, in which case the contents are not cached */
+static void DiskCache_Add(struct HttpRequest* req, const String* path, uint32_t hash, uint32_t size) {
+	String url = String_FromRawArray(req->URL);
+	String file; char fileBuffer[FILENAME_SIZE];
+	String line; char lineBuffer[URL_MAX_SIZE + STRING_SIZE + 80];
+	struct DiskCacheEntry e;
+	bool collided = false;
+	ReturnCode res = 0;
+
+	Mem_Copy(e.URL,  req->URL,  sizeof(e.URL));
+	Mem_Copy(e.Etag, req->Etag, sizeof(e.Etag));
+	e.LastModified = req->LastModified;
+	e.LastAccessed = DateTime_CurrentUTC_MS();
+	e.Hash = hash;
+	e.Size = size;
+
+	/* Can only revalidate contents without either header using time downloaded (like old texture cache) */
+	if (!e.Etag[0] && !e.LastModified) e.LastModified = e.LastAccessed;
+	String_InitArray(line, lineBuffer);
+	DiskCache_Format(&line, &e);
+	String_InitArray(file, fileBuffer);
+	DiskCache_MakePath(&file, hash, size);
+
+	/* File must not be evicted by another worker in between being created and its entry being added */
+	Mutex_Lock(diskCache_mutex);
+	{
+		if (!File_Exists(&file) || !DiskCache_Shared(hash, size, -1)) {
+			res = File_Rename(path, &file);
+		} else if (DiskCache_SameFile(path, &file, size)) {
+			File_Delete(path);
+		} else {
+			collided = true;
+		}
+
+		if (!res && !collided) {
+			DiskCache_Put(&e);
+			DiskCache_Log(&line);
+			DiskCache_Evict();
+		}
+	}
+	Mutex_Unlock(diskCache_mutex);
+
+	if (collided) {
+		Platform_Log2("Contents of %s have same hash as %s", &url, &file);
+		File_Delete(path);
+	}
+	if (res) { Platform_Log2("Error %i creating %s", &res, &file); File_Delete(path); }
+}
+
+/* Writes buffered contents of a response to the cache */
+/* NOTE: Unlike streamed responses, these are only cached if they can be revalidated */
+static void DiskCache_AddData(struct HttpWorker* w, struct HttpRequest* req) {
+	String url = String_FromRawArray(req->URL);
+	String path; char pathBuffer[FILENAME_SIZE];
+	ReturnCode res;
+
+	if (!req->Etag[0] && !req->LastModified) return;
+	String_InitArray(path, pathBuffer);
+	DiskCache_MakePartPath(&path, &url, w);
+
+	res = Stream_WriteAllTo(&path, req->Data, req->Size);
+	if (res) { Platform_Log2("Error %i caching %s", &res, &url); File_Delete(&path); return; }
+	DiskCache_Add(req, &path, Utils_CRC32(req->Data, req->Size), req->Size);
+}
+
+struct DiskCacheWriter {
+	struct Stream* Source; /* Stream response contents are read from */
+	struct Stream File;    /* Stream to temp file contents are written to */
+	struct Stream Crc;     /* Calculates CRC32 of contents while writing them to File */
+	uint32_t Size;         /* Number of bytes of contents read so far */
+	ReturnCode Res;        /* Error that occurred while writing contents (if any) */
+};
+
+static ReturnCode DiskCache_TeeRead(struct Stream* s, uint8_t* data, uint32_t count, uint32_t* modified) {
+	struct DiskCacheWriter* w = (struct DiskCacheWriter*)s->Meta.Http;
+	ReturnCode res = w->Source->Read(w->Source, data, count, modified);
+	if (res || !(*modified) || w->Res) return res;
+
+	w->Res   = Stream_Write(&w->Crc, data, *modified);
+	w->Size += *modified;
+	return 0;
+}
+
+/* Passes the contents of a response to the request's processor, while also writing them to the cache */
+static ReturnCode Http_ProcessBody(struct HttpWorker* worker, struct HttpRequest* req, struct Stream* body) {
+	String url = String_FromRawArray(req->URL);
+	String path; char pathBuffer[FILENAME_SIZE];
+	struct DiskCacheWriter w;
+	struct Stream tee;
+	uint8_t tmp[4096];
+	uint32_t read;
+	ReturnCode res;
+
+	String_InitArray(path, pathBuffer);
+	DiskCache_MakePartPath(&path, &url, worker);
+	res = Stream_CreateFile(&w.File, &path);
+	if (res) { Platform_Log2("Error %i caching %s", &res, &url); return req->Processor(req, body); }
+
+	Stream_WriteonlyCrc32(&w.Crc, &w.File);
+	w.Source = body;
+	w.Size   = 0;
+	w.Res    = 0;
+
+	Stream_Init(&tee);
+	tee.Read      = DiskCache_TeeRead;
+	tee.Meta.Http = &w;
+	res = req->Processor(req, &tee);
+
+	/* Processor may not need all of the contents (e.g. data after end of a PNG) */
+	while (!res) {
+		res = tee.Read(&tee, tmp, sizeof(tmp), &read);
+		if (!read) break;
+	}
+
+	if (!w.Res) w.Res = w.File.Close(&w.File);
+	else w.File.Close(&w.File);
+
+	if (!res && !w.Res && w.Size) {
+		DiskCache_Add(req, &path, w.Crc.Meta.CRC32.CRC32 ^ 0xFFFFFFFFUL, w.Size);
+	} else {
+		if (w.Res) Platform_Log2("Error %i caching %s", &w.Res, &url);
+		File_Delete(&path);
+	}
+	return res;
+}
+
+/* Sends the validators of the cached copy of contents (if any), so the server can reply with 304 if still up to date */
+static bool DiskCache_Prepare(struct HttpRequest* req, struct DiskCacheEntry* e) {
+	String url;
+	/* Requests with their own validators expect to handle 304 responses themselves */
+	if (req->RequestType != REQUEST_TYPE_GET || req->Etag[0] || req->LastModified) return false;
+
+	url = String_FromRawArray(req->URL);
+	if (!DiskCache_Get(&url, e, false)) return false;
+
+	Mem_Copy(req->Etag, e->Etag, sizeof(req->Etag));
+	req->LastModified = e->LastModified;
+	return true;
+}
+
+/* Uses the cached copy of contents as the response, after the server replied that it is still up to date */
+static ReturnCode DiskCache_Serve(struct HttpRequest* req, struct DiskCacheEntry* e) {
+	String url = String_FromRawArray(req->URL);
+	struct Stream stream, buffered;
+	uint8_t buffer[4096];
+	ReturnCode res, closeRes;
+
+	if (!DiskCache_Get(&url, e, true)) return ReturnCode_FileNotFound;
+	if ((res = DiskCache_Open(e, &stream))) return res;
+
+	if (req->Processor) {
+		/* Decoders usually read small amounts at a time */
+		Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+		res = req->Processor(req, &buffered);
+	} else {
+		req->Data = Mem_Alloc(e->Size, 1, "http cached data");
+		req->Size = e->Size;
+		res = Stream_Read(&stream, req->Data, e->Size);
+	}
+
+	closeRes = stream.Close(&stream);
+	if (res) { HttpRequest_Free(req); return res; }
+
+	Mem_Copy(req->Etag, e->Etag, sizeof(req->Etag));
+	req->LastModified = e->LastModified;
+	return closeRes;
+}
+
+static void DiskCache_Load(void) {
+	String line; char lineBuffer[URL_MAX_SIZE + STRING_SIZE + 80];
+	struct DiskCacheEntry e;
+	uint8_t buffer[2048];
+	struct Stream stream, buffered;
+	ReturnCode res;
+	int i;
+
+	diskCache_mutex   = Mutex_Create();
+	diskCache_maxSize = (uint64_t)Options_GetInt(OPT_HTTP_CACHE_SIZE, 1, 4096, 128) * 1024 * 1024;
+	if (!Utils_EnsureDirectory("httpcache")) return;
+
+	res = Stream_OpenFile(&stream, &diskCache_index);
+	if (res == ReturnCode_FileNotFound) return;
+	if (res) { Logger_Warn2(res, "opening", &diskCache_index); return; }
+
+	/* ReadLine reads single byte at a time */
+	Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+	String_InitArray(line, lineBuffer);
+
+	for (;;) {
+		res = Stream_ReadLine(&buffered, &line);
+		if (res == ERR_END_OF_STREAM) break;
+		if (res) { Logger_Warn2(res, "reading from", &diskCache_index); break; }
+		if (!line.length) continue;
+
+		diskCache_logLines++;
+		if (DiskCache_Parse(&line, &e)) {
+			DiskCache_Put(&e);
+		} else if ((i = DiskCache_Find(&line)) >= 0) {
+			DiskCache_RemoveAt(i, false);
+		}
+	}
+
+	res = stream.Close(&stream);
+	if (res) { Logger_Warn2(res, "closing", &diskCache_index); }
+	DiskCache_Evict();
+}
+
+static void DiskCache_Free(void) {
+	if (diskCache_touched) DiskCache_Compact();
+	if (diskCache_entries != diskCache_defEntries) Mem_Free(diskCache_entries);
+	if (diskCache_slots   != diskCache_defSlots)   Mem_Free(diskCache_slots);
+	diskCache_entries  = diskCache_defEntries;
+	diskCache_capacity = DISKCACHE_DEF_ELEMS;
+	diskCache_count    = 0;
+	diskCache_slots     = diskCache_defSlots;
+	diskCache_slotsMask = DISKCACHE_DEF_SLOTS - 1;
+	Mem_Set(diskCache_defSlots, 0, sizeof(diskCache_defSlots));
+	diskCache_size     = 0;
+	diskCache_logLines = 0;
+	diskCache_touched  = false;
+	Mutex_Free(diskCache_mutex);
+}
+
+bool Http_OpenCached(const String* url, struct Stream* stream) {
+	struct DiskCacheEntry e;
+	if (!DiskCache_Get(url, &e, true)) return false;
+	return DiskCache_Open(&e, stream) == 0;
+}
+
+ReturnCode Http_CacheOnly(struct HttpRequest* req, struct Stream* body) { return 0; }
+
+
 /*########################################################################################################################*
 *-------------------------------------------------System/Native interface-------------------------------------------------*
 *#########################################################################################################################*/
@@ -56,6 +691,7 @@ struct HttpCacheEntry {
 };
 #define HTTP_CACHE_ENTRIES 10
 static struct HttpCacheEntry http_cache[HTTP_CACHE_ENTRIES];
+static void* http_cacheMutex;
 
 /* Splits up the components of a URL */
 static void HttpCache_MakeEntry(const String* url, struct HttpCacheEntry* entry, String* resource) {
@@ -121,7 +757,10 @@ static void Http_SysInit(void) {
 	/* TODO: Should we use INTERNET_OPEN_TYPE_PRECONFIG instead? */
 	hInternet = InternetOpenA(GAME_APP_NAME, INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
 	if (!hInternet) Logger_Abort2(GetLastError(), "Failed to init WinINet");
+	http_cacheMutex = Mutex_Create();
 }
+static void Http_SysInitWorker(struct HttpWorker* w) { }
+static void Http_SysFreeWorker(struct HttpWorker* w) { }
 
 /* Adds custom HTTP headers for a req */
 static void Http_MakeHeaders(String* headers, struct HttpRequest* req) {
@@ -164,7 +803,12 @@ static ReturnCode Http_StartRequest(struct HttpRequest* req, HINTERNET* handle)
 	Mem_Copy(pathBuffer, path.buffer, path.length);
 	pathBuffer[path.length] = '\0';
 
-	HttpCache_Lookup(&entry);
+	/* Connections are shared between all the worker threads */
+	Mutex_Lock(http_cacheMutex);
+	{
+		HttpCache_Lookup(&entry);
+	}
+	Mutex_Unlock(http_cacheMutex);
 	/* https://stackoverflow.com/questions/25308488/c-wininet-custom-http-headers */
 	String_InitArray(headers, headersBuffer);
 	Http_MakeHeaders(&headers, req);
@@ -246,17 +890,60 @@ static ReturnCode Http_DownloadData(struct HttpRequest* req, HINTERNET handle, v
 	return 0;
 }
 
-static ReturnCode Http_SysDo(struct HttpRequest* req, volatile int* progress) {
+static ReturnCode Http_StreamRead(struct Stream* s, uint8_t* data, uint32_t count, uint32_t* modified) {
+	struct HttpWorker* w = (struct HttpWorker*)s->Meta.Http;
+	DWORD read;
+
+	if (!InternetReadFile(w->Handle, data, count, &read)) return GetLastError();
+	*modified    = read;
+	w->Received += read;
+
+	if (w->Cur->ContentLength) {
+		w->Progress = (int)(100.0f * w->Received / w->Cur->ContentLength);
+	}
+	return 0;
+}
+
+/* Passes the data/contents of a HTTP response to the request's processor as they are read */
+static ReturnCode Http_StreamData(struct HttpWorker* w, struct HttpRequest* req, HINTERNET handle) {
+	struct Stream body;
+	ReturnCode res;
+
+	Stream_Init(&body);
+	body.Read      = Http_StreamRead;
+	body.Meta.Http = w;
+
+	w->Progress = 0;
+	w->Handle   = handle;
+	w->Received = 0;
+
+	res = Http_ProcessBody(w, req, &body);
+	w->Progress = 100;
+	return res;
+}
+
+static ReturnCode Http_SysDo(struct HttpWorker* w, struct HttpRequest* req) {
+	volatile int* progress = &w->Progress;
 	HINTERNET handle;
 	ReturnCode res = Http_StartRequest(req, &handle);
 	HttpRequest_Free(req);
 	if (res) return res;
 
+	/* Only the validators given in the response should be kept */
+	req->LastModified = 0;
+	req->Etag[0]      = '\0';
+
 	*progress = ASYNC_PROGRESS_FETCHING_DATA;
 	res = Http_ProcessHeaders(req, handle);
 	if (res) { InternetCloseHandle(handle); return res; }
 
-	if (req->RequestType != REQUEST_TYPE_HEAD) {
+	if (req->RequestType == REQUEST_TYPE_HEAD) {
+	} else if (req->Processor) {
+		w->Cur = req;
+		/* Processor only cares about the contents of successful responses */
+		if (req->StatusCode == 200) res = Http_StreamData(w, req, handle);
+		if (res) { InternetCloseHandle(handle); return res; }
+	} else {
 		res = Http_DownloadData(req, handle, progress);
 		if (res) { InternetCloseHandle(handle); return res; }
 	}
@@ -271,17 +958,54 @@ static void Http_SysFree(void) {
 		InternetCloseHandle(http_cache[i].Handle);
 	}
 	InternetCloseHandle(hInternet);
+	Mutex_Free(http_cacheMutex);
 }
 #endif
 #ifdef CC_BUILD_POSIX
-CURL* curl;
+static CURLSH* curl_share;
+static void* curl_shareMutexes[CURL_LOCK_DATA_LAST];
+
+/* NOTE: curl may hold the lock for one kind of data while locking another, so each needs its own lock */
+static void Http_LockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* obj) {
+	Mutex_Lock(curl_shareMutexes[data]);
+}
+static void Http_UnlockShare(CURL* handle, curl_lock_data data, void* obj) {
+	Mutex_Unlock(curl_shareMutexes[data]);
+}
 
 static void Http_SysInit(void) {
 	CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
+	int i;
 	if (res) Logger_Abort2(res, "Failed to init curl");
 
-	curl = curl_easy_init();
-	if (!curl) Logger_Abort("Failed to init easy curl");
+	curl_share = curl_share_init();
+	if (!curl_share) Logger_Abort("Failed to init curl share");
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+		curl_shareMutexes[i] = Mutex_Create();
+	}
+
+	/* Share DNS cache and connections (for keep-alive reuse) between all worker threads */
+	curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC,   Http_LockShare);
+	curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC, Http_UnlockShare);
+	curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x073900
+	curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+static void Http_SysInitWorker(struct HttpWorker* w) {
+	w->Curl = curl_easy_init();
+	if (!w->Curl) Logger_Abort("Failed to init easy curl");
+	w->Multi = curl_multi_init();
+	if (!w->Multi) Logger_Abort("Failed to init multi curl");
+	/* Streamed requests bypass curl_easy_perform, which copies CURLOPT_MAXCONNECTS */
+	curl_multi_setopt(w->Multi, CURLMOPT_MAXCONNECTS, (long)HTTP_MAX_WORKERS);
+}
+
+static void Http_SysFreeWorker(struct HttpWorker* w) {
+	curl_multi_cleanup(w->Multi);
+	curl_easy_cleanup(w->Curl);
+	Mem_Free(w->Pending);
 }
 
 /* Updates progress of current download */
@@ -309,7 +1033,7 @@ static struct curl_slist* Http_MakeHeaders(struct HttpRequest* req) {
 
 	if (req->LastModified) {
 		String_InitArray_NT(tmp, buffer);
-		String_AppendConst(&tmp, "Last-Modified: ");
+		String_AppendConst(&tmp, "If-Modified-Since: ");
 
 		DateTime_HttpDate(req->LastModified, &tmp);
 		tmp.buffer[tmp.length] = '\0';
@@ -350,21 +1074,21 @@ static size_t Http_ProcessHeader(char *buffer, size_t size, size_t nitems, struc
 	return nitems;
 }
 
-static int curlBufferSize;
 /* Processes a chunk of data downloaded from the web server */
-static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, struct HttpRequest* req) {
+static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, struct HttpWorker* w) {
+	struct HttpRequest* req = w->Cur;
 	uint8_t* dst;
 
-	if (!curlBufferSize) {
-		curlBufferSize = req->ContentLength ? req->ContentLength : 1;
-		req->Data = Mem_Alloc(curlBufferSize, 1, "http get data");
+	if (!w->BufferSize) {
+		w->BufferSize = req->ContentLength ? req->ContentLength : 1;
+		req->Data = Mem_Alloc(w->BufferSize, 1, "http get data");
 		req->Size = 0;
 	}
 
 	/* expand buffer if needed */
-	if (req->Size + nitems > curlBufferSize) {
-		curlBufferSize = req->Size + nitems;
-		req->Data      = Mem_Realloc(req->Data, curlBufferSize, 1, "http inc data");
+	if (req->Size + nitems > w->BufferSize) {
+		w->BufferSize = req->Size + nitems;
+		req->Data     = Mem_Realloc(req->Data, w->BufferSize, 1, "http inc data");
 	}
 
 	dst = (uint8_t*)req->Data + req->Size;
@@ -372,39 +1096,137 @@ static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, struct
 	req->Size  += nitems;
 
 	/* TODO: Set progress */
-	//if (req->ContentLength) *progress = (int)(100.0f * req->Size / curlBufferSize);
+	//if (req->ContentLength) *progress = (int)(100.0f * req->Size / w->BufferSize);
+	return nitems;
+}
+
+/* Queues up a chunk of streamed data downloaded from the web server */
+static size_t Http_BufferData(char *buffer, size_t size, size_t nitems, struct HttpWorker* w) {
+	uint32_t end = w->PendingEnd + (uint32_t)nitems;
+
+	if (end > w->PendingCapacity) {
+		w->PendingCapacity = end;
+		w->Pending = w->Pending ? Mem_Realloc(w->Pending, end, 1, "http stream data")
+								: Mem_Alloc(end, 1, "http stream data");
+	}
+
+	Mem_Copy(w->Pending + w->PendingEnd, buffer, nitems);
+	w->PendingEnd = end;
 	return nitems;
 }
 
+/* Performs the transfer until more streamed data has arrived, or the transfer has finished */
+static ReturnCode Http_PumpMulti(struct HttpWorker* w) {
+	CURLMsg* msg;
+	CURLMcode res;
+	int running, left;
+
+	for (;;) {
+		res = curl_multi_perform(w->Multi, &running);
+		if (res) return res;
+
+		while ((msg = curl_multi_info_read(w->Multi, &left))) {
+			if (msg->msg != CURLMSG_DONE) continue;
+			w->Done = true;
+			w->TransferResult = msg->data.result;
+		}
+
+		if (!running) w->Done = true;
+		if (w->Done || w->PendingBeg != w->PendingEnd) return 0;
+
+		res = curl_multi_wait(w->Multi, NULL, 0, 1000, NULL);
+		if (res) return res;
+	}
+}
+
+static ReturnCode Http_StreamRead(struct Stream* s, uint8_t* data, uint32_t count, uint32_t* modified) {
+	struct HttpWorker* w = (struct HttpWorker*)s->Meta.Http;
+	ReturnCode res;
+	*modified = 0;
+
+	if (w->PendingBeg == w->PendingEnd) {
+		/* Everything buffered was consumed, so reuse the buffer from the start */
+		w->PendingBeg = 0; w->PendingEnd = 0;
+		if ((res = Http_PumpMulti(w))) return res;
+		/* Transfer may have failed before all data was received */
+		if (w->PendingBeg == w->PendingEnd) return w->TransferResult;
+	}
+
+	count = min(count, w->PendingEnd - w->PendingBeg);
+	Mem_Copy(data, w->Pending + w->PendingBeg, count);
+	w->PendingBeg += count;
+	*modified      = count;
+	return 0;
+}
+
+/* Passes the data/contents of a HTTP response to the request's processor as they are downloaded */
+static ReturnCode Http_StreamData(struct HttpWorker* w, struct HttpRequest* req) {
+	struct Stream body;
+	long status = 0;
+	ReturnCode res;
+
+	w->Done = false;
+	w->TransferResult = CURLE_OK;
+	w->PendingBeg = 0; w->PendingEnd = 0;
+	curl_multi_add_handle(w->Multi, w->Curl);
+
+	/* All the headers have been received once data starts arriving */
+	res = Http_PumpMulti(w);
+	curl_easy_getinfo(w->Curl, CURLINFO_RESPONSE_CODE, &status);
+
+	/* Processor only cares about the contents of successful responses */
+	if (!res && status == 200) {
+		Stream_Init(&body);
+		body.Read      = Http_StreamRead;
+		body.Meta.Http = w;
+		res = Http_ProcessBody(w, req, &body);
+	}
+
+	/* NOTE: This aborts the transfer if the processor did not read everything */
+	curl_multi_remove_handle(w->Multi, w->Curl);
+	return res ? res : w->TransferResult;
+}
+
 /* Sets general curl options for a request */
-static void Http_SetCurlOpts(struct HttpRequest* req, volatile int* progress) {
+static void Http_SetCurlOpts(struct HttpWorker* w, struct HttpRequest* req) {
+	CURL* curl = w->Curl;
 	curl_easy_setopt(curl, CURLOPT_COOKIEJAR,      "");
 	curl_easy_setopt(curl, CURLOPT_USERAGENT,      GAME_APP_NAME);
 	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_SHARE,          curl_share);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE,  1L);
+	/* Cache is shared, so must be able to keep the connections of all workers alive */
+	curl_easy_setopt(curl, CURLOPT_MAXCONNECTS,    (long)HTTP_MAX_WORKERS);
 
 	curl_easy_setopt(curl, CURLOPT_NOPROGRESS,       0L);
 	curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, Http_UpdateProgress);
-	curl_easy_setopt(curl, CURLOPT_PROGRESSDATA,     progress);
+	curl_easy_setopt(curl, CURLOPT_PROGRESSDATA,     &w->Progress);
 
 	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, Http_ProcessHeader);
 	curl_easy_setopt(curl, CURLOPT_HEADERDATA,     req);
-	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,  Http_ProcessData);
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA,      req);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,  req->Processor ? Http_BufferData : Http_ProcessData);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA,      w);
 }
 
-static ReturnCode Http_SysDo(struct HttpRequest* req, volatile int* progress) {
+static ReturnCode Http_SysDo(struct HttpWorker* w, struct HttpRequest* req) {
 	String url = String_FromRawArray(req->URL);
 	char urlStr[600];
 	void* post_data = req->Data;
+	CURL* curl = w->Curl;
 	struct curl_slist* list;
 	long status = 0;
-	CURLcode res;
+	ReturnCode res;
 
+	/* NOTE: curl_easy_reset keeps open connections alive */
 	curl_easy_reset(curl);
 	list = Http_MakeHeaders(req);
 	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
 
-	Http_SetCurlOpts(req, progress);
+	/* Only the validators given in the response should be kept */
+	req->LastModified = 0;
+	req->Etag[0]      = '\0';
+
+	Http_SetCurlOpts(w, req);
 	Platform_ConvertString(urlStr, &url);
 	curl_easy_setopt(curl, CURLOPT_URL, urlStr);
 
@@ -420,10 +1242,11 @@ static ReturnCode Http_SysDo(struct HttpRequest* req, volatile int* progress) {
 		HttpRequest_Free(req);
 	}
 
-	curlBufferSize = 0;
-	*progress = ASYNC_PROGRESS_FETCHING_DATA;
-	res = curl_easy_perform(curl);
-	*progress = 100;
+	w->Cur        = req;
+	w->BufferSize = 0;
+	w->Progress   = ASYNC_PROGRESS_FETCHING_DATA;
+	res = req->Processor ? Http_StreamData(w, req) : curl_easy_perform(curl);
+	w->Progress   = 100;
 
 	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
 	req->StatusCode = status;
@@ -435,7 +1258,11 @@ static ReturnCode Http_SysDo(struct HttpRequest* req, volatile int* progress) {
 }
 
 static void Http_SysFree(void) {
-	curl_easy_cleanup(curl);
+	int i;
+	curl_share_cleanup(curl_share);
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+		Mutex_Free(curl_shareMutexes[i]);
+	}
 	curl_global_cleanup();
 }
 #endif
@@ -496,20 +1323,24 @@ static void HttpRequestList_Free(struct HttpRequestList* list) {
 }
 
 static void* http_waitable;
-static void* http_workerThread;
+/* Separate, so the priority worker is never woken up for requests it can't take */
+static void* http_priorityWaitable;
 static void* http_pendingMutex;
 static void* http_processedMutex;
 static void* http_curRequestMutex;
 static volatile bool http_terminate;
 
+/* Priority requests (e.g. texture pack) are kept separate, so they never wait behind skins */
+static struct HttpRequestList http_priority;
 static struct HttpRequestList http_pending;
 static struct HttpRequestList http_processed;
 const static String http_skinServer = String_FromConst("http://static.classicube.net/skins/");
-static struct HttpRequest http_curRequest;
-static volatile int http_curProgress = ASYNC_PROGRESS_NOTHING;
+
+static struct HttpWorker http_workers[HTTP_MAX_WORKERS];
+static int http_workersCount;
 
 /* Adds a req to the list of pending requests, waking up worker thread if needed. */
-static void Http_Add(const String* url, bool priority, const String* id, uint8_t type, TimeMS* lastModified, const String* etag, const void* data, uint32_t size) {
+static void Http_Add(const String* url, bool priority, const String* id, uint8_t type, TimeMS* lastModified, const String* etag, const void* data, uint32_t size, Http_BodyProcessor processor) {
 	struct HttpRequest req = { 0 };
 	String reqUrl, reqID, reqEtag;
 
@@ -519,6 +1350,7 @@ static void Http_Add(const String* url, bool priority, const String* id, uint8_t
 	String_Copy(&reqID, id);
 
 	req.RequestType = type;
+	req.Processor   = processor;
 	Platform_Log2("Adding %s (type %b)", &reqUrl, &type);
 
 	String_InitArray(reqEtag, req.Etag);
@@ -535,16 +1367,18 @@ static void Http_Add(const String* url, bool priority, const String* id, uint8_t
 	{	
 		req.TimeAdded = DateTime_CurrentUTC_MS();
 		if (priority) {
-			HttpRequestList_Prepend(&http_pending, &req);
+			HttpRequestList_Prepend(&http_priority, &req);
 		} else {
 			HttpRequestList_Append(&http_pending, &req);
 		}
 	}
 	Mutex_Unlock(http_pendingMutex);
+
+	if (priority) Waitable_Signal(http_priorityWaitable);
 	Waitable_Signal(http_waitable);
 }
 
-void Http_AsyncGetSkin(const String* id, const String* skinName) {
+void Http_AsyncGetSkin(const String* id, const String* skinName, Http_BodyProcessor processor) {
 	String url; char urlBuffer[STRING_SIZE];
 	String_InitArray(url, urlBuffer);
 
@@ -555,23 +1389,27 @@ void Http_AsyncGetSkin(const String* id, const String* skinName) {
 		String_AppendColorless(&url, skinName);
 		String_AppendConst(&url, ".png");
 	}
-	Http_AsyncGetData(&url, false, id);
+	Http_AsyncGetStreamed(&url, false, id, NULL, NULL, processor);
 }
 
 void Http_AsyncGetData(const String* url, bool priority, const String* id) {
-	Http_Add(url, priority, id, REQUEST_TYPE_GET, NULL, NULL, NULL, 0);
+	Http_Add(url, priority, id, REQUEST_TYPE_GET, NULL, NULL, NULL, 0, NULL);
 }
 
 void Http_AsyncGetHeaders(const String* url, bool priority, const String* id) {
-	Http_Add(url, priority, id, REQUEST_TYPE_HEAD, NULL, NULL, NULL, 0);
+	Http_Add(url, priority, id, REQUEST_TYPE_HEAD, NULL, NULL, NULL, 0, NULL);
 }
 
 void Http_AsyncPostData(const String* url, bool priority, const String* id, const void* data, uint32_t size) {
-	Http_Add(url, priority, id, REQUEST_TYPE_POST, NULL, NULL, data, size);
+	Http_Add(url, priority, id, REQUEST_TYPE_POST, NULL, NULL, data, size, NULL);
 }
 
 void Http_AsyncGetDataEx(const String* url, bool priority, const String* id, TimeMS* lastModified, const String* etag) {
-	Http_Add(url, priority, id, REQUEST_TYPE_GET, lastModified, etag, NULL, 0);
+	Http_Add(url, priority, id, REQUEST_TYPE_GET, lastModified, etag, NULL, 0, NULL);
+}
+
+void Http_AsyncGetStreamed(const String* url, bool priority, const String* id, TimeMS* lastModified, const String* etag, Http_BodyProcessor processor) {
+	Http_Add(url, priority, id, REQUEST_TYPE_GET, lastModified, etag, NULL, 0, processor);
 }
 
 void Http_PurgeOldEntriesTask(struct ScheduledTask* task) {
@@ -618,34 +1456,85 @@ bool Http_GetResult(const String* id, struct HttpRequest* item) {
 }
 
 bool Http_GetCurrent(struct HttpRequest* request, int* progress) {
+	int i;
+	request->ID[0] = '\0';
+
 	Mutex_Lock(http_curRequestMutex);
 	{
-		*request  = http_curRequest;
-		*progress = http_curProgress;
+		for (i = 0; i < http_workersCount; i++) {
+			if (!http_workers[i].Request.ID[0]) continue;
+
+			*request  = http_workers[i].Request;
+			*progress = http_workers[i].Progress;
+			break;
+		}
 	}
 	Mutex_Unlock(http_curRequestMutex);
 	return request->ID[0];
 }
 
+bool Http_GetProgress(const String* id, int* progress) {
+	String reqID;
+	bool found = false;
+	int i;
+
+	Mutex_Lock(http_curRequestMutex);
+	{
+		for (i = 0; i < http_workersCount; i++) {
+			reqID = String_FromRawArray(http_workers[i].Request.ID);
+			if (!String_Equals(id, &reqID)) continue;
+
+			*progress = http_workers[i].Progress;
+			found = true; break;
+		}
+	}
+	Mutex_Unlock(http_curRequestMutex);
+	return found;
+}
+
 void Http_ClearPending(void) {
 	Mutex_Lock(http_pendingMutex);
 	{
+		HttpRequestList_Free(&http_priority);
 		HttpRequestList_Free(&http_pending);
 	}
 	Mutex_Unlock(http_pendingMutex);
+	Waitable_Signal(http_priorityWaitable);
 	Waitable_Signal(http_waitable);
 }
 
 /* Attempts to download the server's response headers and data to the given req */
-static void Http_ProcessRequest(struct HttpRequest* req) {
+static void Http_ProcessRequest(struct HttpWorker* w, struct HttpRequest* req) {
 	String url = String_FromRawArray(req->URL);
+	struct DiskCacheEntry entry;
+	bool cached, fromCache = false;
 	uint64_t  beg, end;
 	uint32_t  size, elapsed;
 	uintptr_t addr;
 
+	cached = DiskCache_Prepare(req, &entry);
 	Platform_Log2("Downloading from %s (type %b)", &url, &req->RequestType);
 	beg = Stopwatch_Measure();
-	req->Result = Http_SysDo(req, &http_curProgress);
+	req->Result = Http_SysDo(w, req);
+
+	if (cached && !req->Result && req->StatusCode == 304) {
+		fromCache   = true;
+		req->Result = DiskCache_Serve(req, &entry);
+
+		/* Cached copy may have been deleted or corrupted, so forget it and download it again in full */
+		if (req->Result) {
+			DiskCache_Remove(&url);
+			req->Etag[0]      = '\0';
+			req->LastModified = 0;
+
+			fromCache   = false;
+			req->Result = Http_SysDo(w, req);
+		}
+	}
+
+	if (!req->Result && req->StatusCode == 200 && !req->Processor && req->Data && req->Size) {
+		DiskCache_AddData(w, req);
+	}
 	end = Stopwatch_Measure();
 
 	elapsed = Stopwatch_ElapsedMicroseconds(beg, end) / 1000;
@@ -657,7 +1546,7 @@ static void Http_ProcessRequest(struct HttpRequest* req) {
 		addr = (uintptr_t)req->Data;
 		Platform_Log2("HTTP returned data: %i bytes at %x", &size, &addr);
 	}
-	req->Success = !req->Result && req->StatusCode == 200 && req->Data && req->Size;
+	req->Success = !req->Result && (req->StatusCode == 200 || fromCache) && (req->Processor || (req->Data && req->Size));
 }
 
 /* Adds given req to list of processed/completed requests */
@@ -683,43 +1572,60 @@ static void Http_CompleteRequest(struct HttpRequest* req) {
 	}
 }
 
-static void Http_WorkerLoop(void) {
+/* Takes the next request this worker can process from the pending lists */
+static bool Http_TakeRequest(struct HttpWorker* w, struct HttpRequest* request) {
+	struct HttpRequestList* list;
+
+	if (http_priority.Count) {
+		list = &http_priority;
+	} else if (http_pending.Count && !w->PriorityOnly) {
+		list = &http_pending;
+	} else {
+		return false;
+	}
+
+	*request = list->Requests[0];
+	HttpRequestList_RemoveAt(list, 0);
+	return true;
+}
+
+static void Http_WorkerLoop(void* arg) {
+	struct HttpWorker* w = (struct HttpWorker*)arg;
 	struct HttpRequest request;
-	bool hasRequest, stop;
+	void* waitable;
+	bool hasRequest, moreRequests, stop;
 
-	for (;;) {
-		hasRequest = false;
+	waitable = w->PriorityOnly ? http_priorityWaitable : http_waitable;
 
+	for (;;) {
 		Mutex_Lock(http_pendingMutex);
 		{
 			stop = http_terminate;
-			if (!stop && http_pending.Count) {
-				request = http_pending.Requests[0];
-				hasRequest = true;
-				HttpRequestList_RemoveAt(&http_pending, 0);
-			}
+			hasRequest   = !stop && Http_TakeRequest(w, &request);
+			moreRequests = http_priority.Count || http_pending.Count;
 		}
 		Mutex_Unlock(http_pendingMutex);
 
+		/* Waitable only wakes up one worker, so pass on the wakeup to the other workers */
+		/* (priority worker is the only one waiting on its waitable, so it has nothing to pass on) */
+		if ((stop || moreRequests) && !w->PriorityOnly) Waitable_Signal(http_waitable);
 		if (stop) return;
+
 		/* Block until another thread submits a req to do */
 		if (!hasRequest) {
-			Platform_LogConst("Going back to sleep...");
-			Waitable_Wait(http_waitable);
+			Waitable_Wait(waitable);
 			continue;
 		}
 
-		Platform_LogConst("Got something to do!");
 		Mutex_Lock(http_curRequestMutex);
 		{
-			http_curRequest = request;
-			http_curProgress = ASYNC_PROGRESS_MAKING_REQUEST;
+			w->Request  = request;
+			w->Progress = ASYNC_PROGRESS_MAKING_REQUEST;
 		}
 		Mutex_Unlock(http_curRequestMutex);
 
-		Platform_LogConst("Doing it");
 		/* performing req doesn't need thread safety */
-		Http_ProcessRequest(&request);
+		Http_ProcessRequest(w, &request);
 
 		Mutex_Lock(http_processedMutex);
 		{
@@ -729,8 +1635,8 @@ static void Http_WorkerLoop(void) {
 
 		Mutex_Lock(http_curRequestMutex);
 		{
-			http_curRequest.ID[0] = '\0';
-			http_curProgress = ASYNC_PROGRESS_NOTHING;
+			w->Request.ID[0] = '\0';
+			w->Progress = ASYNC_PROGRESS_NOTHING;
 		}
 		Mutex_Unlock(http_curRequestMutex);
 	}
@@ -741,28 +1647,54 @@ static void Http_WorkerLoop(void) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	int i;
 	ScheduledTask_Add(30, Http_PurgeOldEntriesTask);
+	HttpRequestList_Init(&http_priority);
 	HttpRequestList_Init(&http_pending);
 	HttpRequestList_Init(&http_processed);
 	Http_SysInit();
+	DiskCache_Load();
 
 	http_waitable = Waitable_Create();
+	http_priorityWaitable = Waitable_Create();
 	http_pendingMutex    = Mutex_Create();
 	http_processedMutex  = Mutex_Create();
 	http_curRequestMutex = Mutex_Create();
-	http_workerThread = Thread_Start(Http_WorkerLoop, false);
+
+	http_terminate    = false;
+	http_workersCount = Options_GetInt(OPT_HTTP_WORKERS, 1, HTTP_MAX_WORKERS, 4);
+
+	for (i = 0; i < http_workersCount; i++) {
+		http_workers[i].Request.ID[0] = '\0';
+		http_workers[i].Progress      = ASYNC_PROGRESS_NOTHING;
+		/* First worker is reserved for priority requests */
+		http_workers[i].PriorityOnly  = i == 0 && http_workersCount > 1;
+		http_workers[i].Index         = i;
+		Http_SysInitWorker(&http_workers[i]);
+	}
+	for (i = 0; i < http_workersCount; i++) {
+		http_workers[i].Thread = Thread_StartArg(Http_WorkerLoop, &http_workers[i], false);
+	}
 }
 
 static void Http_Free(void) {
+	int i;
 	http_terminate = true;
 	Http_ClearPending();
-	Thread_Join(http_workerThread);
 
+	for (i = 0; i < http_workersCount; i++) {
+		Thread_Join(http_workers[i].Thread);
+		Http_SysFreeWorker(&http_workers[i]);
+	}
+
+	HttpRequestList_Free(&http_priority);
 	HttpRequestList_Free(&http_pending);
 	HttpRequestList_Free(&http_processed);
 	Http_SysFree();
+	DiskCache_Free();
 
 	Waitable_Free(http_waitable);
+	Waitable_Free(http_priorityWaitable);
 	Mutex_Free(http_pendingMutex);
 	Mutex_Free(http_processedMutex);
 	Mutex_Free(http_curRequestMutex);
@@ -4,6 +4,7 @@
 #include "Utils.h"
 /* Aysnchronously performs http GET, HEAD, and POST requests.
    Typically this is used to download skins, texture packs, etc.
+   Responses to GET requests are cached on disk, and revalidated when requested again.
    Copyright 2014-2017 ClassicalSharp | Licensed under BSD-3
 */
 struct IGameComponent;
@@ -19,6 +20,14 @@ enum HttpProgress {
 	ASYNC_PROGRESS_FETCHING_DATA  = -1
 };
 
+struct HttpRequest;
+struct Stream;
+/* Consumes the contents of a response as they are downloaded, instead of buffering them all in Data. */
+/* NOTE: Called on a http worker thread, and only when the response has a 200 status code. */
+/* May set Data and Size to its own result, which must be freeable with Mem_Free. */
+/* A processor that decodes an image sets Data to the bitmap's pixels, and sets the Bitmap/Image sizes. */
+typedef ReturnCode (*Http_BodyProcessor)(struct HttpRequest* req, struct Stream* body);
+
 struct HttpRequest {
 	char URL[URL_MAX_SIZE]; /* URL data is downloaded from/uploaded to. */
 	char ID[URL_MAX_SIZE];  /* Unique identifier for this request. */
@@ -34,7 +43,10 @@ struct HttpRequest {
 	TimeMS LastModified;    /* Time item cached at (if at all) */
 	char Etag[STRING_SIZE]; /* ETag of cached item (if any) */
 	uint8_t RequestType;    /* Whether to fetch contents or just headers. */
-	bool Success;           /* Whether Result is 0, status is 200, and data is not NULL */
+	bool Success;           /* Whether Result is 0, status is 200 (or served from cache), and data is not NULL */
+	Http_BodyProcessor Processor; /* Consumes contents as they are downloaded. (if not NULL) */
+	int BitmapWidth, BitmapHeight; /* Size of the bitmap in Data, if Processor decoded an image */
+	int ImageWidth, ImageHeight;   /* Size of the image in that bitmap, which may be padded to power of two */
 };
 
 /* Frees data from a HTTP request. */
@@ -43,7 +55,8 @@ void HttpRequest_Free(struct HttpRequest* request);
 /* Aschronously performs a http GET request to download a skin. */
 /* If url is a skin, this is the same as Http_AsyncGetData. */
 /* If not, instead downloads from http://static.classicube.net/skins/[skinName].png */
-void Http_AsyncGetSkin(const String* id, const String* skinName);
+/* NOTE: processor is passed to Http_AsyncGetStreamed, and so may be NULL. */
+void Http_AsyncGetSkin(const String* id, const String* skinName, Http_BodyProcessor processor);
 /* Asynchronously performs a http GET request. (e.g. to download data) */
 void Http_AsyncGetData(const String* url, bool priority, const String* id);
 /* Asynchronously performs a http HEAD request. (e.g. to get Content-Length header) */
@@ -54,13 +67,25 @@ void Http_AsyncPostData(const String* url, bool priority, const String* id, cons
 /* Asynchronously performs a http GET request. (e.g. to download data) */
 /* Also sets the If-Modified-Since and If-None-Match headers. (if not NULL)  */
 void Http_AsyncGetDataEx(const String* url, bool priority, const String* id, TimeMS* lastModified, const String* etag);
+/* Asynchronously performs a http GET request, like Http_AsyncGetDataEx. */
+/* However, response contents are passed to processor as they arrive instead of being buffered. */
+/* NOTE: If processor is NULL, this is the same as Http_AsyncGetDataEx. */
+void Http_AsyncGetStreamed(const String* url, bool priority, const String* id, TimeMS* lastModified, const String* etag, Http_BodyProcessor processor);
 
 /* Attempts to retrieve a fully completed request. */
 /* NOTE: You MUST also check Result/StatusCode, and check Size is > 0. */
 /* (because a completed request may not have completed successfully) */
 bool Http_GetResult(const String* id, struct HttpRequest* item);
-/* Retrieves information about the request currently being processed. */
+/* Retrieves information about a request currently being processed. */
+/* NOTE: Multiple requests may be processed at once, this returns the first one. */
 bool Http_GetCurrent(struct HttpRequest* request, int* progress);
+/* Retrieves progress of the request with the given ID, if it is currently being processed. */
+bool Http_GetProgress(const String* id, int* progress);
+/* Attempts to open the cached contents of a previous GET request to the given url. */
+/* NOTE: Buffered responses are only cached when they have an ETag or Last-Modified header. */
+bool Http_OpenCached(const String* url, struct Stream* stream);
+/* Processor that does nothing, so response contents are only stored in the cache. (see Http_OpenCached) */
+ReturnCode Http_CacheOnly(struct HttpRequest* req, struct Stream* body);
 /* Clears the list of pending requests. */
 void Http_ClearPending(void);
 void Http_PurgeOldEntriesTask(struct ScheduledTask* task);
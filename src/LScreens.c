@@ -1485,13 +1485,8 @@ static void UpdatesScreen_CheckTick(struct UpdatesScreen* s) {
 
 static void UpdatesScreen_UpdateProgress(struct UpdatesScreen* s, struct LWebTask* task) {
 	String str; char strBuffer[STRING_SIZE];
-	String identifier;
-	struct HttpRequest item;
 	int progress;
-	if (!Http_GetCurrent(&item, &progress)) return;
-
-	identifier = String_FromRawArray(item.ID);
-	if (!String_Equals(&identifier, &task->Identifier)) return;
+	if (!Http_GetProgress(&task->Identifier, &progress)) return;
 	if (progress == s->BuildProgress) return;
 
 	s->BuildProgress = progress;
@@ -1,9 +1,10 @@
 #include "MapGenerator.h"
 #include "BlockID.h"
-#include "Logger.h"
 #include "ExtMath.h"
 #include "Funcs.h"
 #include "Platform.h"
+#include "Utils.h"
+#include "World.h"
 
 volatile float Gen_CurrentProgress;
 volatile const char* Gen_CurrentState;
@@ -22,11 +23,207 @@ static void Gen_Init(void) {
 
 	Gen_CurrentProgress = 0.0f;
 	Gen_CurrentState    = "";
-
 	Gen_Blocks = Mem_Alloc(Gen_Volume, 1, "map blocks for gen");
 	Gen_Done   = false;
 }
 
+void Gen_SetDimensions(int width, int height, int length) {
+	/* A map still being generated uses the current dimensions */
+	Gen_Stop();
+	Gen_Width = width; Gen_Height = height; Gen_Length = length;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Worker threads------------------------------------------------------*
+*#########################################################################################################################*/
+#define GEN_MAX_WORKERS 16
+/* Processes the columns from x1, z1 (inclusive) to x2, z2 (exclusive) */
+typedef void (*Gen_ColumnsFunc)(int x1, int z1, int x2, int z2);
+
+static Gen_ColumnsFunc gen_jobsFunc;
+static void* gen_mutex;
+static int gen_jobsCount, gen_nextJob, gen_rowsPerJob, gen_columnsDone;
+static bool gen_jobsProgress;
+static volatile bool gen_cancel;
+
+static void Gen_GetJob(int job, int* x1, int* z1, int* x2, int* z2) {
+	*x1 = 0;         *z1 = job * gen_rowsPerJob;
+	*x2 = Gen_Width; *z2 = min(*z1 + gen_rowsPerJob, Gen_Length);
+}
+
+static void Gen_RunWorker(void) {
+	int job, x1, z1, x2, z2;
+	for (;;) {
+		Mutex_Lock(gen_mutex);
+		{
+			job = gen_nextJob;
+			if (job < gen_jobsCount) gen_nextJob++;
+		}
+		Mutex_Unlock(gen_mutex);
+		if (job >= gen_jobsCount || gen_cancel) return;
+
+		Gen_GetJob(job, &x1, &z1, &x2, &z2);
+		gen_jobsFunc(x1, z1, x2, z2);
+
+		Mutex_Lock(gen_mutex);
+		{
+			gen_columnsDone += (x2 - x1) * (z2 - z1);
+			if (gen_jobsProgress) Gen_CurrentProgress = (float)gen_columnsDone / Gen_OneY;
+		}
+		Mutex_Unlock(gen_mutex);
+	}
+}
+
+/* Shares jobs between the calling thread and worker threads, one per extra processor. */
+static void Gen_RunJobs(Gen_ColumnsFunc func, int jobsCount, bool progress) {
+	void* threads[GEN_MAX_WORKERS];
+	int i, workers;
+
+	gen_jobsFunc     = func;
+	gen_jobsCount    = jobsCount;
+	gen_jobsProgress = progress;
+	gen_nextJob = 0; gen_columnsDone = 0;
+	if (progress) Gen_CurrentProgress = 0.0f;
+
+	workers = min(Thread_ProcessorCount(), GEN_MAX_WORKERS);
+	workers = min(workers, jobsCount);
+	gen_mutex = Mutex_Create();
+
+	for (i = 1; i < workers; i++) {
+		threads[i] = Thread_Start(Gen_RunWorker, false);
+	}
+	Gen_RunWorker();
+	for (i = 1; i < workers; i++) {
+		Thread_Join(threads[i]);
+	}
+
+	Mutex_Free(gen_mutex);
+	gen_mutex = NULL;
+}
+
+/* Calls func over all Z rows of the map, split into jobs of rowsPerJob rows. */
+/* NOTE: func must only write to blocks in its columns, and results must not depend on job order. */
+static void Gen_ParallelRows(Gen_ColumnsFunc func, int rowsPerJob, bool progress) {
+	gen_rowsPerJob = max(rowsPerJob, 1);
+	Gen_RunJobs(func, (Gen_Length + gen_rowsPerJob - 1) / gen_rowsPerJob, progress);
+}
+
+/* Returns number of rows per job, so every processor gets about the given number of jobs. */
+static int Gen_RowsPerJob(int jobsPerWorker) {
+	int workers = min(Thread_ProcessorCount(), GEN_MAX_WORKERS);
+	return Gen_Length / (workers * jobsPerWorker);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Generator thread------------------------------------------------------*
+*#########################################################################################################################*/
+static void* gen_thread;
+
+void Gen_Start(void) {
+	Gen_Stop();
+	Gen_Done   = false;
+	gen_cancel = false;
+	gen_thread = Thread_Start(Gen_Vanilla ? NotchyGen_Generate : FlatgrassGen_Generate, false);
+}
+
+void Gen_Stop(void) {
+	if (gen_thread) {
+		gen_cancel = true;
+		Thread_Join(gen_thread);
+		gen_thread = NULL;
+	}
+
+	if (Gen_Blocks != World_Blocks) Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Generator stages----------------------------------------------------*
+*#########################################################################################################################*/
+static struct GenStage** gen_group;
+static int gen_groupCount, gen_groupNext;
+static void* gen_groupMutex;
+static uint32_t gen_allocated; /* Total memory allocated through Gen_Alloc */
+
+/* NOTE: Concurrent stages allocating at the same time count towards each other's memory. */
+static void Gen_CountMemory(uint32_t bytes) {
+	if (gen_groupMutex) Mutex_Lock(gen_groupMutex);
+	gen_allocated += bytes;
+	if (gen_groupMutex) Mutex_Unlock(gen_groupMutex);
+}
+
+void* Gen_Alloc(uint32_t numElems, uint32_t elemsSize, const char* place) {
+	Gen_CountMemory(numElems * elemsSize);
+	return Mem_Alloc(numElems, elemsSize, place);
+}
+
+static void Gen_RunStage(struct GenStage* stage) {
+	uint32_t allocBeg = gen_allocated;
+	uint64_t beg;
+
+	Gen_CurrentState = stage->Name;
+	beg = Stopwatch_Measure();
+	stage->Run();
+
+	stage->Time   = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	stage->Memory = gen_allocated - allocBeg;
+}
+
+static void Gen_RunGroupWorker(void) {
+	int i;
+	for (;;) {
+		Mutex_Lock(gen_groupMutex);
+		{
+			i = gen_groupNext++;
+		}
+		Mutex_Unlock(gen_groupMutex);
+
+		if (i >= gen_groupCount) return;
+		Gen_RunStage(gen_group[i]);
+	}
+}
+
+static bool Gen_StagesConflict(struct GenStage* a, struct GenStage* b) {
+	return (a->Writes & (b->Reads | b->Writes)) || (b->Writes & (a->Reads | a->Writes));
+}
+
+/* Runs the given stages in order. Consecutive stages which do not conflict over any data */
+/*  are run concurrently as a group, each on its own thread. */
+static void Gen_RunStages(struct GenStage** stages, int count) {
+	void* threads[GEN_MAX_STAGES];
+	int i, j, k;
+
+	for (i = 0; i < count; i++) {
+		stages[i]->Time = 0; stages[i]->Memory = 0;
+	}
+
+	for (i = 0; i < count && !gen_cancel; i = j) {
+		for (j = i + 1; j < count; j++) {
+			for (k = i; k < j && !Gen_StagesConflict(stages[k], stages[j]); k++) { }
+			if (k < j) break;
+		}
+
+		gen_group      = stages + i;
+		gen_groupCount = j - i;
+		gen_groupNext  = 0;
+		gen_groupMutex = Mutex_Create();
+
+		for (k = 1; k < gen_groupCount; k++) {
+			threads[k] = Thread_Start(Gen_RunGroupWorker, false);
+		}
+		Gen_RunGroupWorker();
+		for (k = 1; k < gen_groupCount; k++) {
+			Thread_Join(threads[k]);
+		}
+
+		Mutex_Free(gen_groupMutex);
+		gen_groupMutex = NULL;
+	}
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Flatgrass gen-------------------------------------------------------*
@@ -40,7 +237,7 @@ static void FlatgrassGen_MapSet(int yBeg, int yEnd, BlockRaw block) {
 	yHeight = (yEnd - yBeg) + 1;
 	Gen_CurrentProgress = 0.0f;
 
-	for (y = yBeg; y <= yEnd; y++) {
+	for (y = yBeg; y <= yEnd && !gen_cancel; y++) {
 		Mem_Set(ptr + y * oneY, block, oneY);
 		Gen_CurrentProgress = (float)(y - yBeg) / yHeight;
 	}
@@ -48,7 +245,6 @@ static void FlatgrassGen_MapSet(int yBeg, int yEnd, BlockRaw block) {
 
 void FlatgrassGen_Generate(void) {
 	Gen_Init();
-
 	Gen_CurrentState = "Setting air blocks";
 	FlatgrassGen_MapSet(Gen_Height / 2, Gen_MaxY, BLOCK_AIR);
 
@@ -66,16 +262,17 @@ void FlatgrassGen_Generate(void) {
 *----------------------------------------------------Notchy map gen-------------------------------------------------------*
 *#########################################################################################################################*/
 static int waterLevel, minHeight;
-static int16_t* Heightmap;
+int16_t* Gen_Heightmap;
 static RNGState rnd;
 
-static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block) {
-	int xBeg = Math_Floor(max(x - radius, 0));
-	int xEnd = Math_Floor(min(x + radius, Gen_MaxX));
+/* NOTE: Only blocks in the columns from x1, z1 (inclusive) to x2, z2 (exclusive) are changed */
+static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block, int x1, int z1, int x2, int z2) {
+	int xBeg = Math_Floor(max(x - radius, x1));
+	int xEnd = Math_Floor(min(x + radius, x2 - 1));
 	int yBeg = Math_Floor(max(y - radius, 0));
 	int yEnd = Math_Floor(min(y + radius, Gen_MaxY));
-	int zBeg = Math_Floor(max(z - radius, 0));
-	int zEnd = Math_Floor(min(z + radius, Gen_MaxZ));
+	int zBeg = Math_Floor(max(z - radius, z1));
+	int zEnd = Math_Floor(min(z + radius, z2 - 1));
 
 	float radiusSq = radius * radius;
 	int index;
@@ -95,122 +292,173 @@ static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, Bloc
 	}
 }
 
-#define Stack_Push(index)\
-stack[stack_size++] = index;\
-if (stack_size == 32768) {\
-	Logger_Abort("NotchyGen_FloodFail - stack limit hit");\
-}
-
+static struct FloodFill gen_flood;
 static void NotchyGen_FloodFill(int startIndex, BlockRaw block) {
-	/* This is way larger size than I actually have seen used, but we play it safe here.*/
-	int32_t stack[32768];
-	int stack_size = 0, index;
-	int x, y, z;
-
+	uint32_t stackMax = gen_flood.StackMax;
 	if (startIndex < 0) return; /* y below map, immediately ignore */
-	Stack_Push(startIndex);
+	FloodFill_Run(&gen_flood, startIndex, BLOCK_AIR, block);
 
-	while (stack_size > 0) {
-		stack_size--;
-		index = stack[stack_size];
-
-		if (Gen_Blocks[index] != BLOCK_AIR) continue;
-		Gen_Blocks[index] = block;
+	/* Work stack is expanded as needed, so count that towards stage's memory too */
+	if (gen_flood.StackMax != stackMax) {
+		Gen_CountMemory((gen_flood.StackMax - stackMax) * sizeof(int32_t));
+	}
+}
 
-		x = index  % Gen_Width;
-		y = index  / Gen_OneY;
-		z = (index / Gen_Width) % Gen_Length;
+/* Caves and ore veins only replace stone, so the spheroids making them up can be filled in */
+/*  any order. Their positions depend on the random generator so are calculated serially, */
+/*  but are then filled in parallel, with each job filling in the parts in its rows. */
+#define GEN_MAX_SPHEROIDS 65536
+struct GenSpheroid { int X, Y, Z; float Radius; };
+static struct GenSpheroid* gen_spheroids;
+static int gen_spheroidsCount;
+static BlockRaw gen_spheroidsBlock;
+
+static void NotchyGen_FillSpheroidRows(int x1, int z1, int x2, int z2) {
+	struct GenSpheroid* sph;
+	int i;
 
-		if (x > 0)        { Stack_Push(index - 1); }
-		if (x < Gen_MaxX) { Stack_Push(index + 1); }
-		if (z > 0)        { Stack_Push(index - Gen_Width); }
-		if (z < Gen_MaxZ) { Stack_Push(index + Gen_Width); }
-		if (y > 0)        { Stack_Push(index - Gen_OneY); }
+	for (i = 0; i < gen_spheroidsCount; i++) {
+		sph = &gen_spheroids[i];
+		if (sph->Z + sph->Radius < z1 || sph->Z - sph->Radius >= z2) continue;
+		NotchyGen_FillOblateSpheroid(sph->X, sph->Y, sph->Z, sph->Radius, gen_spheroidsBlock, x1, z1, x2, z2);
 	}
 }
 
+static void NotchyGen_FlushSpheroids(void) {
+	if (!gen_spheroidsCount) return;
+	Gen_ParallelRows(NotchyGen_FillSpheroidRows, Gen_RowsPerJob(2), false);
+	gen_spheroidsCount = 0;
+}
 
-static void NotchyGen_CreateHeightmap(void) {
-	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+static void NotchyGen_InitSpheroids(BlockRaw block) {
+	if (!gen_spheroids) {
+		gen_spheroids = Gen_Alloc(GEN_MAX_SPHEROIDS, sizeof(struct GenSpheroid), "gen spheroids");
+	}
+	gen_spheroidsBlock = block;
+}
+
+static void NotchyGen_AddSpheroid(int x, int y, int z, float radius) {
+	struct GenSpheroid* sph = &gen_spheroids[gen_spheroidsCount++];
+	sph->X = x; sph->Y = y; sph->Z = z; sph->Radius = radius;
+	if (gen_spheroidsCount == GEN_MAX_SPHEROIDS) NotchyGen_FlushSpheroids();
+}
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < Gen_Length; z++) {
-		Gen_CurrentProgress = (float)z / Gen_Length;
+/* Noise used by the stage currently running, which worker threads only read from */
+static struct CombinedNoise gen_combined1, gen_combined2;
+static struct OctaveNoise gen_octave1, gen_octave2;
 
-		for (x = 0; x < Gen_Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+static void NotchyGen_HeightmapRows(int x1, int z1, int x2, int z2) {
+	float xs[NOISE_BATCH_SIZE], ys[NOISE_BATCH_SIZE];
+	float scaledXs[NOISE_BATCH_SIZE], scaledYs[NOISE_BATCH_SIZE];
+	float low[NOISE_BATCH_SIZE], high[NOISE_BATCH_SIZE], select[NOISE_BATCH_SIZE];
+	float highXs[NOISE_BATCH_SIZE];
+	int highX[NOISE_BATCH_SIZE];
+	float hLow, hHigh, height;
+	int hIndex, adjHeight;
+	int rowsMin = Gen_Height;
+	int i, j, x, z, count, highCount;
+
+	for (z = z1; z < z2; z++) {
+		hIndex = z * Gen_Width + x1;
+		for (x = x1; x < x2; x += count) {
+			count = min(x2 - x, NOISE_BATCH_SIZE);
+			for (i = 0; i < count; i++) {
+				xs[i]       = (float)(x + i);  ys[i]       = (float)z;
+				scaledXs[i] = (x + i) * 1.3f;  scaledYs[i] = z * 1.3f;
+			}
+			CombinedNoise_CalcBatch(&gen_combined1, scaledXs, scaledYs, low, count);
+			OctaveNoise_CalcBatch(&gen_octave1, xs, ys, select, count);
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
+			/* Only calculate high noise for the samples that actually use it */
+			for (i = 0, highCount = 0; i < count; i++) {
+				if (select[i] > 0) continue;
+				highX[highCount] = i; highXs[highCount++] = scaledXs[i];
 			}
+			CombinedNoise_CalcBatch(&gen_combined2, highXs, scaledYs, high, highCount);
+
+			for (i = 0, j = 0; i < count; i++) {
+				hLow   = low[i] / 6 - 4;
+				height = hLow;
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+				if (j < highCount && highX[j] == i) {
+					hHigh  = high[j++] / 5 + 6;
+					height = max(hLow, hHigh);
+				}
+
+				height *= 0.5f;
+				if (height < 0) height *= 0.8f;
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			Heightmap[hIndex++] = adjHeight;
+				adjHeight = (int)(height + waterLevel);
+				rowsMin   = min(adjHeight, rowsMin);
+				Gen_Heightmap[hIndex++] = adjHeight;
+			}
 		}
 	}
+
+	Mutex_Lock(gen_mutex);
+	{
+		minHeight = min(rowsMin, minHeight);
+	}
+	Mutex_Unlock(gen_mutex);
+}
+
+static void NotchyGen_CreateHeightmap(void) {
+	CombinedNoise_Init(&gen_combined1, &rnd, 8, 8);
+	CombinedNoise_Init(&gen_combined2, &rnd, 8, 8);
+	OctaveNoise_Init(&gen_octave1, &rnd, 6);
+
+	Gen_Heightmap = Gen_Alloc(Gen_Width * Gen_Length, 2, "gen heightmap");
+	Gen_ParallelRows(NotchyGen_HeightmapRows, 4, true);
 }
 
-static int NotchyGen_CreateStrataFast(void) {
+static int gen_minStoneY;
+static void NotchyGen_CreateStrataFast(void) {
 	uint32_t oneY = (uint32_t)Gen_OneY;
 	int stoneHeight, airHeight;
 	int y;
 
 	Gen_CurrentProgress = 0.0f;
-	Gen_CurrentState    = "Filling map";
 	/* Make lava layer at bottom */
 	Mem_Set(Gen_Blocks, BLOCK_LAVA, oneY);
 
 	/* Invariant: the lowest value dirtThickness can possible be is -14 */
 	stoneHeight = minHeight - 14;
 	/* We can quickly fill in bottom solid layers */
-	for (y = 1; y <= stoneHeight; y++) {
+	for (y = 1; y <= stoneHeight && !gen_cancel; y++) {
 		Mem_Set(Gen_Blocks + y * oneY, BLOCK_STONE, oneY);
 		Gen_CurrentProgress = (float)y / Gen_Height;
 	}
 
 	/* Fill in rest of map wih air */
 	airHeight = max(0, stoneHeight) + 1;
-	for (y = airHeight; y < Gen_Height; y++) {
+	for (y = airHeight; y < Gen_Height && !gen_cancel; y++) {
 		Mem_Set(Gen_Blocks + y * oneY, BLOCK_AIR, oneY);
 		Gen_CurrentProgress = (float)y / Gen_Height;
 	}
 
 	/* if stoneHeight is <= 0, then no layer is fully stone */
-	return max(stoneHeight, 1);
+	gen_minStoneY = max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
+static void NotchyGen_StrataColumns(int x1, int z1, int x2, int z2) {
+	float xs[NOISE_BATCH_SIZE], ys[NOISE_BATCH_SIZE], noise[NOISE_BATCH_SIZE];
 	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = Gen_MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
-
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
-
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < Gen_Length; z++) {
-		Gen_CurrentProgress = (float)z / Gen_Length;
-
-		for (x = 0; x < Gen_Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = Heightmap[hIndex++];
+	int minStoneY = gen_minStoneY, stoneHeight;
+	int hIndex, maxY = Gen_MaxY, index = 0;
+	int i, x, y, z, count = 0;
+
+	for (z = z1; z < z2; z++) {
+		hIndex = z * Gen_Width + x1;
+		for (x = x1; x < x2; x++) {
+			/* Calculate noise for the next block of columns when needed */
+			if ((x - x1) % NOISE_BATCH_SIZE == 0) {
+				count = min(x2 - x, NOISE_BATCH_SIZE);
+				for (i = 0; i < count; i++) { xs[i] = (float)(x + i); ys[i] = (float)z; }
+				OctaveNoise_CalcBatch(&gen_octave1, xs, ys, noise, count);
+			}
+			dirtThickness = (int)(noise[(x - x1) % NOISE_BATCH_SIZE] / 24 - 4);
+			dirtHeight    = Gen_Heightmap[hIndex++];
 			stoneHeight   = dirtHeight + dirtThickness;
 
 			stoneHeight = min(stoneHeight, maxY);
@@ -230,6 +478,11 @@ static void NotchyGen_CreateStrata(void) {
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	OctaveNoise_Init(&gen_octave1, &rnd, 8);
+	Gen_ParallelRows(NotchyGen_StrataColumns, 4, true);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -238,9 +491,9 @@ static void NotchyGen_CarveCaves(void) {
 	int cenX, cenY, cenZ;
 	int i, j;
 
-	cavesCount       = Gen_Volume / 8192;
-	Gen_CurrentState = "Carving caves";
-	for (i = 0; i < cavesCount; i++) {
+	cavesCount = Gen_Volume / 8192;
+	NotchyGen_InitSpheroids(BLOCK_AIR);
+	for (i = 0; i < cavesCount && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / cavesCount;
 
 		caveX = (float)Random_Next(&rnd, Gen_Width);
@@ -270,21 +523,22 @@ static void NotchyGen_CarveCaves(void) {
 			radius = (Gen_Height - cenY) / (float)Gen_Height;
 			radius = 1.2f + (radius * 3.5f + 1.0f) * caveRadius;
 			radius = radius * Math_SinF(j * MATH_PI / caveLen);
-			NotchyGen_FillOblateSpheroid(cenX, cenY, cenZ, radius, BLOCK_AIR);
+			NotchyGen_AddSpheroid(cenX, cenY, cenZ, radius);
 		}
 	}
+	NotchyGen_FlushSpheroids();
 }
 
-static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw block) {
+static void NotchyGen_CarveOreVeins(float abundance, BlockRaw block) {
 	int numVeins, veinLen;
 	float veinX, veinY, veinZ;
 	float theta, deltaTheta, phi, deltaPhi;
 	float radius;
 	int i, j;
 
-	numVeins         = (int)(Gen_Volume * abundance / 16384);
-	Gen_CurrentState = state;
-	for (i = 0; i < numVeins; i++) {
+	numVeins = (int)(Gen_Volume * abundance / 16384);
+	NotchyGen_InitSpheroids(block);
+	for (i = 0; i < numVeins && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numVeins;
 
 		veinX = (float)Random_Next(&rnd, Gen_Width);
@@ -306,20 +560,24 @@ static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw
 			deltaPhi   = deltaPhi   * 0.9f + Random_Float(&rnd) - Random_Float(&rnd);
 
 			radius = abundance * Math_SinF(j * MATH_PI / veinLen) + 1.0f;
-			NotchyGen_FillOblateSpheroid((int)veinX, (int)veinY, (int)veinZ, radius, block);
+			NotchyGen_AddSpheroid((int)veinX, (int)veinY, (int)veinZ, radius);
 		}
 	}
+	NotchyGen_FlushSpheroids();
 }
 
+static void NotchyGen_CarveCoalOre(void) { NotchyGen_CarveOreVeins(0.9f, BLOCK_COAL_ORE); }
+static void NotchyGen_CarveIronOre(void) { NotchyGen_CarveOreVeins(0.7f, BLOCK_IRON_ORE); }
+static void NotchyGen_CarveGoldOre(void) { NotchyGen_CarveOreVeins(0.5f, BLOCK_GOLD_ORE); }
+
 static void NotchyGen_FloodFillWaterBorders(void) {
 	int waterY = waterLevel - 1;
 	int index1, index2;
 	int x, z;
-	Gen_CurrentState = "Flooding edge water";
 
 	index1 = Gen_Pack(0, waterY, 0);
 	index2 = Gen_Pack(0, waterY, Gen_Length - 1);
-	for (x = 0; x < Gen_Width; x++) {
+	for (x = 0; x < Gen_Width && !gen_cancel; x++) {
 		Gen_CurrentProgress = 0.0f + ((float)x / Gen_Width) * 0.5f;
 
 		NotchyGen_FloodFill(index1, BLOCK_WATER);
@@ -329,7 +587,7 @@ static void NotchyGen_FloodFillWaterBorders(void) {
 
 	index1 = Gen_Pack(0,             waterY, 0);
 	index2 = Gen_Pack(Gen_Width - 1, waterY, 0);
-	for (z = 0; z < Gen_Length; z++) {
+	for (z = 0; z < Gen_Length && !gen_cancel; z++) {
 		Gen_CurrentProgress = 0.5f + ((float)z / Gen_Length) * 0.5f;
 
 		NotchyGen_FloodFill(index1, BLOCK_WATER);
@@ -342,9 +600,8 @@ static void NotchyGen_FloodFillWater(void) {
 	int numSources;
 	int i, x, y, z;
 
-	numSources       = Gen_Width * Gen_Length / 800;
-	Gen_CurrentState = "Flooding water";
-	for (i = 0; i < numSources; i++) {
+	numSources = Gen_Width * Gen_Length / 800;
+	for (i = 0; i < numSources && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numSources;
 
 		x = Random_Next(&rnd, Gen_Width);
@@ -358,9 +615,8 @@ static void NotchyGen_FloodFillLava(void) {
 	int numSources;
 	int i, x, y, z;
 
-	numSources       = Gen_Width * Gen_Length / 20000;
-	Gen_CurrentState = "Flooding lava";
-	for (i = 0; i < numSources; i++) {
+	numSources = Gen_Width * Gen_Length / 20000;
+	for (i = 0; i < numSources && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numSources;
 
 		x = Random_Next(&rnd, Gen_Width);
@@ -370,36 +626,37 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
+static void NotchyGen_SurfaceColumns(int x1, int z1, int x2, int z2) {
+	int hIndex, index;
 	BlockRaw above;
 	int x, y, z;
-	struct OctaveNoise n1, n2;
 
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
-
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < Gen_Length; z++) {
-		Gen_CurrentProgress = (float)z / Gen_Length;
-
-		for (x = 0; x < Gen_Width; x++) {
-			y = Heightmap[hIndex++];
+	for (z = z1; z < z2; z++) {
+		hIndex = z * Gen_Width + x1;
+		for (x = x1; x < x2; x++) {
+			y = Gen_Heightmap[hIndex++];
 			if (y < 0 || y >= Gen_Height) continue;
 
 			index = Gen_Pack(x, y, z);
 			above = y >= Gen_MaxY ? BLOCK_AIR : Gen_Blocks[index + Gen_OneY];
 
 			/* TODO: update heightmap */
-			if (above == BLOCK_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
+			if (above == BLOCK_WATER && (OctaveNoise_Calc(&gen_octave2, (float)x, (float)z) > 12)) {
 				Gen_Blocks[index] = BLOCK_GRAVEL;
 			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&gen_octave1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateSurfaceLayer(void) {
+	OctaveNoise_Init(&gen_octave1, &rnd, 8);
+	OctaveNoise_Init(&gen_octave2, &rnd, 8);
+
+	Gen_ParallelRows(NotchyGen_SurfaceColumns, 4, true);
+}
+
 static void NotchyGen_PlantFlowers(void) {
 	int numPatches;
 	BlockRaw block;
@@ -407,9 +664,8 @@ static void NotchyGen_PlantFlowers(void) {
 	int flowerX, flowerY, flowerZ;
 	int i, j, k, index;
 
-	numPatches       = Gen_Width * Gen_Length / 3000;
-	Gen_CurrentState = "Planting flowers";
-	for (i = 0; i < numPatches; i++) {
+	numPatches = Gen_Width * Gen_Length / 3000;
+	for (i = 0; i < numPatches && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numPatches;
 
 		block  = (BlockRaw)(BLOCK_DANDELION + Random_Next(&rnd, 2));
@@ -423,7 +679,7 @@ static void NotchyGen_PlantFlowers(void) {
 				flowerZ += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
 
 				if (flowerX < 0 || flowerZ < 0 || flowerX >= Gen_Width || flowerZ >= Gen_Length) continue;
-				flowerY = Heightmap[flowerZ * Gen_Width + flowerX] + 1;
+				flowerY = Gen_Heightmap[flowerZ * Gen_Width + flowerX] + 1;
 				if (flowerY <= 0 || flowerY >= Gen_Height) continue;
 
 				index = Gen_Pack(flowerX, flowerY, flowerZ);
@@ -441,9 +697,8 @@ static void NotchyGen_PlantMushrooms(void) {
 	int mushX,  mushY,  mushZ;
 	int i, j, k, index;
 
-	numPatches       = Gen_Volume / 2000;
-	Gen_CurrentState = "Planting mushrooms";
-	for (i = 0; i < numPatches; i++) {
+	numPatches = Gen_Volume / 2000;
+	for (i = 0; i < numPatches && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numPatches;
 
 		block  = (BlockRaw)(BLOCK_BROWN_SHROOM + Random_Next(&rnd, 2));
@@ -458,7 +713,7 @@ static void NotchyGen_PlantMushrooms(void) {
 				mushZ += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
 
 				if (mushX < 0 || mushZ < 0 || mushX >= Gen_Width || mushZ >= Gen_Length) continue;
-				groundHeight = Heightmap[mushZ * Gen_Width + mushX];
+				groundHeight = Gen_Heightmap[mushZ * Gen_Width + mushX];
 				if (mushY >= (groundHeight - 1)) continue;
 
 				index = Gen_Pack(mushX, mushY, mushZ);
@@ -484,9 +739,8 @@ static void NotchyGen_PlantTrees(void) {
 	Tree_Blocks = Gen_Blocks;
 	Tree_Rnd    = &rnd;
 
-	numPatches       = Gen_Width * Gen_Length / 4000;
-	Gen_CurrentState = "Planting trees";
-	for (i = 0; i < numPatches; i++) {
+	numPatches = Gen_Width * Gen_Length / 4000;
+	for (i = 0; i < numPatches && !gen_cancel; i++) {
 		Gen_CurrentProgress = (float)i / numPatches;
 
 		patchX = Random_Next(&rnd, Gen_Width);
@@ -501,7 +755,7 @@ static void NotchyGen_PlantTrees(void) {
 				if (treeX < 0 || treeZ < 0 || treeX >= Gen_Width ||
 					treeZ >= Gen_Length || Random_Float(&rnd) >= 0.25) continue;
 
-				treeY = Heightmap[treeZ * Gen_Width + treeX] + 1;
+				treeY = Gen_Heightmap[treeZ * Gen_Width + treeX] + 1;
 				if (treeY >= Gen_Height) continue;
 				treeHeight = 5 + Random_Next(&rnd, 3);
 
@@ -521,33 +775,86 @@ static void NotchyGen_PlantTrees(void) {
 	}
 }
 
+/* Stages of the original classic generator, which all use the random generator in order */
+static struct GenStage notchy_heightmap = { "Building heightmap",  NotchyGen_CreateHeightmap,
+	GEN_DATA_RANDOM,                                        GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP | GEN_DATA_WORKERS };
+static struct GenStage notchy_fill      = { "Filling map",         NotchyGen_CreateStrataFast,
+	GEN_DATA_HEIGHTMAP,                                     GEN_DATA_BLOCKS };
+static struct GenStage notchy_strata    = { "Creating strata",     NotchyGen_CreateStrata,
+	GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP,                   GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_caves     = { "Carving caves",       NotchyGen_CarveCaves,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_coal      = { "Carving coal ore",    NotchyGen_CarveCoalOre,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_iron      = { "Carving iron ore",    NotchyGen_CarveIronOre,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_gold      = { "Carving gold ore",    NotchyGen_CarveGoldOre,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_edgeWater = { "Flooding edge water", NotchyGen_FloodFillWaterBorders,
+	GEN_DATA_BLOCKS,                                        GEN_DATA_BLOCKS };
+static struct GenStage notchy_water     = { "Flooding water",      NotchyGen_FloodFillWater,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS };
+static struct GenStage notchy_lava      = { "Flooding lava",       NotchyGen_FloodFillLava,
+	GEN_DATA_RANDOM | GEN_DATA_BLOCKS,                      GEN_DATA_RANDOM | GEN_DATA_BLOCKS };
+static struct GenStage notchy_surface   = { "Creating surface",    NotchyGen_CreateSurfaceLayer,
+	GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP | GEN_DATA_BLOCKS, GEN_DATA_RANDOM | GEN_DATA_BLOCKS | GEN_DATA_WORKERS };
+static struct GenStage notchy_flowers   = { "Planting flowers",    NotchyGen_PlantFlowers,
+	GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP | GEN_DATA_BLOCKS, GEN_DATA_RANDOM | GEN_DATA_BLOCKS };
+static struct GenStage notchy_mushrooms = { "Planting mushrooms",  NotchyGen_PlantMushrooms,
+	GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP | GEN_DATA_BLOCKS, GEN_DATA_RANDOM | GEN_DATA_BLOCKS };
+static struct GenStage notchy_trees     = { "Planting trees",      NotchyGen_PlantTrees,
+	GEN_DATA_RANDOM | GEN_DATA_HEIGHTMAP | GEN_DATA_BLOCKS, GEN_DATA_RANDOM | GEN_DATA_BLOCKS };
+
+static struct GenStage* notchy_stages[GEN_MAX_STAGES] = {
+	&notchy_heightmap, &notchy_fill, &notchy_strata,  &notchy_caves,
+	&notchy_coal,      &notchy_iron, &notchy_gold,    &notchy_edgeWater,
+	&notchy_water,     &notchy_lava, &notchy_surface, &notchy_flowers,
+	&notchy_mushrooms, &notchy_trees
+};
+static int notchy_stagesCount = 14;
+
+bool NotchyGen_AddStage(struct GenStage* stage, const char* after) {
+	String name;
+	int i, j = notchy_stagesCount;
+	if (notchy_stagesCount == GEN_MAX_STAGES) return false;
+
+	if (after) {
+		for (j = 0; j < notchy_stagesCount; j++) {
+			name = String_FromReadonly(notchy_stages[j]->Name);
+			if (String_CaselessEqualsConst(&name, after)) break;
+		}
+		if (j == notchy_stagesCount) return false;
+		j++;
+	}
+
+	for (i = notchy_stagesCount; i > j; i--) {
+		notchy_stages[i] = notchy_stages[i - 1];
+	}
+	notchy_stages[j] = stage;
+	notchy_stagesCount++;
+	return true;
+}
+
+struct GenStage* NotchyGen_GetStage(int i) {
+	return i < notchy_stagesCount ? notchy_stages[i] : NULL;
+}
+
 void NotchyGen_Generate(void) {
 	Gen_Init();
-	Heightmap = Mem_Alloc(Gen_Width * Gen_Length, 2, "gen heightmap");
+	FloodFill_Init(&gen_flood, Gen_Blocks, Gen_Width, Gen_Height, Gen_Length);
 
 	Random_Init(&rnd, Gen_Seed);
 	waterLevel = Gen_Height / 2;	
 	minHeight = Gen_Height;
 
-	NotchyGen_CreateHeightmap();
-	NotchyGen_CreateStrata();
-	NotchyGen_CarveCaves();
-	NotchyGen_CarveOreVeins(0.9f, "Carving coal ore", BLOCK_COAL_ORE);
-	NotchyGen_CarveOreVeins(0.7f, "Carving iron ore", BLOCK_IRON_ORE);
-	NotchyGen_CarveOreVeins(0.5f, "Carving gold ore", BLOCK_GOLD_ORE);
-
-	NotchyGen_FloodFillWaterBorders();
-	NotchyGen_FloodFillWater();
-	NotchyGen_FloodFillLava();
-
-	NotchyGen_CreateSurfaceLayer();
-	NotchyGen_PlantFlowers();
-	NotchyGen_PlantMushrooms();
-	NotchyGen_PlantTrees();
+	Gen_RunStages(notchy_stages, notchy_stagesCount);
 
-	Mem_Free(Heightmap);
-	Heightmap = NULL;
-	Gen_Done  = true;
+	Mem_Free(Gen_Heightmap);
+	Mem_Free(gen_spheroids);
+	FloodFill_Free(&gen_flood);
+	Gen_Heightmap = NULL;
+	gen_spheroids = NULL;
+	Gen_Done      = true;
 }
 
 
@@ -608,6 +915,61 @@ float ImprovedNoise_Calc(uint8_t* p, float x, float y) {
 }
 
 
+/* Same as xFlags and yFlags in ImprovedNoise_Calc, but unpacked so they can be looked up per sample */
+static const float noise_gradX[16] = { 1, -1, 1, -1, 1, -1, 1, -1, 0,  0, 0,  0, 1,  0, -1,  0 };
+static const float noise_gradY[16] = { 1,  1,-1, -1, 0,  0, 0,  0, 1, -1, 1, -1, 1, -1,  1, -1 };
+
+/* Evaluates a block of at most NOISE_BATCH_SIZE samples. Work is split into passes, so that */
+/*  the arithmetic passes have no table lookups and can be vectorised by the compiler. */
+/* NOTE: Arithmetic must be kept in exactly the same order as ImprovedNoise_Calc */
+static void ImprovedNoise_CalcBlock(uint8_t* p, const float* xs, const float* ys, float freq, float amplitude, float* out, int count) {
+	float x[NOISE_BATCH_SIZE], y[NOISE_BATCH_SIZE];
+	float u[NOISE_BATCH_SIZE], v[NOISE_BATCH_SIZE];
+	int   X[NOISE_BATCH_SIZE], Y[NOISE_BATCH_SIZE];
+	float gAX[NOISE_BATCH_SIZE], gAY[NOISE_BATCH_SIZE], gBX[NOISE_BATCH_SIZE], gBY[NOISE_BATCH_SIZE];
+	float gCX[NOISE_BATCH_SIZE], gCY[NOISE_BATCH_SIZE], gDX[NOISE_BATCH_SIZE], gDY[NOISE_BATCH_SIZE];
+	float g22, g12, c1, g21, g11, c2;
+	int i, xFloor, yFloor, A, B, hash;
+
+	for (i = 0; i < count; i++) {
+		x[i] = xs[i] * freq; y[i] = ys[i] * freq;
+		xFloor = (int)x[i] - (x[i] < 0); yFloor = (int)y[i] - (y[i] < 0);
+		X[i] = xFloor & 0xFF; Y[i] = yFloor & 0xFF;
+		x[i] -= xFloor;       y[i] -= yFloor;
+
+		u[i] = x[i] * x[i] * x[i] * (x[i] * (x[i] * 6 - 15) + 10); /* Fade(x) */
+		v[i] = y[i] * y[i] * y[i] * (y[i] * (y[i] * 6 - 15) + 10); /* Fade(y) */
+	}
+
+	for (i = 0; i < count; i++) {
+		A = p[X[i]] + Y[i]; B = p[X[i] + 1] + Y[i];
+		hash = p[p[A]]     & 0xF; gAX[i] = noise_gradX[hash]; gAY[i] = noise_gradY[hash];
+		hash = p[p[B]]     & 0xF; gBX[i] = noise_gradX[hash]; gBY[i] = noise_gradY[hash];
+		hash = p[p[A + 1]] & 0xF; gCX[i] = noise_gradX[hash]; gCY[i] = noise_gradY[hash];
+		hash = p[p[B + 1]] & 0xF; gDX[i] = noise_gradX[hash]; gDY[i] = noise_gradY[hash];
+	}
+
+	for (i = 0; i < count; i++) {
+		g22 = gAX[i] * x[i]       + gAY[i] * y[i];
+		g12 = gBX[i] * (x[i] - 1) + gBY[i] * y[i];
+		c1  = g22 + u[i] * (g12 - g22);
+
+		g21 = gCX[i] * x[i]       + gCY[i] * (y[i] - 1);
+		g11 = gDX[i] * (x[i] - 1) + gDY[i] * (y[i] - 1);
+		c2  = g21 + u[i] * (g11 - g21);
+
+		out[i] += (c1 + v[i] * (c2 - c1)) * amplitude;
+	}
+}
+
+void ImprovedNoise_CalcBatch(uint8_t* p, const float* xs, const float* ys, float freq, float amplitude, float* out, int count) {
+	int i;
+	for (i = 0; i < count; i += NOISE_BATCH_SIZE) {
+		ImprovedNoise_CalcBlock(p, xs + i, ys + i, freq, amplitude, out + i, min(count - i, NOISE_BATCH_SIZE));
+	}
+}
+
+
 void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
 	int i;
 	n->octaves = octaves;
@@ -631,6 +993,19 @@ float OctaveNoise_Calc(struct OctaveNoise* n, float x, float y) {
 }
 
 
+void OctaveNoise_CalcBatch(struct OctaveNoise* n, const float* xs, const float* ys, float* out, int count) {
+	float amplitude = 1, freq = 1;
+	int i;
+	for (i = 0; i < count; i++) { out[i] = 0; }
+
+	for (i = 0; i < n->octaves; i++) {
+		ImprovedNoise_CalcBatch(n->p[i], xs, ys, freq, amplitude, out, count);
+		amplitude *= 2.0f;
+		freq *= 0.5f;
+	}
+}
+
+
 void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octaves1, int octaves2) {
 	OctaveNoise_Init(&n->noise1, rnd, octaves1);
 	OctaveNoise_Init(&n->noise2, rnd, octaves2);
@@ -641,6 +1016,19 @@ float CombinedNoise_Calc(struct CombinedNoise* n, float x, float y) {
 	return OctaveNoise_Calc(&n->noise1, x + offset, y);
 }
 
+void CombinedNoise_CalcBatch(struct CombinedNoise* n, const float* xs, const float* ys, float* out, int count) {
+	float offsetXs[NOISE_BATCH_SIZE];
+	int i, j, blockCount;
+
+	for (i = 0; i < count; i += NOISE_BATCH_SIZE) {
+		blockCount = min(count - i, NOISE_BATCH_SIZE);
+		OctaveNoise_CalcBatch(&n->noise2, xs + i, ys + i, offsetXs, blockCount);
+
+		for (j = 0; j < blockCount; j++) { offsetXs[j] += xs[i + j]; }
+		OctaveNoise_CalcBatch(&n->noise1, offsetXs, ys + i, out + i, blockCount);
+	}
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Tree generation------------------------------------------------------*
@@ -730,3 +1118,76 @@ int TreeGen_Grow(int treeX, int treeY, int treeZ, int height, Vector3I* coords,
 	}
 	return count;
 }
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Flood filling-------------------------------------------------------*
+*#########################################################################################################################*/
+void FloodFill_Init(struct FloodFill* f, BlockRaw* blocks, int width, int height, int length) {
+	f->Blocks = blocks;
+	f->Width  = width; f->Height = height; f->Length = length;
+
+	f->Stack      = f->DefaultStack;
+	f->StackCount = 0;
+	f->StackMax   = FLOODFILL_DEF_ELEMS;
+}
+
+void FloodFill_Free(struct FloodFill* f) {
+	if (f->Stack != f->DefaultStack) Mem_Free(f->Stack);
+	f->Stack    = f->DefaultStack;
+	f->StackMax = FLOODFILL_DEF_ELEMS;
+}
+
+static void FloodFill_Push(struct FloodFill* f, int32_t index) {
+	if (f->StackCount == f->StackMax) {
+		f->Stack = Utils_Resize(f->Stack, &f->StackMax, sizeof(int32_t), FLOODFILL_DEF_ELEMS, f->StackMax);
+	}
+	f->Stack[f->StackCount++] = index;
+}
+
+/* Pushes the first block of every run of target blocks between minX and maxX in the given row */
+static void FloodFill_PushRuns(struct FloodFill* f, int rowIndex, int minX, int maxX, BlockRaw target) {
+	BlockRaw* row = f->Blocks + rowIndex;
+	bool inRun    = false;
+	int x;
+
+	for (x = minX; x <= maxX; x++) {
+		if (row[x] != target) { inRun = false; continue; }
+		if (!inRun) FloodFill_Push(f, rowIndex + x);
+		inRun = true;
+	}
+}
+
+int FloodFill_Run(struct FloodFill* f, int startIndex, BlockRaw target, BlockRaw block) {
+	BlockRaw* blocks = f->Blocks;
+	int width = f->Width, oneY = f->Width * f->Length;
+	int index, rowIndex, filled = 0;
+	int x, y, z, minX, maxX;
+
+	if (startIndex < 0 || startIndex >= oneY * f->Height || target == block) return 0;
+	f->StackCount = 0;
+	FloodFill_Push(f, startIndex);
+
+	while (f->StackCount) {
+		index = f->Stack[--f->StackCount];
+		/* Run may have been filled in since it was pushed */
+		if (blocks[index] != target) continue;
+
+		x = index  % width;
+		y = index  / oneY;
+		z = (index / width) % f->Length;
+		rowIndex = index - x;
+
+		/* Fill in the whole run of target blocks along the X axis at once */
+		for (minX = x; minX > 0         && blocks[rowIndex + minX - 1] == target; minX--) {}
+		for (maxX = x; maxX < width - 1 && blocks[rowIndex + maxX + 1] == target; maxX++) {}
+		Mem_Set(blocks + rowIndex + minX, block, maxX - minX + 1);
+		filled += maxX - minX + 1;
+
+		if (z > 0)             FloodFill_PushRuns(f, rowIndex - width, minX, maxX, target);
+		if (z < f->Length - 1) FloodFill_PushRuns(f, rowIndex + width, minX, maxX, target);
+		if (y > 0)             FloodFill_PushRuns(f, rowIndex - oneY,  minX, maxX, target);
+	}
+	return filled;
+}
+
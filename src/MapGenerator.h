@@ -12,25 +12,73 @@
 extern volatile float Gen_CurrentProgress;
 extern volatile const char* Gen_CurrentState;
 extern volatile bool Gen_Done;
-extern int Gen_Width, Gen_Height, Gen_Length, Gen_Seed;
+CC_VAR extern int Gen_Width, Gen_Height, Gen_Length, Gen_Seed;
 extern bool Gen_Vanilla;
-extern BlockRaw* Gen_Blocks;
-#define Gen_SetDimensions(x, y, z) Gen_Width = x; Gen_Height = y; Gen_Length = z;
+CC_VAR extern BlockRaw* Gen_Blocks;
+/* Sets dimensions of the map to generate. */
+/* NOTE: Stops generating the current map, if it still is. */
+void Gen_SetDimensions(int width, int height, int length);
 
 void FlatgrassGen_Generate(void);
 void NotchyGen_Generate(void);
 
+/* Height of the ground in each column of the map, calculated by the vanilla generator. */
+/* NOTE: Only valid from when the "Building heightmap" stage has run until generation ends. */
+CC_VAR extern int16_t* Gen_Heightmap;
+/* Data that stages of the vanilla generator read from and write to. */
+enum GenData_ {
+	GEN_DATA_BLOCKS    = 0x01, /* Gen_Blocks */
+	GEN_DATA_HEIGHTMAP = 0x02, /* Gen_Heightmap */
+	GEN_DATA_RANDOM    = 0x04, /* Random number generator, which stages use one after another */
+	GEN_DATA_WORKERS   = 0x08, /* Worker threads for splitting up a stage, which one stage can use at a time */
+	GEN_DATA_CUSTOM    = 0x100 /* First flag available for data used by stages from plugins */
+};
+
+#define GEN_MAX_STAGES 32
+/* A unit of work that is part of the vanilla generator. */
+/* Consecutive stages run concurrently, when none of them writes to data another uses. */
+struct GenStage {
+	const char* Name;  /* Shown as Gen_CurrentState while the stage is running */
+	void (*Run)(void);
+	int Reads, Writes; /* GEN_DATA flags of the data this stage reads from and writes to */
+	int Time;          /* Time taken in microseconds, last time this stage ran */
+	uint32_t Memory;   /* Bytes allocated through Gen_Alloc, last time this stage ran */
+};
+/* Adds a stage to the vanilla generator, after the stage with the given name. (or at end if NULL) */
+/* Returns false if no stage has that name, or if there are already GEN_MAX_STAGES stages. */
+CC_API bool NotchyGen_AddStage(struct GenStage* stage, const char* after);
+/* Returns the stage of the vanilla generator at the given index, or NULL if past the last stage. */
+CC_API struct GenStage* NotchyGen_GetStage(int i);
+/* Allocates memory that is counted towards the memory of the stage currently running. */
+CC_API void* Gen_Alloc(uint32_t numElems, uint32_t elemsSize, const char* place);
+
+/* Starts generating the map on a background thread, using the vanilla or flatgrass generator. */
+/* Gen_Done is set once the map has been completely generated. */
+void Gen_Start(void);
+/* Cancels generation if it is still running, then waits for the generator thread to exit. */
+/* NOTE: Also frees Gen_Blocks, unless the world is using it as World_Blocks. */
+void Gen_Stop(void);
+
 #define NOISE_TABLE_SIZE 512
+/* Batch functions evaluate this many samples at once internally. */
+#define NOISE_BATCH_SIZE 64
 void ImprovedNoise_Init(uint8_t* p, RNGState* rnd);
 float ImprovedNoise_Calc(uint8_t* p, float x, float y);
+/* Adds ImprovedNoise_Calc(p, xs[i] * freq, ys[i] * freq) * amplitude to out[i] for each sample. */
+/* NOTE: Results are exactly the same as the ones from calling ImprovedNoise_Calc for each sample. */
+void ImprovedNoise_CalcBatch(uint8_t* p, const float* xs, const float* ys, float freq, float amplitude, float* out, int count);
 
 struct OctaveNoise { uint8_t p[8][NOISE_TABLE_SIZE]; int octaves; };
 void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves);
 float OctaveNoise_Calc(struct OctaveNoise* n, float x, float y);
+/* Sets out[i] to OctaveNoise_Calc(n, xs[i], ys[i]) for each sample. */
+void OctaveNoise_CalcBatch(struct OctaveNoise* n, const float* xs, const float* ys, float* out, int count);
 
 struct CombinedNoise { struct OctaveNoise noise1, noise2; };
 void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octaves1, int octaves2);
 float CombinedNoise_Calc(struct CombinedNoise* n, float x, float y);
+/* Sets out[i] to CombinedNoise_Calc(n, xs[i], ys[i]) for each sample. */
+void CombinedNoise_CalcBatch(struct CombinedNoise* n, const float* xs, const float* ys, float* out, int count);
 
 
 extern int Tree_Width, Tree_Height, Tree_Length;
@@ -44,4 +92,22 @@ bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight);
 /* Generates the blocks (and their positions in the world) that actually make up a tree. */
 /* Returns the number of blocks generated, which will be <= TREE_MAX_COUNT */
 int  TreeGen_Grow(int treeX, int treeY, int treeZ, int height, Vector3I* coords, BlockRaw* blocks);
+
+#define FLOODFILL_DEF_ELEMS 256
+/* Replaces connected runs of a block with another block, one X span at a time. */
+/* Like liquids, filling only spreads sideways and downwards, never upwards. */
+struct FloodFill {
+	BlockRaw* Blocks;
+	int Width, Height, Length;
+	int32_t* Stack;
+	uint32_t StackCount, StackMax;
+	int32_t DefaultStack[FLOODFILL_DEF_ELEMS];
+};
+/* Initialises flood filling for the given blocks array, which is in the same layout as the world's. */
+void FloodFill_Init(struct FloodFill* f, BlockRaw* blocks, int width, int height, int length);
+/* Frees the work stack, if it had to be expanded. */
+void FloodFill_Free(struct FloodFill* f);
+/* Replaces all target blocks connected to the block at the given index with block. */
+/* Returns the number of blocks replaced, which is 0 if the starting block is not target. */
+int  FloodFill_Run(struct FloodFill* f, int startIndex, BlockRaw target, BlockRaw block);
 #endif
@@ -12,6 +12,8 @@
 #include "Block.h"
 #include "Stream.h"
 #include "Funcs.h"
+#include "Platform.h"
+#include "Utils.h"
 
 struct _ModelsData Models;
 
@@ -23,6 +25,146 @@ struct _ModelsData Models;
 #define AABB_Length(bb) ((bb)->Max.Z - (bb)->Min.Z)
 
 
+/*########################################################################################################################*
+*---------------------------------------------------------Model batch-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Vertices of one pass of drawing an entity, (e.g. the alpha tested outer layer of a humanoid) */
+struct ModelBatchRun { GfxResourceID Tex; bool AlphaTest; int Offset, Count; };
+#define MODEL_BATCH_VERTICES 16384
+
+static bool model_batching;  /* Whether Models_BeginBatch has been called */
+static bool model_capturing; /* Whether the entity being drawn is being added to the batch */
+static struct Matrix* model_batchTransform;
+static GfxResourceID model_batchTex, model_batchVb;
+static bool model_batchAlphaTest;
+
+static VertexP3fT2fC4b* model_batchVertices;
+static VertexP3fT2fC4b* model_batchStaging;
+static uint32_t model_batchVerticesMax;
+static int model_batchVerticesCount;
+
+static struct ModelBatchRun* model_batchRuns;
+static uint32_t model_batchRunsMax;
+static int model_batchRunsCount;
+
+void Models_BeginBatch(void) {
+	if (!model_batchStaging) {
+		model_batchStaging = Mem_Alloc(MODEL_BATCH_VERTICES, sizeof(VertexP3fT2fC4b), "model batch");
+	}
+	model_batching = true;
+}
+
+/* Returns where the next count vertices of the active model should be written to. */
+static VertexP3fT2fC4b* Model_GetVertices(struct Model* model, int count) {
+	if (!model_capturing) return &Models.Vertices[model->index];
+
+	if (model_batchVerticesCount + model->index + count > model_batchVerticesMax) {
+		model_batchVertices = Utils_Resize(model_batchVertices, &model_batchVerticesMax,
+										sizeof(VertexP3fT2fC4b), 0, MODEL_BATCH_VERTICES);
+	}
+	return &model_batchVertices[model_batchVerticesCount + model->index];
+}
+
+/* Transforms the vertices of the current pass into world space and adds them to the batch. */
+static void Model_AddBatchRun(int count) {
+	VertexP3fT2fC4b* v = &model_batchVertices[model_batchVerticesCount];
+	struct Matrix* m   = model_batchTransform;
+	struct ModelBatchRun* run;
+	float x, y, z;
+	int i;
+	if (!count) return;
+
+	for (i = 0; i < count; i++, v++) {
+		x = v->X; y = v->Y; z = v->Z;
+		v->X = x * m->Row0.X + y * m->Row1.X + z * m->Row2.X + m->Row3.X;
+		v->Y = x * m->Row0.Y + y * m->Row1.Y + z * m->Row2.Y + m->Row3.Y;
+		v->Z = x * m->Row0.Z + y * m->Row1.Z + z * m->Row2.Z + m->Row3.Z;
+	}
+
+	if (model_batchRunsCount == model_batchRunsMax) {
+		model_batchRuns = Utils_Resize(model_batchRuns, &model_batchRunsMax,
+										sizeof(struct ModelBatchRun), 0, 256);
+	}
+	run = &model_batchRuns[model_batchRunsCount++];
+	run->Tex       = model_batchTex;
+	run->AlphaTest = model_batchAlphaTest;
+	run->Offset    = model_batchVerticesCount;
+	run->Count     = count;
+	model_batchVerticesCount += count;
+}
+
+static int Model_CompareRuns(struct ModelBatchRun* a, struct ModelBatchRun* b) {
+	if (a->Tex != b->Tex) return (uintptr_t)a->Tex < (uintptr_t)b->Tex ? -1 : 1;
+	return a->AlphaTest - b->AlphaTest;
+}
+
+static void Models_SortRuns(int left, int right) {
+	struct ModelBatchRun* keys = model_batchRuns; struct ModelBatchRun key;
+
+	while (left < right) {
+		int i = left, j = right;
+		struct ModelBatchRun pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (Model_CompareRuns(&keys[i], &pivot) < 0) i++;
+			while (Model_CompareRuns(&keys[j], &pivot) > 0) j--;
+			QuickSort_Swap_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Models_SortRuns)
+	}
+}
+
+void Models_EndBatch(void) {
+	struct ModelBatchRun* run;
+	struct ModelBatchRun* group = NULL;
+	int i, count = 0;
+
+	model_batching = false;
+	if (!model_batchRunsCount) return;
+	Models_SortRuns(0, model_batchRunsCount - 1);
+	Gfx_SetVertexFormat(VERTEX_FORMAT_P3FT2FC4B);
+
+	for (i = 0; i < model_batchRunsCount; i++) {
+		run = &model_batchRuns[i];
+		if (group && (Model_CompareRuns(run, group) || count + run->Count > MODEL_BATCH_VERTICES)) {
+			Gfx_UpdateDynamicVb_IndexedTris(model_batchVb, model_batchStaging, count);
+			count = 0;
+		}
+
+		if (!count) {
+			group = run;
+			Gfx_BindTexture(run->Tex);
+			Gfx_SetAlphaTest(run->AlphaTest);
+		}
+		Mem_Copy(&model_batchStaging[count], &model_batchVertices[run->Offset], run->Count * sizeof(VertexP3fT2fC4b));
+		count += run->Count;
+	}
+
+	Gfx_UpdateDynamicVb_IndexedTris(model_batchVb, model_batchStaging, count);
+	Gfx_SetAlphaTest(true);
+	model_batchRunsCount     = 0;
+	model_batchVerticesCount = 0;
+}
+
+void Model_BindTexture(GfxResourceID tex) {
+	if (model_capturing) {
+		model_batchTex = tex;
+	} else {
+		Gfx_BindTexture(tex);
+	}
+}
+
+void Model_SetAlphaTest(bool enabled) {
+	if (model_capturing) {
+		model_batchAlphaTest = enabled;
+	} else {
+		Gfx_SetAlphaTest(enabled);
+	}
+}
+
+
 /*########################################################################################################################*
 *------------------------------------------------------------Model--------------------------------------------------------*
 *#########################################################################################################################*/
@@ -38,6 +180,7 @@ void Model_Init(struct Model* model) {
 	model->CalcHumanAnims = false;
 	model->UsesHumanSkin  = false;
 	model->Pushes = true;
+	model->Batched = false;
 
 	model->Gravity        = 0.08f;
 	model->Drag           = Vector3_Create3(0.91f, 0.98f, 0.91f);
@@ -98,9 +241,20 @@ void Model_Render(struct Model* model, struct Entity* entity) {
 	if (model->Bobbing) pos.Y += entity->Anim.BobbingModel;
 
 	Model_SetupState(model, entity);
-	Gfx_SetVertexFormat(VERTEX_FORMAT_P3FT2FC4B);
-
 	model->GetTransform(entity, pos, &entity->Transform);
+
+	if (model_batching && model->Batched) {
+		/* Alpha testing is always enabled before drawing a model in Entities_RenderModels */
+		model_capturing      = true;
+		model_batchTransform = &entity->Transform;
+		model_batchAlphaTest = true;
+
+		model->Draw(entity);
+		model_capturing = false;
+		return;
+	}
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_P3FT2FC4B);
 	Matrix_Mul(&m, &entity->Transform, &Gfx_View);
 
 	Gfx_LoadMatrix(MATRIX_VIEW, &m);
@@ -143,7 +297,11 @@ void Model_SetupState(struct Model* model, struct Entity* entity) {
 
 void Model_UpdateVB(void) {
 	struct Model* model = Models.Active;
-	Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, Models.Vertices, model->index);
+	if (model_capturing) {
+		Model_AddBatchRun(model->index);
+	} else {
+		Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, Models.Vertices, model->index);
+	}
 	model->index = 0;
 }
 
@@ -162,7 +320,7 @@ void Model_ApplyTexture(struct Entity* entity) {
 		Models.skinType = data->SkinType;
 	}
 
-	Gfx_BindTexture(tex);
+	Model_BindTexture(tex);
 	_64x64 = Models.skinType != SKIN_64x32;
 
 	Models.uScale = entity->uScale * 0.015625f;
@@ -172,7 +330,7 @@ void Model_ApplyTexture(struct Entity* entity) {
 void Model_DrawPart(struct ModelPart* part) {
 	struct Model* model     = Models.Active;
 	struct ModelVertex* src = &model->vertices[part->Offset];
-	VertexP3fT2fC4b* dst    = &Models.Vertices[model->index];
+	VertexP3fT2fC4b* dst    = Model_GetVertices(model, part->Count);
 
 	struct ModelVertex v;
 	int i, count = part->Count;
@@ -196,7 +354,7 @@ void Model_DrawPart(struct ModelPart* part) {
 void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, bool head) {
 	struct Model* model     = Models.Active;
 	struct ModelVertex* src = &model->vertices[part->Offset];
-	VertexP3fT2fC4b* dst    = &Models.Vertices[model->index];
+	VertexP3fT2fC4b* dst    = Model_GetVertices(model, part->Count);
 
 	float cosX = (float)Math_Cos(-angleX), sinX = (float)Math_Sin(-angleX);
 	float cosY = (float)Math_Cos(-angleY), sinY = (float)Math_Sin(-angleY);
@@ -371,10 +529,12 @@ static struct ModelTex* textures_head;
 
 static void Models_ContextLost(void* obj) {
 	Gfx_DeleteVb(&Models.Vb);
+	Gfx_DeleteVb(&model_batchVb);
 }
 
 static void Models_ContextRecreated(void* obj) {
-	Models.Vb = Gfx_CreateDynamicVb(VERTEX_FORMAT_P3FT2FC4B, Models.MaxVertices);
+	Models.Vb     = Gfx_CreateDynamicVb(VERTEX_FORMAT_P3FT2FC4B, Models.MaxVertices);
+	model_batchVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_P3FT2FC4B, MODEL_BATCH_VERTICES);
 }
 
 static void Model_Make(struct Model* model) {
@@ -446,7 +606,7 @@ static void HumanModel_DrawModelSet(struct Entity* entity, struct ModelSet* mode
 	int type;
 
 	Model_ApplyTexture(entity);
-	Gfx_SetAlphaTest(false);
+	Model_SetAlphaTest(false);
 
 	type = Models.skinType;
 	set  = &model->Limbs[type & 0x3];
@@ -462,7 +622,7 @@ static void HumanModel_DrawModelSet(struct Entity* entity, struct ModelSet* mode
 	Models.Rotation = ROTATE_ORDER_ZYX;
 	Model_UpdateVB();
 
-	Gfx_SetAlphaTest(true);
+	Model_SetAlphaTest(true);
 	if (type != SKIN_64x32) {
 		Model_DrawPart(&model->TorsoLayer);
 		Model_DrawRotate(entity->Anim.LeftLegX,  0, entity->Anim.LeftLegZ,  &set->LeftLegLayer,  false);
@@ -638,6 +798,7 @@ static struct Model  human_model = {
 
 static struct Model* HumanoidModel_GetInstance(void) {
 	Model_Init(&human_model);
+	human_model.Batched = true;
 	human_model.DrawArm  = HumanModel_DrawArm;
 	human_model.CalcHumanAnims = true;
 	human_model.UsesHumanSkin  = true;
@@ -727,6 +888,7 @@ static struct Model chibi_model = { "chibi", chibi_vertices, &human_tex,
 
 static struct Model* ChibiModel_GetInstance(void) {
 	Model_Init(&chibi_model);
+	chibi_model.Batched = true;
 	chibi_model.DrawArm  = ChibiModel_DrawArm;
 	chibi_model.armX = 3; chibi_model.armY = 6;
 	chibi_model.CalcHumanAnims = true;
@@ -765,6 +927,7 @@ static struct Model sitting_model = { "sit", human_vertices, &human_tex,
 
 static struct Model* SittingModel_GetInstance(void) {
 	Model_Init(&sitting_model);
+	sitting_model.Batched = true;
 	sitting_model.DrawArm  = HumanModel_DrawArm;
 	sitting_model.CalcHumanAnims = true;
 	sitting_model.UsesHumanSkin  = true;
@@ -827,6 +990,7 @@ static struct Model head_model = { "head", human_vertices, &human_tex,
 
 static struct Model* HeadModel_GetInstance(void) {
 	Model_Init(&head_model);
+	head_model.Batched = true;
 	head_model.UsesHumanSkin = true;
 	head_model.Pushes        = false;
 	head_model.GetTransform  = HeadModel_GetTransform;
@@ -936,6 +1100,7 @@ static struct Model chicken_model = { "chicken", chicken_vertices, &chicken_tex,
 
 static struct Model* ChickenModel_GetInstance(void) {
 	Model_Init(&chicken_model);
+	chicken_model.Batched = true;
 	return &chicken_model;
 }
 
@@ -1014,6 +1179,7 @@ static struct Model creeper_model  = {
 
 static struct Model* CreeperModel_GetInstance(void) {
 	Model_Init(&creeper_model);
+	creeper_model.Batched = true;
 	return &creeper_model;
 }
 
@@ -1091,6 +1257,7 @@ static struct Model pig_model  = { "pig", pig_vertices, &pig_tex,
 
 static struct Model* PigModel_GetInstance(void) {
 	Model_Init(&pig_model);
+	pig_model.Batched = true;
 	return &pig_model;
 }
 
@@ -1202,7 +1369,7 @@ static void FurlessModel_Draw(struct Entity* entity) {
 
 static void SheepModel_Draw(struct Entity* entity) {
 	FurlessModel_Draw(entity);
-	Gfx_BindTexture(fur_tex.TexID);
+	Model_BindTexture(fur_tex.TexID);
 	Model_DrawRotate(-entity->HeadX * MATH_DEG2RAD, 0, 0, &fur_head, true);
 
 	Model_DrawPart(&fur_torso);
@@ -1233,11 +1400,13 @@ static struct Model nofur_model  = { "sheep_nofur", sheep_vertices, &sheep_tex,
 
 static struct Model* SheepModel_GetInstance(void) {
 	Model_Init(&sheep_model);
+	sheep_model.Batched = true;
 	return &sheep_model;
 }
 
 static struct Model* NoFurModel_GetInstance(void) {
 	Model_Init(&nofur_model);
+	nofur_model.Batched = true;
 	return &nofur_model;
 }
 
@@ -1318,6 +1487,7 @@ static struct Model skeleton_model  = { "skeleton", skeleton_vertices, &skeleton
 
 static struct Model* SkeletonModel_GetInstance(void) {
 	Model_Init(&skeleton_model);
+	skeleton_model.Batched = true;
 	skeleton_model.DrawArm  = SkeletonModel_DrawArm;
 	skeleton_model.armX = 5;
 	return &skeleton_model;
@@ -1408,6 +1578,7 @@ static struct Model spider_model  = { "spider", spider_vertices, &spider_tex,
 
 static struct Model* SpiderModel_GetInstance(void) {
 	Model_Init(&spider_model);
+	spider_model.Batched = true;
 	return &spider_model;
 }
 
@@ -1446,6 +1617,7 @@ static struct Model zombie_model  = { "zombie", human_vertices, &zombie_tex,
 
 static struct Model* ZombieModel_GetInstance(void) {
 	Model_Init(&zombie_model);
+	zombie_model.Batched = true;
 	zombie_model.DrawArm  = ZombieModel_DrawArm;
 	return &zombie_model;
 }
@@ -1708,6 +1880,13 @@ static void Models_Free(void) {
 	}
 	Models_ContextLost(NULL);
 
+	Mem_Free(model_batchVertices);
+	Mem_Free(model_batchStaging);
+	Mem_Free(model_batchRuns);
+	model_batchVertices = NULL; model_batchVerticesMax = 0;
+	model_batchStaging  = NULL;
+	model_batchRuns     = NULL; model_batchRunsMax     = 0;
+
 	Event_UnregisterEntry(&TextureEvents.FileChanged, NULL, Models_TextureChanged);
 	Event_UnregisterVoid(&GfxEvents.ContextLost,      NULL, Models_ContextLost);
 	Event_UnregisterVoid(&GfxEvents.ContextRecreated, NULL, Models_ContextRecreated);
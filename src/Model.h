@@ -71,6 +71,9 @@ struct Model {
 	/* e.g. for HumanoidModel, when legs are at the peak of their swing, whole model is moved slightly down */
 	bool Bobbing;
 	bool UsesSkin, CalcHumanAnims, UsesHumanSkin, Pushes;
+	/* Whether this model can be drawn as part of a batch of entities. (see Models_BeginBatch) */
+	/* NOTE: Draw must only change state through Model_BindTexture and Model_SetAlphaTest. */
+	bool Batched;
 
 	float Gravity; Vector3 Drag, GroundFriction;
 
@@ -131,6 +134,10 @@ CC_API void Model_UpdateVB(void);
 /* Applies the skin texture of the given entity to the model. */
 /* Uses model's default texture if the entity doesn't have a custom skin. */
 CC_API void Model_ApplyTexture(struct Entity* entity);
+/* Binds the given texture, or sets the texture of the current pass when batching. */
+CC_API void Model_BindTexture(GfxResourceID tex);
+/* Sets whether alpha testing is used, or sets it for the current pass when batching. */
+CC_API void Model_SetAlphaTest(bool enabled);
 /* Draws the given part with no part-specific rotation (e.g. torso). */
 CC_API void Model_DrawPart(struct ModelPart* part);
 /* Draws the given part with rotation around part's rotation origin. (e.g. arms, head) */
@@ -140,6 +147,14 @@ void Model_RenderArm(struct Model* model, struct Entity* entity);
 /* Draws the given part with appropriate rotation to produce an arm look. */
 CC_API void Model_DrawArmPart(struct ModelPart* part);
 
+/* Starts buffering entities drawn by Model_Render, for models that have Batched set. */
+/* Buffered vertices are transformed into world space on the CPU, so that entities sharing */
+/*  the same texture can be drawn together in one draw call, instead of several per entity. */
+/* NOTE: Other models are still drawn immediately, exactly as when not batching. */
+void Models_BeginBatch(void);
+/* Draws all entities buffered since Models_BeginBatch, grouped by texture and alpha testing. */
+void Models_EndBatch(void);
+
 /* Returns a pointer to the model whose name caselessly matches given name. */
 CC_API struct Model* Model_Get(const String* name);
 /* Returns index of the model texture whose name caselessly matches given name. */
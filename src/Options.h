@@ -14,11 +14,13 @@ extern const char* FpsLimit_Names[FPS_LIMIT_COUNT];
 #define OPT_USE_SOUND "usesound"
 #define OPT_MUSIC_VOLUME "musicvolume"
 #define OPT_SOUND_VOLUME "soundsvolume"
+#define OPT_SERVER_BLOCK_SOUNDS "sounds-serverblocks"
 #define OPT_FORCE_OPENAL "forceopenal"
 #define OPT_FORCE_OLD_OPENGL "force-oldgl"
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
+#define OPT_PHYSICS_WORKERS "physics-workers"
 #define OPT_NAMES_MODE "namesmode"
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
@@ -27,6 +29,8 @@ extern const char* FpsLimit_Names[FPS_LIMIT_COUNT];
 #define OPT_AUTO_CLOSE_LAUNCHER "autocloselauncher"
 #define OPT_VIEW_BOBBING "viewbobbing"
 #define OPT_ENTITY_SHADOW "entityshadow"
+#define OPT_ENTITY_LOD_NEAR "entity-lodnear"
+#define OPT_ENTITY_LOD_MEDIUM "entity-lodmedium"
 #define OPT_RENDER_TYPE "normal"
 #define OPT_SMOOTH_LIGHTING "gfx-smoothlighting"
 #define OPT_MIPMAPS "gfx-mipmaps"
@@ -70,6 +74,10 @@ extern const char* FpsLimit_Names[FPS_LIMIT_COUNT];
 #define OPT_CLASSIC_HACKS "nostalgia-hacks"
 #define OPT_CLASSIC_ARM_MODEL "nostalgia-classicarm"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_HTTP_WORKERS "http-workers"
+#define OPT_HTTP_CACHE_SIZE "http-cache-size"
+#define OPT_OLD_TEXTURECACHE_DELETED "texturecache-olddeleted"
+#define OPT_MUSIC_GAPLESS "music-gapless"
 
 extern struct EntryList Options;
 /* Returns the number of options changed via Options_SetXYZ since last save. */
@@ -23,6 +23,7 @@
 #include "TexturePack.h"
 #include "Gui.h"
 #include "Errors.h"
+#include "Audio.h"
 
 /* Classic state */
 static uint8_t classic_tabList[ENTITIES_MAX_COUNT >> 3];
@@ -179,7 +180,12 @@ void Handlers_RemoveEntity(EntityID id) {
 
 static void Handlers_UpdateLocation(EntityID playerId, struct LocationUpdate* update, bool interpolate) {
 	struct Entity* entity = Entities.List[playerId];
-	if (entity) {
+	if (!entity) return;
+
+	/* Fast path, avoids going through the entity's vtable for every movement packet */
+	if (playerId != ENTITIES_SELF_ID && entity == &NetPlayers_List[playerId].Base) {
+		NetInterpComp_SetLocation(playerId, update, interpolate);
+	} else {
 		entity->VTABLE->SetLocation(entity, update, interpolate);
 	}
 }
@@ -426,6 +432,15 @@ static void Classic_LevelInit(uint8_t* data) {
 	}
 }
 
+static void Classic_MapDataError(ReturnCode res) {
+	const static String title = String_FromConst("&eLost connection to the server");
+	String reason; char reasonBuffer[STRING_SIZE];
+
+	String_InitArray(reason, reasonBuffer);
+	String_Format1(&reason, "Error %h decompressing map data", &res);
+	Game_Disconnect(&title, &reason);
+}
+
 static void Classic_LevelDataChunk(uint8_t* data) {
 	int usedLength;
 	float progress;
@@ -445,15 +460,17 @@ static void Classic_LevelDataChunk(uint8_t* data) {
 	data += 1024;
 	value = *data; /* progress in original classic, but we ignore it */
 
+	res = 0;
 	if (!map_gzHeader.Done) {
 		res = GZipHeader_Read(&map_part, &map_gzHeader);
-		if (res && res != ERR_END_OF_STREAM) Logger_Abort2(res, "reading map data");
+		/* Rest of the header is in the next chunk */
+		if (res == ERR_END_OF_STREAM) res = 0;
 	}
 
-	if (map_gzHeader.Done) {
+	if (map_gzHeader.Done && !res) {
 		if (map_sizeIndex < 4) {
 			left = 4 - map_sizeIndex;
-			map_stream.Read(&map_stream, &map_size[map_sizeIndex], left, &read); 
+			res  = map_stream.Read(&map_stream, &map_size[map_sizeIndex], left, &read); 
 			map_sizeIndex += read;
 		}
 
@@ -465,7 +482,7 @@ static void Classic_LevelDataChunk(uint8_t* data) {
 
 #ifndef EXTENDED_BLOCKS
 			left = map_volume - map_index;
-			map_stream.Read(&map_stream, &map_blocks[map_index], left, &read);
+			res  = map_stream.Read(&map_stream, &map_blocks[map_index], left, &read);
 			map_index += read;
 #else
 			if (cpe_extBlocks && value) {
@@ -473,16 +490,17 @@ static void Classic_LevelDataChunk(uint8_t* data) {
 				if (!map2_blocks) map2_blocks = Mem_Alloc(map_volume, 1, "map blocks upper");
 
 				left = map_volume - map2_index;
-				map2_stream.Read(&map2_stream, &map2_blocks[map2_index], left, &read); 
+				res  = map2_stream.Read(&map2_stream, &map2_blocks[map2_index], left, &read); 
 				map2_index += read;
 			} else {
 				left = map_volume - map_index;
-				map_stream.Read(&map_stream, &map_blocks[map_index], left, &read); 
+				res  = map_stream.Read(&map_stream, &map_blocks[map_index], left, &read); 
 				map_index += read;
 			}
 #endif
 		}
 	}
+	if (res) { Classic_MapDataError(res); return; }
 
 	progress = !map_blocks ? 0.0f : (float)map_index / map_volume;
 	Event_RaiseFloat(&WorldEvents.Loading, progress);
@@ -525,7 +543,7 @@ static void Classic_LevelFinalise(uint8_t* data) {
 
 static void Classic_SetBlock(uint8_t* data) {
 	int x, y, z;
-	BlockID block;
+	BlockID old, block;
 
 	x = Stream_GetU16_BE(&data[0]);
 	y = Stream_GetU16_BE(&data[2]);
@@ -533,9 +551,12 @@ static void Classic_SetBlock(uint8_t* data) {
 	data += 6;
 
 	Handlers_ReadBlock(data, block);
-	if (World_IsValidPos(x, y, z)) {
-		Game_UpdateBlock(x, y, z, block);
-	}
+	if (!World_IsValidPos(x, y, z)) return;
+
+	/* Block changes the player made are already applied, so this only plays for other players' changes */
+	old = World_GetBlock(x, y, z);
+	Game_UpdateBlock(x, y, z, block);
+	if (old != block) Audio_PlayServerBlockSound(x, y, z, old, block);
 }
 
 static void Classic_AddEntity(uint8_t* data) {
@@ -709,13 +730,13 @@ static void Classic_Tick(void) {
 /*########################################################################################################################*
 *------------------------------------------------------CPE protocol-------------------------------------------------------*
 *#########################################################################################################################*/
-const char* cpe_clientExtensions[30] = {
+const char* cpe_clientExtensions[31] = {
 	"ClickDistance", "CustomBlocks", "HeldBlock", "EmoteFix", "TextHotKey", "ExtPlayerList",
 	"EnvColors", "SelectionCuboid", "BlockPermissions", "ChangeModel", "EnvMapAppearance",
 	"EnvWeatherType", "MessageTypes", "HackControl", "PlayerClick", "FullCP437", "LongerMessages",
 	"BlockDefinitions", "BlockDefinitionsExt", "BulkBlockUpdate", "TextColors", "EnvMapAspect",
 	"EntityProperty", "ExtEntityPositions", "TwoWayPing", "InventoryOrder", "InstantMOTD", "FastMap",
-	"ExtendedTextures", "ExtendedBlocks",
+	"ExtendedTextures", "ExtendedBlocks", "CompressedStream",
 };
 static void CPE_SetMapEnvUrl(uint8_t* data);
 
@@ -840,6 +861,10 @@ static void CPE_SendCpeExtInfoReply(void) {
 	}
 }
 
+static void CPE_BeginCompression(uint8_t* data) {
+	Net_BeginCompression();
+}
+
 static void CPE_ExtInfo(uint8_t* data) {
 	const static String d3Server = String_FromConst("D3 server");
 	String appName; char appNameBuffer[STRING_SIZE];
@@ -900,6 +925,10 @@ static void CPE_ExtEntry(uint8_t* data) {
 	} else if (String_CaselessEqualsConst(&ext, "FastMap")) {
 		Net_PacketSizes[OPCODE_LEVEL_BEGIN] += 4;
 		cpe_fastMap = true;
+	} else if (String_CaselessEqualsConst(&ext, "CompressedStream")) {
+		if (extVersion != 1) return;
+		/* Server only switches to compressed stream if it also supports the extension */
+		Net_Set(OPCODE_BEGIN_COMPRESSION, CPE_BeginCompression, 1);
 	}
 #ifdef EXTENDED_TEXTURES
 	else if (String_CaselessEqualsConst(&ext, "ExtendedTextures")) {
@@ -10,15 +10,16 @@
 #include "Game.h"
 #include "Event.h"
 #include "GameStructs.h"
+#include "Platform.h"
 
 
 /*########################################################################################################################*
 *------------------------------------------------------Particle base------------------------------------------------------*
 *#########################################################################################################################*/
 static GfxResourceID Particles_TexId, Particles_VB;
-#define PARTICLES_MAX 600
+/* All of a type of particle is drawn in one go, so can't be more than dynamic VB can hold */
+#define PARTICLES_MAX (GFX_MAX_VERTICES / 4)
 static RNGState rnd;
-static bool particle_hitTerrain;
 
 void Particle_DoRender(Vector2* size, Vector3* pos, TextureRec* rec, PackedCol col, VertexP3fT2fC4b* vertices) {
 	struct Matrix* view;
@@ -48,10 +49,80 @@ void Particle_DoRender(Vector2* size, Vector3* pos, TextureRec* rec, PackedCol c
 				   v.V = rec->V2; vertices[3] = v;
 }
 
-static void Particle_Reset(struct Particle* p, Vector3 pos, Vector3 velocity, float lifetime) {
-	p->LastPos = pos; p->NextPos = pos;
-	p->Velocity = velocity;
-	p->Lifetime = lifetime;
+/* Particles are stored as a structure of arrays, so that the per tick integration */
+/*  loops run over contiguous floats, which compilers can then vectorise. */
+struct ParticlePool {
+	float* LastX; float* LastY; float* LastZ;
+	float* NextX; float* NextY; float* NextZ;
+	float* VelX;  float* VelY;  float* VelZ;
+	float* Lifetime;
+	uint8_t* Size;
+	int Count;
+	int Evict; /* Index of particle replaced next, when the pool is full */
+};
+
+static void ParticlePool_Init(struct ParticlePool* p) {
+	float* data = (float*)Mem_Alloc(PARTICLES_MAX, 10 * sizeof(float) + 1, "particles");
+	p->LastX = data; p->LastY = data + PARTICLES_MAX;     p->LastZ = data + PARTICLES_MAX * 2;
+	p->NextX = data + PARTICLES_MAX * 3; p->NextY = data + PARTICLES_MAX * 4; p->NextZ = data + PARTICLES_MAX * 5;
+	p->VelX  = data + PARTICLES_MAX * 6; p->VelY  = data + PARTICLES_MAX * 7; p->VelZ  = data + PARTICLES_MAX * 8;
+	p->Lifetime = data + PARTICLES_MAX * 9;
+	p->Size     = (uint8_t*)(data + PARTICLES_MAX * 10);
+	p->Count = 0; p->Evict = 0;
+}
+
+static void ParticlePool_Free(struct ParticlePool* p) {
+	Mem_Free(p->LastX);
+	p->LastX = NULL; p->Count = 0;
+}
+
+/* Returns index of a new particle, replacing an existing particle if the pool is full. */
+static int ParticlePool_Add(struct ParticlePool* p, Vector3 pos, Vector3 velocity, float lifetime) {
+	int i;
+	if (p->Count < PARTICLES_MAX) {
+		i = p->Count++;
+	} else {
+		i = p->Evict;
+		p->Evict = (p->Evict + 1) % PARTICLES_MAX;
+	}
+
+	p->LastX[i] = pos.X; p->LastY[i] = pos.Y; p->LastZ[i] = pos.Z;
+	p->NextX[i] = pos.X; p->NextY[i] = pos.Y; p->NextZ[i] = pos.Z;
+	p->VelX[i]  = velocity.X; p->VelY[i] = velocity.Y; p->VelZ[i] = velocity.Z;
+	p->Lifetime[i] = lifetime;
+	return i;
+}
+
+/* Removes the given particle by moving the last particle into its place. */
+static void ParticlePool_RemoveAt(struct ParticlePool* p, int i) {
+	int last = --p->Count;
+	p->LastX[i] = p->LastX[last]; p->LastY[i] = p->LastY[last]; p->LastZ[i] = p->LastZ[last];
+	p->NextX[i] = p->NextX[last]; p->NextY[i] = p->NextY[last]; p->NextZ[i] = p->NextZ[last];
+	p->VelX[i]  = p->VelX[last];  p->VelY[i]  = p->VelY[last];  p->VelZ[i]  = p->VelZ[last];
+	p->Lifetime[i] = p->Lifetime[last];
+	p->Size[i]     = p->Size[last];
+}
+
+/* Moves all particles, ignoring collisions. (handled afterwards by Particle_Collide) */
+static void ParticlePool_Integrate(struct ParticlePool* p, float gravity, double delta) {
+	float* lastX = p->LastX; float* lastY = p->LastY; float* lastZ = p->LastZ;
+	float* nextX = p->NextX; float* nextY = p->NextY; float* nextZ = p->NextZ;
+	float* velX  = p->VelX;  float* velY  = p->VelY;  float* velZ  = p->VelZ;
+	float* life  = p->Lifetime;
+	float dt = (float)delta, dv = gravity * (float)delta, scale = (float)delta * 3.0f;
+	int i, count = p->Count;
+
+	/* NOTE: Loops are deliberately kept branch free, so that they can be vectorised */
+	for (i = 0; i < count; i++) {
+		lastX[i] = nextX[i]; lastY[i] = nextY[i]; lastZ[i] = nextZ[i];
+	}
+	for (i = 0; i < count; i++) {
+		velY[i]  -= dv;
+		nextX[i] += velX[i] * scale;
+		nextY[i] += velY[i] * scale;
+		nextZ[i] += velZ[i] * scale;
+		life[i]  -= dt;
+	}
 }
 
 static bool Particle_CanPass(BlockID block, bool throughLiquids) {
@@ -59,12 +130,10 @@ static bool Particle_CanPass(BlockID block, bool throughLiquids) {
 	return draw == DRAW_GAS || draw == DRAW_SPRITE || (throughLiquids && Blocks.IsLiquid[block]);
 }
 
-static bool Particle_CollideHor(Vector3* nextPos, BlockID block) {
-	Vector3 horPos = Vector3_Create3((float)Math_Floor(nextPos->X), 0.0f, (float)Math_Floor(nextPos->Z));
-	Vector3 min, max;
-	Vector3_Add(&min, &Blocks.MinBB[block], &horPos);
-	Vector3_Add(&max, &Blocks.MaxBB[block], &horPos);
-	return nextPos->X >= min.X && nextPos->Z >= min.Z && nextPos->X < max.X && nextPos->Z < max.Z;
+static bool Particle_CollideHor(float x, float z, BlockID block) {
+	float minX = Math_Floor(x) + Blocks.MinBB[block].X, maxX = Math_Floor(x) + Blocks.MaxBB[block].X;
+	float minZ = Math_Floor(z) + Blocks.MinBB[block].Z, maxZ = Math_Floor(z) + Blocks.MaxBB[block].Z;
+	return x >= minX && z >= minZ && x < maxX && z < maxZ;
 }
 
 static BlockID Particle_GetBlock(int x, int y, int z) {
@@ -75,132 +144,154 @@ static BlockID Particle_GetBlock(int x, int y, int z) {
 	return Env_SidesBlock;
 }
 
-static bool Particle_TestY(struct Particle* p, int y, bool topFace, bool throughLiquids) {
+#define Particle_BrickBit(x, y, z) (1ull << ((((y) >> 2) & 3) << 4 | (((z) >> 2) & 3) << 2 | (((x) >> 2) & 3)))
+/* Whether any block the particle was in or moved through might stop it. */
+/* Uses the world's brick occupancy, so particles in empty space never look up blocks. */
+static bool Particle_MayCollide(struct ParticlePool* p, int i, int begY, int endY) {
+	int lastX = (int)p->LastX[i], lastZ = (int)p->LastZ[i];
+	int x = (int)p->NextX[i], z = (int)p->NextZ[i];
+	int minY = min(begY, endY), maxY = max(begY, endY);
+
+	if (!World_Blocks || minY < 0 || maxY >= World_Height || maxY - minY >= 4) return true;
+	if (lastX < 0 || lastZ < 0 || lastX >= World_Width || lastZ >= World_Length) return true;
+	if (x     < 0 || z     < 0 || x     >= World_Width || z     >= World_Length) return true;
+
+	/* Moved at most 3 blocks vertically, so at most 2 bricks along the Y axis are passed through */
+	return (World_GetOccupied(lastX, begY, lastZ) & Particle_BrickBit(lastX, begY, lastZ))
+		|| (World_GetOccupied(x, minY, z) & Particle_BrickBit(x, minY, z))
+		|| (World_GetOccupied(x, maxY, z) & Particle_BrickBit(x, maxY, z));
+}
+
+static bool particle_hitTerrain;
+static bool Particle_TestY(struct ParticlePool* p, int i, int y, bool topFace, bool throughLiquids) {
 	BlockID block;
-	Vector3 minBB, maxBB;
 	float collideY;
 	bool collideVer;
 
 	if (y < 0) {
-		p->NextPos.Y = ENTITY_ADJUSTMENT; p->LastPos.Y = ENTITY_ADJUSTMENT;
-		p->Velocity  = Vector3_Zero();
+		p->NextY[i] = ENTITY_ADJUSTMENT; p->LastY[i] = ENTITY_ADJUSTMENT;
+		p->VelX[i]  = 0.0f; p->VelY[i] = 0.0f; p->VelZ[i] = 0.0f;
 		particle_hitTerrain = true;
 		return false;
 	}
 
-	block = Particle_GetBlock((int)p->NextPos.X, y, (int)p->NextPos.Z);
+	block = Particle_GetBlock((int)p->NextX[i], y, (int)p->NextZ[i]);
 	if (Particle_CanPass(block, throughLiquids)) return true;
-	minBB = Blocks.MinBB[block]; maxBB = Blocks.MaxBB[block];
 
-	collideY   = y + (topFace ? maxBB.Y : minBB.Y);
-	collideVer = topFace ? (p->NextPos.Y < collideY) : (p->NextPos.Y > collideY);
+	collideY   = y + (topFace ? Blocks.MaxBB[block].Y : Blocks.MinBB[block].Y);
+	collideVer = topFace ? (p->NextY[i] < collideY) : (p->NextY[i] > collideY);
 
-	if (collideVer && Particle_CollideHor(&p->NextPos, block)) {
+	if (collideVer && Particle_CollideHor(p->NextX[i], p->NextZ[i], block)) {
 		float adjust = topFace ? ENTITY_ADJUSTMENT : -ENTITY_ADJUSTMENT;
-		p->LastPos.Y = collideY + adjust;
-		p->NextPos.Y = p->LastPos.Y;
-		p->Velocity  = Vector3_Zero();
+		p->LastY[i] = collideY + adjust;
+		p->NextY[i] = p->LastY[i];
+		p->VelX[i]  = 0.0f; p->VelY[i] = 0.0f; p->VelZ[i] = 0.0f;
 		particle_hitTerrain = true;
 		return false;
 	}
 	return true;
 }
 
-static bool Particle_PhysicsTick(struct Particle* p, float gravity, bool throughLiquids, double delta) {
+/* Resolves collisions of a particle that was just moved by ParticlePool_Integrate. */
+/* Returns whether the particle should be removed, as it was stuck inside a block. */
+static bool Particle_Collide(struct ParticlePool* p, int i, bool throughLiquids) {
 	BlockID cur;
-	float minY, maxY;
-	Vector3 velocity;
+	float lastY, minY, maxY;
 	int y, begY, endY;
 
-	p->LastPos = p->NextPos;
-	cur  = Particle_GetBlock((int)p->NextPos.X, (int)p->NextPos.Y, (int)p->NextPos.Z);
-	minY = Math_Floor(p->NextPos.Y) + Blocks.MinBB[cur].Y;
-	maxY = Math_Floor(p->NextPos.Y) + Blocks.MaxBB[cur].Y;
+	lastY = p->LastY[i];
+	begY  = Math_Floor(lastY);
+	endY  = Math_Floor(p->NextY[i]);
+	if (!Particle_MayCollide(p, i, begY, endY)) return false;
+
+	cur  = Particle_GetBlock((int)p->LastX[i], (int)lastY, (int)p->LastZ[i]);
+	minY = begY + Blocks.MinBB[cur].Y;
+	maxY = begY + Blocks.MaxBB[cur].Y;
 
-	if (!Particle_CanPass(cur, throughLiquids) && p->NextPos.Y >= minY
-		&& p->NextPos.Y < maxY && Particle_CollideHor(&p->NextPos, cur)) {
+	if (!Particle_CanPass(cur, throughLiquids) && lastY >= minY
+		&& lastY < maxY && Particle_CollideHor(p->LastX[i], p->LastZ[i], cur)) {
 		return true;
 	}
 
-	p->Velocity.Y -= gravity * (float)delta;
-	begY = Math_Floor(p->NextPos.Y);
-	
-	Vector3_Mul1(&velocity, &p->Velocity, (float)delta * 3.0f);
-	Vector3_Add(&p->NextPos, &p->NextPos, &velocity);
-	endY = Math_Floor(p->NextPos.Y);
-
-	if (p->Velocity.Y > 0.0f) {
+	if (p->VelY[i] > 0.0f) {
 		/* don't test block we are already in */
-		for (y = begY + 1; y <= endY && Particle_TestY(p, y, false, throughLiquids); y++) {}
+		for (y = begY + 1; y <= endY && Particle_TestY(p, i, y, false, throughLiquids); y++) {}
 	} else {
-		for (y = begY; y >= endY && Particle_TestY(p, y, true, throughLiquids); y--) {}
+		for (y = begY; y >= endY && Particle_TestY(p, i, y, true, throughLiquids); y--) {}
 	}
+	return false;
+}
+
+/* Right and up vectors of the camera, scaled by half, for the current frame */
+static Vector3 particles_right, particles_up;
+static VertexP3fT2fC4b* particles_vertices;
+static uint32_t particles_verticesMax;
 
-	p->Lifetime -= (float)delta;
-	return p->Lifetime < 0.0f;
+static void Particles_BeginVertices(int count) {
+	struct Matrix* view = &Gfx_View;
+	particles_right.X = view->Row0.X * 0.5f; particles_right.Y = view->Row1.X * 0.5f; particles_right.Z = view->Row2.X * 0.5f;
+	particles_up.X    = view->Row0.Y * 0.5f; particles_up.Y    = view->Row1.Y * 0.5f; particles_up.Z    = view->Row2.Y * 0.5f;
+
+	if ((uint32_t)count <= particles_verticesMax) return;
+	Mem_Free(particles_vertices);
+	particles_vertices    = Mem_Alloc(count, sizeof(VertexP3fT2fC4b), "particle vertices");
+	particles_verticesMax = count;
+}
+
+/* Same as Particle_DoRender, but with square size and camera vectors calculated once per frame */
+static void Particle_MakeQuad(float x, float y, float z, float size, TextureRec* rec, PackedCol col, VertexP3fT2fC4b* v) {
+	float aX = particles_right.X * size, aY = particles_right.Y * size, aZ = particles_right.Z * size;
+	float bX = particles_up.X    * size, bY = particles_up.Y    * size, bZ = particles_up.Z    * size;
+	y += size * 0.5f;
+
+	v[0].X = x - aX - bX; v[0].Y = y - aY - bY; v[0].Z = z - aZ - bZ; v[0].U = rec->U1; v[0].V = rec->V2; v[0].Col = col;
+	v[1].X = x - aX + bX; v[1].Y = y - aY + bY; v[1].Z = z - aZ + bZ; v[1].U = rec->U1; v[1].V = rec->V1; v[1].Col = col;
+	v[2].X = x + aX + bX; v[2].Y = y + aY + bY; v[2].Z = z + aZ + bZ; v[2].U = rec->U2; v[2].V = rec->V1; v[2].Col = col;
+	v[3].X = x + aX - bX; v[3].Y = y + aY - bY; v[3].Z = z + aZ - bZ; v[3].U = rec->U2; v[3].V = rec->V2; v[3].Col = col;
 }
 
 
 /*########################################################################################################################*
 *-------------------------------------------------------Rain particle-----------------------------------------------------*
 *#########################################################################################################################*/
-struct RainParticle { struct Particle Base; };
-
-static struct RainParticle rain_Particles[PARTICLES_MAX];
-static int rain_count;
+static struct ParticlePool rain_pool;
 static TextureRec rain_rec = { 2.0f/128.0f, 14.0f/128.0f, 5.0f/128.0f, 16.0f/128.0f };
 
-static bool RainParticle_Tick(struct RainParticle* p, double delta) {
-	particle_hitTerrain = false;
-	return Particle_PhysicsTick(&p->Base, 3.5f, false, delta) || particle_hitTerrain;
-}
-
-static void RainParticle_Render(struct RainParticle* p, float t, VertexP3fT2fC4b* vertices) {
-	Vector3 pos;
-	Vector2 size;
+static void Rain_Render(float t) {
+	struct ParticlePool* p = &rain_pool;
+	VertexP3fT2fC4b* v;
 	PackedCol col;
-	int x, y, z;
+	float x, y, z;
+	int i, cellX, cellY, cellZ;
+	if (!p->Count) return;
 
-	Vector3_Lerp(&pos, &p->Base.LastPos, &p->Base.NextPos, t);
-	size.X = (float)p->Base.Size * 0.015625f; size.Y = size.X;
+	Particles_BeginVertices(p->Count * 4);
+	v = particles_vertices;
 
-	x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
-	col = World_IsValidPos(x, y, z) ? Lighting_Col(x, y, z) : Env_SunCol;
-	Particle_DoRender(&size, &pos, &rain_rec, col, vertices);
-}
+	for (i = 0; i < p->Count; i++, v += 4) {
+		x = p->LastX[i] + (p->NextX[i] - p->LastX[i]) * t;
+		y = p->LastY[i] + (p->NextY[i] - p->LastY[i]) * t;
+		z = p->LastZ[i] + (p->NextZ[i] - p->LastZ[i]) * t;
 
-static void Rain_Render(float t) {
-	VertexP3fT2fC4b vertices[PARTICLES_MAX * 4];
-	VertexP3fT2fC4b* ptr;
-	int i;
-	if (!rain_count) return;
-	
-	ptr = vertices;
-	for (i = 0; i < rain_count; i++) {
-		RainParticle_Render(&rain_Particles[i], t, ptr);
-		ptr += 4;
+		cellX = Math_Floor(x); cellY = Math_Floor(y); cellZ = Math_Floor(z);
+		col   = World_IsValidPos(cellX, cellY, cellZ) ? Lighting_Col(cellX, cellY, cellZ) : Env_SunCol;
+		Particle_MakeQuad(x, y, z, p->Size[i] * 0.015625f, &rain_rec, col, v);
 	}
 
 	Gfx_BindTexture(Particles_TexId);
-	Gfx_UpdateDynamicVb_IndexedTris(Particles_VB, vertices, rain_count * 4);
-}
-
-static void Rain_RemoveAt(int index) {
-	struct RainParticle removed = rain_Particles[index];
-	int i;
-
-	for (i = index; i < rain_count - 1; i++) {
-		rain_Particles[i] = rain_Particles[i + 1];
-	}
-	rain_Particles[rain_count - 1] = removed;
-	rain_count--;
+	Gfx_UpdateDynamicVb_IndexedTris(Particles_VB, particles_vertices, p->Count * 4);
 }
 
 static void Rain_Tick(double delta) {
+	struct ParticlePool* p = &rain_pool;
 	int i;
-	for (i = 0; i < rain_count; i++) {
-		if (RainParticle_Tick(&rain_Particles[i], delta)) {
-			Rain_RemoveAt(i); i--;
+	ParticlePool_Integrate(p, 3.5f, delta);
+
+	/* Iterate backwards, as removing moves the last particle into the removed one's place */
+	for (i = p->Count - 1; i >= 0; i--) {
+		particle_hitTerrain = false;
+		if (Particle_Collide(p, i, false) || particle_hitTerrain || p->Lifetime[i] < 0.0f) {
+			ParticlePool_RemoveAt(p, i);
 		}
 	}
 }
@@ -209,43 +300,30 @@ static void Rain_Tick(double delta) {
 /*########################################################################################################################*
 *------------------------------------------------------Terrain particle---------------------------------------------------*
 *#########################################################################################################################*/
-struct TerrainParticle {
-	struct Particle Base;
-	TextureRec Rec;
-	TextureLoc TexLoc;
-	BlockID Block;
-};
-
-static struct TerrainParticle terrain_particles[PARTICLES_MAX];
-static int terrain_count;
-static uint16_t terrain_1DCount[ATLAS1D_MAX_ATLASES];
-static uint16_t terrain_1DIndices[ATLAS1D_MAX_ATLASES];
-
-static bool TerrainParticle_Tick(struct TerrainParticle* p, double delta) {
-	return Particle_PhysicsTick(&p->Base, 5.4f, true, delta);
-}
-
-static void TerrainParticle_Render(struct TerrainParticle* p, float t, VertexP3fT2fC4b* vertices) {
+static struct ParticlePool terrain_pool;
+static TextureRec* terrain_recs;
+static TextureLoc* terrain_texLocs;
+static BlockID* terrain_blocks;
+static int terrain_1DCount[ATLAS1D_MAX_ATLASES];
+static int terrain_1DIndices[ATLAS1D_MAX_ATLASES];
+
+static PackedCol Terrain_GetCol(BlockID block, float x, float y, float z) {
 	PackedCol col = PACKEDCOL_WHITE;
-	Vector3 pos;
-	Vector2 size;
-	int x, y, z;
+	PackedCol tintCol;
+	int cellX, cellY, cellZ;
 
-	Vector3_Lerp(&pos, &p->Base.LastPos, &p->Base.NextPos, t);
-	size.X = (float)p->Base.Size * 0.015625f; size.Y = size.X;
-	
-	if (!Blocks.FullBright[p->Block]) {
-		x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
-		col = World_IsValidPos(x, y, z) ? Lighting_Col_XSide(x, y, z) : Env_SunXSide;
+	if (!Blocks.FullBright[block]) {
+		cellX = Math_Floor(x); cellY = Math_Floor(y); cellZ = Math_Floor(z);
+		col   = World_IsValidPos(cellX, cellY, cellZ) ? Lighting_Col_XSide(cellX, cellY, cellZ) : Env_SunXSide;
 	}
 
-	if (Blocks.Tinted[p->Block]) {
-		PackedCol tintCol = Blocks.FogCol[p->Block];
+	if (Blocks.Tinted[block]) {
+		tintCol = Blocks.FogCol[block];
 		col.R = (uint8_t)(col.R * tintCol.R / 255);
 		col.G = (uint8_t)(col.G * tintCol.G / 255);
 		col.B = (uint8_t)(col.B * tintCol.B / 255);
 	}
-	Particle_DoRender(&size, &pos, &p->Rec, col, vertices);
+	return col;
 }
 
 static void Terrain_Update1DCounts(void) {
@@ -255,8 +333,8 @@ static void Terrain_Update1DCounts(void) {
 		terrain_1DCount[i]   = 0;
 		terrain_1DIndices[i] = 0;
 	}
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].TexLoc);
+	for (i = 0; i < terrain_pool.Count; i++) {
+		index = Atlas1D_Index(terrain_texLocs[i]);
 		terrain_1DCount[index] += 4;
 	}
 	for (i = 1; i < Atlas1D_Count; i++) {
@@ -265,22 +343,29 @@ static void Terrain_Update1DCounts(void) {
 }
 
 static void Terrain_Render(float t) {
-	VertexP3fT2fC4b vertices[PARTICLES_MAX * 4];
-	VertexP3fT2fC4b* ptr;
+	struct ParticlePool* p = &terrain_pool;
+	PackedCol col;
+	float x, y, z;
 	int offset = 0;
 	int i, index;
-	if (!terrain_count) return;
+	if (!p->Count) return;
 
+	Particles_BeginVertices(p->Count * 4);
 	Terrain_Update1DCounts();
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].TexLoc);
-		ptr   = &vertices[terrain_1DIndices[index]];
 
-		TerrainParticle_Render(&terrain_particles[i], t, ptr);
+	for (i = 0; i < p->Count; i++) {
+		x = p->LastX[i] + (p->NextX[i] - p->LastX[i]) * t;
+		y = p->LastY[i] + (p->NextY[i] - p->LastY[i]) * t;
+		z = p->LastZ[i] + (p->NextZ[i] - p->LastZ[i]) * t;
+
+		index = Atlas1D_Index(terrain_texLocs[i]);
+		col   = Terrain_GetCol(terrain_blocks[i], x, y, z);
+		Particle_MakeQuad(x, y, z, p->Size[i] * 0.015625f, &terrain_recs[i], col,
+						&particles_vertices[terrain_1DIndices[index]]);
 		terrain_1DIndices[index] += 4;
 	}
 
-	Gfx_SetDynamicVbData(Particles_VB, vertices, terrain_count * 4);
+	Gfx_SetDynamicVbData(Particles_VB, particles_vertices, p->Count * 4);
 	for (i = 0; i < Atlas1D_Count; i++) {
 		int partCount = terrain_1DCount[i];
 		if (!partCount) continue;
@@ -291,22 +376,23 @@ static void Terrain_Render(float t) {
 	}
 }
 
-static void Terrain_RemoveAt(int index) {
-	struct TerrainParticle removed = terrain_particles[index];
-	int i;
-
-	for (i = index; i < terrain_count - 1; i++) {
-		terrain_particles[i] = terrain_particles[i + 1];
-	}
-	terrain_particles[terrain_count - 1] = removed;
-	terrain_count--;
+static void Terrain_RemoveAt(int i) {
+	int last = terrain_pool.Count - 1;
+	terrain_recs[i]    = terrain_recs[last];
+	terrain_texLocs[i] = terrain_texLocs[last];
+	terrain_blocks[i]  = terrain_blocks[last];
+	ParticlePool_RemoveAt(&terrain_pool, i);
 }
 
 static void Terrain_Tick(double delta) {
+	struct ParticlePool* p = &terrain_pool;
 	int i;
-	for (i = 0; i < terrain_count; i++) {
-		if (TerrainParticle_Tick(&terrain_particles[i], delta)) {
-			Terrain_RemoveAt(i); i--;
+	ParticlePool_Integrate(p, 5.4f, delta);
+
+	/* Iterate backwards, as removing moves the last particle into the removed one's place */
+	for (i = p->Count - 1; i >= 0; i--) {
+		if (Particle_Collide(p, i, true) || p->Lifetime[i] < 0.0f) {
+			Terrain_RemoveAt(i);
 		}
 	}
 }
@@ -322,7 +408,7 @@ static void Particles_FileChanged(void* obj, struct Stream* stream, const String
 }
 
 void Particles_Render(double delta, float t) {
-	if (!terrain_count && !rain_count) return;
+	if (!terrain_pool.Count && !rain_pool.Count) return;
 	if (Gfx_LostContext) return;
 
 	Gfx_SetTexturing(true);
@@ -341,10 +427,11 @@ void Particles_Tick(struct ScheduledTask* task) {
 	Rain_Tick(task->Interval);
 }
 
+int Particles_Count(void) { return terrain_pool.Count + rain_pool.Count; }
+
 void Particles_BreakBlockEffect(Vector3I coords, BlockID old, BlockID now) {
-	struct TerrainParticle* p;
 	TextureLoc loc;
-	int texIndex;
+	int i, texIndex;
 	TextureRec baseRec, rec;
 	Vector3 origin, minBB, maxBB;
 
@@ -409,28 +496,24 @@ void Particles_BreakBlockEffect(Vector3I coords, BlockID old, BlockID now) {
 				rec.U2 = min(rec.U2, maxU2) - 0.01f * uScale;
 				rec.V2 = min(rec.V2, maxV2) - 0.01f * vScale;
 
-				if (terrain_count == PARTICLES_MAX) Terrain_RemoveAt(0);
-				p = &terrain_particles[terrain_count++];
-
 				life = 0.3f + Random_Float(&rnd) * 1.2f;
 				Vector3_Add(&pos, &origin, &cell);
-				Particle_Reset(&p->Base, pos, velocity, life);
+				i = ParticlePool_Add(&terrain_pool, pos, velocity, life);
 
-				p->Rec    = rec;
-				p->TexLoc = loc;
-				p->Block  = old;
+				terrain_recs[i]    = rec;
+				terrain_texLocs[i] = loc;
+				terrain_blocks[i]  = old;
 				type = Random_Range(&rnd, 0, 30);
-				p->Base.Size = (uint8_t)(type >= 28 ? 12 : (type >= 25 ? 10 : 8));
+				terrain_pool.Size[i] = (uint8_t)(type >= 28 ? 12 : (type >= 25 ? 10 : 8));
 			}
 		}
 	}
 }
 
 void Particles_RainSnowEffect(Vector3 pos) {
-	struct RainParticle* p;
 	Vector3 origin = pos;
 	Vector3 offset, velocity;
-	int i, type;
+	int i, j, type;
 
 	for (i = 0; i < 2; i++) {
 		velocity.X = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
@@ -441,14 +524,11 @@ void Particles_RainSnowEffect(Vector3 pos) {
 		offset.Y = Random_Float(&rnd) * 0.1f + 0.01f;
 		offset.Z = Random_Float(&rnd);
 
-		if (rain_count == PARTICLES_MAX) Rain_RemoveAt(0);
-		p = &rain_Particles[rain_count++];
-
 		Vector3_Add(&pos, &origin, &offset);
-		Particle_Reset(&p->Base, pos, velocity, 40.0f);
+		j = ParticlePool_Add(&rain_pool, pos, velocity, 40.0f);
 
 		type = Random_Range(&rnd, 0, 30);
-		p->Base.Size = (uint8_t)(type >= 28 ? 2 : (type >= 25 ? 4 : 3));
+		rain_pool.Size[j] = (uint8_t)(type >= 28 ? 2 : (type >= 25 ? 4 : 3));
 	}
 }
 
@@ -469,6 +549,12 @@ static void Particles_BreakBlockEffect_Handler(void* obj, Vector3I coords, Block
 static void Particles_Init(void) {
 	ScheduledTask_Add(GAME_DEF_TICKS, Particles_Tick);
 	Random_InitFromCurrentTime(&rnd);
+
+	ParticlePool_Init(&rain_pool);
+	ParticlePool_Init(&terrain_pool);
+	terrain_recs    = Mem_Alloc(PARTICLES_MAX, sizeof(TextureRec), "particle recs");
+	terrain_texLocs = Mem_Alloc(PARTICLES_MAX, sizeof(TextureLoc), "particle texlocs");
+	terrain_blocks  = Mem_Alloc(PARTICLES_MAX, sizeof(BlockID),    "particle blocks");
 	Particles_ContextRecreated(NULL);	
 
 	Event_RegisterBlock(&UserEvents.BlockChanged,   NULL, Particles_BreakBlockEffect_Handler);
@@ -481,13 +567,21 @@ static void Particles_Free(void) {
 	Gfx_DeleteTexture(&Particles_TexId);
 	Particles_ContextLost(NULL);
 
+	ParticlePool_Free(&rain_pool);
+	ParticlePool_Free(&terrain_pool);
+	Mem_Free(terrain_recs);
+	Mem_Free(terrain_texLocs);
+	Mem_Free(terrain_blocks);
+	Mem_Free(particles_vertices);
+	particles_vertices = NULL; particles_verticesMax = 0;
+
 	Event_UnregisterBlock(&UserEvents.BlockChanged,   NULL, Particles_BreakBlockEffect_Handler);
 	Event_UnregisterEntry(&TextureEvents.FileChanged, NULL, Particles_FileChanged);
 	Event_UnregisterVoid(&GfxEvents.ContextLost,      NULL, Particles_ContextLost);
 	Event_UnregisterVoid(&GfxEvents.ContextRecreated, NULL, Particles_ContextRecreated);
 }
 
-static void Particles_Reset(void) { rain_count = 0; terrain_count = 0; }
+static void Particles_Reset(void) { rain_pool.Count = 0; terrain_pool.Count = 0; }
 
 struct IGameComponent Particles_Component = {
 	Particles_Init,  /* Init  */
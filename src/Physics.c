@@ -123,6 +123,70 @@ bool Intersection_RayIntersectsBox(Vector3 origin, Vector3 dir, Vector3 min, Vec
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Collision cache-----------------------------------------------------*
+*#########################################################################################################################*/
+#define COLLISION_CACHE_MAX 4096
+static BlockID collisionCache_blocks[COLLISION_CACHE_MAX];
+struct _CollisionCacheData CollisionCache = { false, { 0, 0, 0 }, { 0, 0, 0 }, 0, 0, 0, collisionCache_blocks };
+
+void CollisionCache_Build(const struct AABB* bounds) {
+	Vector3I min, max;
+	BlockID* blocks = collisionCache_blocks;
+	BlockID block, lastBlock;
+	uint8_t flags = 0;
+	int x, y, z, volume;
+
+	Vector3I_Floor(&min, &bounds->Min);
+	Vector3I_Floor(&max, &bounds->Max);
+	volume = (max.X - min.X + 1) * (max.Y - min.Y + 1) * (max.Z - min.Z + 1);
+
+	CollisionCache.Valid = false;
+	if (volume <= 0 || volume > COLLISION_CACHE_MAX) return;
+	lastBlock = BLOCK_AIR;
+
+	/* Order loops so that we minimise cache misses */
+	for (y = min.Y; y <= max.Y; y++) {
+		for (z = min.Z; z <= max.Z; z++) {
+			for (x = min.X; x <= max.X; x++) {
+				block = World_GetPhysicsBlock(x, y, z);
+				*blocks++ = block;
+
+				/* Most neighbouring blocks are the same, so avoid looking up flags again */
+				if (block == lastBlock) continue;
+				flags |= Blocks.Physics[block].Flags;
+				lastBlock = block;
+			}
+		}
+	}
+
+	CollisionCache.Valid  = true;
+	CollisionCache.Min    = min;
+	CollisionCache.Max    = max;
+	CollisionCache.Width  = max.X - min.X + 1;
+	CollisionCache.Length = max.Z - min.Z + 1;
+	CollisionCache.Flags  = flags;
+}
+
+void CollisionCache_Clear(void) { CollisionCache.Valid = false; }
+
+bool CollisionCache_Covers(const Vector3I* min, const Vector3I* max) {
+	return CollisionCache.Valid
+		&& min->X >= CollisionCache.Min.X && max->X <= CollisionCache.Max.X
+		&& min->Y >= CollisionCache.Min.Y && max->Y <= CollisionCache.Max.Y
+		&& min->Z >= CollisionCache.Min.Z && max->Z <= CollisionCache.Max.Z;
+}
+
+bool CollisionCache_Lacks(const struct AABB* bounds, uint8_t flags) {
+	Vector3I min, max;
+	if (!CollisionCache.Valid || (CollisionCache.Flags & flags)) return false;
+
+	Vector3I_Floor(&min, &bounds->Min);
+	Vector3I_Floor(&max, &bounds->Max);
+	return CollisionCache_Covers(&min, &max);
+}
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Collisions finder----------------------------------------------------*
 *#########################################################################################################################*/
@@ -154,12 +218,14 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 	Vector3I min, max;
 	uint32_t elements;
 	struct SearcherState* curState;
+	bool useCache;
 	int count;
 
 	BlockID block;
+	struct BlockPhysicsDesc* desc;
 	struct AABB blockBB;
 	float xx, yy, zz, tx, ty, tz;
-	int x, y, z;
+	int x, y, z, rowMaxX;
 
 	Entity_GetBounds(entity, entityBB);
 	/* Exact maximum extent the entity can reach, and the equivalent map coordinates. */
@@ -175,6 +241,9 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 	Vector3I_Floor(&max, &entityExtentBB->Max);
 	elements = (max.X - min.X + 1) * (max.Y - min.Y + 1) * (max.Z - min.Z + 1);
 
+	useCache = CollisionCache_Covers(&min, &max);
+	if (useCache && !(CollisionCache.Flags & COLLISION_FLAG_SOLID)) return 0;
+
 	if (elements > Searcher_StatesMax) {
 		Searcher_Free();
 		Searcher_StatesMax = elements;
@@ -185,14 +254,23 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 	/* Order loops so that we minimise cache misses */
 	for (y = min.Y; y <= max.Y; y++) {
 		for (z = min.Z; z <= max.Z; z++) {
+			/* Part of the row inside the world, where non solid blocks can be skipped over */
+			rowMaxX = (y >= 0 && y < World_Height && z >= 0 && z < World_Length) ? min(max.X, World_MaxX) : -1;
+
 			for (x = min.X; x <= max.X; x++) {
-				block = World_GetPhysicsBlock(x, y, z);
-				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
+				if (x >= 0 && x <= rowMaxX) {
+					x = World_NextSolidX(x, rowMaxX, y, z);
+					if (x > rowMaxX) { x = rowMaxX; continue; }
+				}
+
+				block = useCache ? CollisionCache_Get(x, y, z) : World_GetPhysicsBlock(x, y, z);
+				desc  = &Blocks.Physics[block];
+				if (desc->Collide != COLLIDE_SOLID) continue;
 
 				xx = (float)x; yy = (float)y; zz = (float)z;
-				blockBB.Min = Blocks.MinBB[block];
+				blockBB.Min = desc->MinBB;
 				blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
-				blockBB.Max = Blocks.MaxBB[block];
+				blockBB.Max = desc->MaxBB;
 				blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
 
 				if (!AABB_Intersects(entityExtentBB, &blockBB)) continue; /* necessary for non whole blocks. (slabs) */
@@ -4,6 +4,7 @@
 /* Contains:
    - An axis aligned bounding box, and various methods related to them.
    - Various methods for intersecting geometry.
+   - Caches the blocks around an entity, for collision queries during its physics tick.
    - Calculates all possible blocks that a moving entity can intersect with.
    Copyright 2014-2017 ClassicalSharp | Licensed under BSD-3
 */
@@ -31,6 +32,31 @@ bool Intersection_RayIntersectsRotatedBox(Vector3 origin, Vector3 dir, struct En
 Source: http://www.cs.utah.edu/~awilliam/box/box.pdf */
 bool Intersection_RayIntersectsBox(Vector3 origin, Vector3 dir, Vector3 min, Vector3 max, float* t0, float* t1);
 
+/* Blocks around an entity, read from the world once at the start of the entity's physics tick. */
+/* Collision queries during that tick then read blocks from the cache instead of from the world, */
+/* and can skip checking for block types that aren't anywhere in the cache at all. */
+CC_VAR extern struct _CollisionCacheData {
+	bool Valid;         /* Whether the cache currently holds any blocks */
+	Vector3I Min, Max;  /* Coordinates of the cached blocks (inclusive) */
+	int Width, Length;  /* Dimensions of the cached blocks on the X and Z axes */
+	uint8_t Flags;      /* Combination of COLLISION_FLAG_ values of all the cached blocks */
+	BlockID* Blocks;    /* Cached blocks (as per World_GetPhysicsBlock) */
+} CollisionCache;
+
+/* Reads the blocks that the given bounds touch from the world into the collision cache. */
+/* NOTE: If the bounds cover too large an area, the collision cache is instead just cleared. */
+void CollisionCache_Build(const struct AABB* bounds);
+/* Clears the collision cache, so that queries read blocks from the world again. */
+void CollisionCache_Clear(void);
+/* Whether all the blocks between the given coordinates (inclusive) are in the collision cache. */
+bool CollisionCache_Covers(const Vector3I* min, const Vector3I* max);
+/* Whether the given bounds are in the collision cache, and none of the cached blocks have any of the given flags. */
+/* When this returns true, no block the bounds touch can possibly have any of the given flags either. */
+bool CollisionCache_Lacks(const struct AABB* bounds, uint8_t flags);
+/* Returns the cached block at the given coordinates. NOTE: Only valid for coordinates covered by the cache. */
+#define CollisionCache_Get(x, y, z) CollisionCache.Blocks[(((y) - CollisionCache.Min.Y) * CollisionCache.Length\
+	+ ((z) - CollisionCache.Min.Z)) * CollisionCache.Width + ((x) - CollisionCache.Min.X)]
+
 struct SearcherState { int X, Y, Z; float tSquared; };
 extern struct SearcherState* Searcher_States;
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB);
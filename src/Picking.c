@@ -111,9 +111,23 @@ void RayTracer_Step(struct RayTracer* t) {
 	}
 }
 
+/* Steps the ray tracer until it leaves the aligned box of (mask + 1) cells that it is currently in. */
+/* A ray crosses at most 3 * (mask + 1) cells in the box, so gives up after that many steps. */
+static void RayTracer_StepOut(struct RayTracer* t, int mask) {
+	int x = t->X & ~mask, y = t->Y & ~mask, z = t->Z & ~mask;
+	int i;
+
+	for (i = 0; i < 3 * (mask + 1); i++) {
+		RayTracer_Step(t);
+		if ((t->X & ~mask) != x || (t->Y & ~mask) != y || (t->Z & ~mask) != z) return;
+	}
+}
+
 static struct RayTracer tracer;
 #define PICKING_BORDER BLOCK_BEDROCK
 typedef bool (*IntersectTest)(struct PickedPos* pos);
+/* Region of the world in which blocks are guaranteed to just be World_GetBlock */
+static Vector3I picking_skipMin, picking_skipMax;
 
 static BlockID Picking_GetInside(int x, int y, int z) {
 	bool sides;
@@ -151,6 +165,38 @@ static BlockID Picking_GetOutside(int x, int y, int z, Vector3I origin) {
 	return BLOCK_AIR;
 }
 
+/* Calculates region of the world in which empty sections/bricks can be skipped over. */
+/* When the ray starts outside the map, the outermost blocks may be treated as border. */
+static void Picking_CalcSkipRegion(bool insideMap) {
+	int border = insideMap ? 0 : 1;
+	picking_skipMin.X = border; picking_skipMax.X = World_MaxX - border;
+	picking_skipMin.Y = border; picking_skipMax.Y = World_MaxY;
+	picking_skipMin.Z = border; picking_skipMax.Z = World_MaxZ - border;
+}
+
+/* Returns whether the 4x4x4 or 16x16x16 box the ray is currently in has no non gas blocks, */
+/*  in which case the ray tracer is stepped out of that box without checking each block in it. */
+static bool Picking_SkipEmpty(void) {
+	int x = tracer.X, y = tracer.Y, z = tracer.Z;
+	uint64_t occupied;
+	if (!World_Blocks) return false;
+
+	/* Brick must be entirely within the region */
+	if ((x & ~3) < picking_skipMin.X || (x | 3) > picking_skipMax.X) return false;
+	if ((y & ~3) < picking_skipMin.Y || (y | 3) > picking_skipMax.Y) return false;
+	if ((z & ~3) < picking_skipMin.Z || (z | 3) > picking_skipMax.Z) return false;
+	occupied = World_GetOccupied(x, y, z);
+
+	if (!occupied && (x & ~15) >= picking_skipMin.X && (x | 15) <= picking_skipMax.X
+		&& (y & ~15) >= picking_skipMin.Y && (y | 15) <= picking_skipMax.Y
+		&& (z & ~15) >= picking_skipMin.Z && (z | 15) <= picking_skipMax.Z) {
+		RayTracer_StepOut(&tracer, 15); return true;
+	}
+
+	if (occupied & (1ull << ((y >> 2 & 3) << 4 | (z >> 2 & 3) << 2 | (x >> 2 & 3)))) return false;
+	RayTracer_StepOut(&tracer, 3); return true;
+}
+
 static bool Picking_RayTrace(Vector3 origin, Vector3 dir, float reach, struct PickedPos* pos, IntersectTest intersect) {
 	Vector3I pOrigin;
 	bool insideMap;
@@ -162,13 +208,18 @@ static bool Picking_RayTrace(Vector3 origin, Vector3 dir, float reach, struct Pi
 	float dzMin, dzMax, dz;
 	int i, x, y, z;
 
+	/* Zero or NaN direction would never leave the starting cell */
+	if (!(Vector3_LengthSquared(&dir) > 0.0f)) return false;
 	RayTracer_SetVectors(&tracer, origin, dir);
 	Vector3I_Floor(&pOrigin, &origin);
 	insideMap = World_IsValidPos_3I(pOrigin);
 	reachSq   = reach * reach;
+	Picking_CalcSkipRegion(insideMap);
 		
 	for (i = 0; i < 25000; i++) {
 		x = tracer.X; y = tracer.Y; z = tracer.Z;
+		/* Skipped cells are all gas, so never need to be intersected or reach checked */
+		if (Picking_SkipEmpty()) continue;
 		v.X = (float)x; v.Y = (float)y; v.Z = (float)z;
 
 		tracer.Block = insideMap ? Picking_GetInside(x, y, z) : Picking_GetOutside(x, y, z, pOrigin);
@@ -217,10 +268,11 @@ static bool Picking_ClipBlock(struct PickedPos* pos) {
 
 static Vector3 picking_adjust = { 0.1f, 0.1f, 0.1f };
 static bool Picking_ClipCamera(struct PickedPos* pos) {
+	struct BlockPhysicsDesc* desc = &Blocks.Physics[tracer.Block];
 	Vector3 intersect;
 	float t0, t1;
 
-	if (Blocks.Draw[tracer.Block] == DRAW_GAS || Blocks.Collide[tracer.Block] != COLLIDE_SOLID) return false;
+	if (desc->Draw == DRAW_GAS || desc->Collide != COLLIDE_SOLID) return false;
 	if (!Intersection_RayIntersectsBox(tracer.Origin, tracer.Dir, tracer.Min, tracer.Max, &t0, &t1)) return false;
 
 	/* Need to collide with slightly outside block, to avoid camera clipping issues */
@@ -234,6 +286,34 @@ static bool Picking_ClipCamera(struct PickedPos* pos) {
 	return true;
 }
 
+static float picking_maxDist;
+static bool Picking_ClipAny(struct PickedPos* pos) {
+	Vector3 scaledDir, intersect;
+	float t0, t1;
+
+	if (Blocks.Draw[tracer.Block] == DRAW_GAS) return false;
+	if (!Intersection_RayIntersectsBox(tracer.Origin, tracer.Dir, tracer.Min, tracer.Max, &t0, &t1)) return false;
+
+	Vector3_Mul1(&scaledDir, &tracer.Dir, t0);            /* scaledDir = dir * t0 */
+	Vector3_Add(&intersect,  &tracer.Origin, &scaledDir); /* intersect = origin + scaledDir */
+
+	if (Vector3_LengthSquared(&scaledDir) <= picking_maxDist * picking_maxDist) {
+		PickedPos_SetAsValid(pos, &tracer, intersect);
+	} else {
+		PickedPos_SetAsInvalid(pos);
+	}
+	return true;
+}
+
+void Picking_RayCast(Vector3 origin, Vector3 dir, float maxDist, struct PickedPos* pos) {
+	Vector3_Normalize(&dir, &dir);
+	picking_maxDist = min(maxDist, PICKING_MAX_RAYCAST);
+
+	if (!Picking_RayTrace(origin, dir, picking_maxDist, pos, Picking_ClipAny)) {
+		PickedPos_SetAsInvalid(pos);
+	}
+}
+
 void Picking_CalculatePickedBlock(Vector3 origin, Vector3 dir, float reach, struct PickedPos* pos) {
 	if (!Picking_RayTrace(origin, dir, reach, pos, Picking_ClipBlock)) {
 		PickedPos_SetAsInvalid(pos);
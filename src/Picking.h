@@ -46,4 +46,14 @@ void RayTracer_Step(struct RayTracer* t);
    or not being able to find a suitable candiate within the given reach distance.*/
 void Picking_CalculatePickedBlock(Vector3 origin, Vector3 dir, float reach, struct PickedPos* pos);
 void Picking_ClipCameraPos(Vector3 origin, Vector3 dir, float reach, struct PickedPos* pos);
+
+/* Maximum distance a ray can be cast with Picking_RayCast. */
+/* NOTE: A ray crosses at most sqrt(3) blocks per unit of distance, so this stays well under */
+/*  the number of steps Picking_RayTrace gives up after, even where nothing can be skipped. */
+#define PICKING_MAX_RAYCAST 8192.0f
+/* Determines the first non gas block along the ray from the given origin, up to maxDist away. */
+/* Unlike Picking_CalculatePickedBlock, ignores the local player's reach and whether blocks can be picked. */
+/* (e.g. for plugins implementing long reach building tools) */
+/* NOTE: Empty 16x16x16 sections and 4x4x4 bricks are skipped over, so long distances are cheap. */
+CC_API void Picking_RayCast(Vector3 origin, Vector3 dir, float maxDist, struct PickedPos* pos);
 #endif
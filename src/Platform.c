@@ -76,7 +76,6 @@ const ReturnCode ReturnCode_SocketWouldBlock = WSAEWOULDBLOCK;
 
 #define Socket__Error() errno
 char* Platform_NewLine    = "\n";
-pthread_mutex_t event_mutex;
 
 const ReturnCode ReturnCode_FileShareViolation = 1000000000; /* TODO: not used apparently */
 const ReturnCode ReturnCode_FileNotFound = ENOENT;
@@ -475,6 +474,19 @@ ReturnCode File_SetModifiedTime(const String* path, TimeMS time) {
 	return res;
 }
 
+ReturnCode File_Rename(const String* src, const String* dst) {
+	TCHAR srcStr[300], dstStr[300];
+	Platform_ConvertString(srcStr, src);
+	Platform_ConvertString(dstStr, dst);
+	return MoveFileEx(srcStr, dstStr, MOVEFILE_REPLACE_EXISTING) ? 0 : GetLastError();
+}
+
+ReturnCode File_Delete(const String* path) {
+	TCHAR str[300];
+	Platform_ConvertString(str, path);
+	return DeleteFile(str) ? 0 : GetLastError();
+}
+
 static ReturnCode File_Do(FileHandle* file, const String* path, DWORD access, DWORD createMode) {
 	TCHAR str[300]; 
 	Platform_ConvertString(str, path);
@@ -610,6 +622,19 @@ ReturnCode File_SetModifiedTime(const String* path, TimeMS time) {
 	return utime(str, &times) == -1 ? errno : 0;
 }
 
+ReturnCode File_Rename(const String* src, const String* dst) {
+	char srcStr[600], dstStr[600];
+	Platform_ConvertString(srcStr, src);
+	Platform_ConvertString(dstStr, dst);
+	return rename(srcStr, dstStr) == -1 ? errno : 0;
+}
+
+ReturnCode File_Delete(const String* path) {
+	char str[600];
+	Platform_ConvertString(str, path);
+	return unlink(str) == -1 ? errno : 0;
+}
+
 static ReturnCode File_Do(FileHandle* file, const String* path, int mode) {
 	char str[600]; 
 	Platform_ConvertString(str, path);
@@ -664,6 +689,21 @@ ReturnCode File_Length(FileHandle file, uint32_t* len) {
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
+/* Function and argument for Thread_StartArg, freed by the new thread once it starts */
+struct ThreadStartArgs { Thread_StartArgFunc* Func; void* Arg; };
+
+static struct ThreadStartArgs* Thread_AllocArgs(Thread_StartArgFunc* func, void* arg) {
+	struct ThreadStartArgs* args = Mem_Alloc(1, sizeof(struct ThreadStartArgs), "thread args");
+	args->Func = func; args->Arg = arg;
+	return args;
+}
+
+static void Thread_RunArgs(void* param) {
+	struct ThreadStartArgs args = *(struct ThreadStartArgs*)param;
+	Mem_Free(param);
+	args.Func(args.Arg);
+}
+
 #ifdef CC_BUILD_WIN
 void Thread_Sleep(uint32_t milliseconds) { Sleep(milliseconds); }
 DWORD WINAPI Thread_StartCallback(void* param) {
@@ -672,9 +712,9 @@ DWORD WINAPI Thread_StartCallback(void* param) {
 	return 0;
 }
 
-void* Thread_Start(Thread_StartFunc* func, bool detach) {
+static void* Thread_Create(LPTHREAD_START_ROUTINE callback, void* param, bool detach) {
 	DWORD threadID;
-	void* handle = CreateThread(NULL, 0, Thread_StartCallback, func, 0, &threadID);
+	void* handle = CreateThread(NULL, 0, callback, param, 0, &threadID);
 	if (!handle) {
 		Logger_Abort2(GetLastError(), "Creating thread");
 	}
@@ -683,6 +723,19 @@ void* Thread_Start(Thread_StartFunc* func, bool detach) {
 	return handle;
 }
 
+void* Thread_Start(Thread_StartFunc* func, bool detach) {
+	return Thread_Create(Thread_StartCallback, func, detach);
+}
+
+DWORD WINAPI Thread_StartArgCallback(void* param) {
+	Thread_RunArgs(param);
+	return 0;
+}
+
+void* Thread_StartArg(Thread_StartArgFunc* func, void* arg, bool detach) {
+	return Thread_Create(Thread_StartArgCallback, Thread_AllocArgs(func, arg), detach);
+}
+
 void Thread_Detach(void* handle) {
 	if (!CloseHandle((HANDLE)handle)) {
 		Logger_Abort2(GetLastError(), "Freeing thread handle");
@@ -694,15 +747,22 @@ void Thread_Join(void* handle) {
 	Thread_Detach(handle);
 }
 
-static CRITICAL_SECTION mutexList[3]; int mutexIndex;
+int Thread_ProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return max((int)info.dwNumberOfProcessors, 1);
+}
+
 void* Mutex_Create(void) {
-	if (mutexIndex == Array_Elems(mutexList)) Logger_Abort("Cannot allocate mutex");
-	CRITICAL_SECTION* ptr = &mutexList[mutexIndex];
-	InitializeCriticalSection(ptr); mutexIndex++;
+	CRITICAL_SECTION* ptr = Mem_Alloc(1, sizeof(CRITICAL_SECTION), "allocating mutex");
+	InitializeCriticalSection(ptr);
 	return ptr;
 }
 
-void Mutex_Free(void* handle)   { DeleteCriticalSection((CRITICAL_SECTION*)handle); }
+void Mutex_Free(void* handle) {
+	DeleteCriticalSection((CRITICAL_SECTION*)handle);
+	Mem_Free(handle);
+}
 void Mutex_Lock(void* handle)   { EnterCriticalSection((CRITICAL_SECTION*)handle); }
 void Mutex_Unlock(void* handle) { LeaveCriticalSection((CRITICAL_SECTION*)handle); }
 
@@ -737,15 +797,28 @@ void* Thread_StartCallback(void* lpParam) {
 	return NULL;
 }
 
-void* Thread_Start(Thread_StartFunc* func, bool detach) {
+static void* Thread_Create(void* (*callback)(void*), void* param, bool detach) {
 	pthread_t* ptr = Mem_Alloc(1, sizeof(pthread_t), "allocating thread");
-	int res = pthread_create(ptr, NULL, Thread_StartCallback, func);
+	int res = pthread_create(ptr, NULL, callback, param);
 	if (res) Logger_Abort2(res, "Creating thread");
 
 	if (detach) Thread_Detach(ptr);
 	return ptr;
 }
 
+void* Thread_Start(Thread_StartFunc* func, bool detach) {
+	return Thread_Create(Thread_StartCallback, func, detach);
+}
+
+void* Thread_StartArgCallback(void* lpParam) {
+	Thread_RunArgs(lpParam);
+	return NULL;
+}
+
+void* Thread_StartArg(Thread_StartArgFunc* func, void* arg, bool detach) {
+	return Thread_Create(Thread_StartArgCallback, Thread_AllocArgs(func, arg), detach);
+}
+
 void Thread_Detach(void* handle) {
 	pthread_t* ptr = handle;
 	int res = pthread_detach(*ptr);
@@ -760,6 +833,11 @@ void Thread_Join(void* handle) {
 	Mem_Free(ptr);
 }
 
+int Thread_ProcessorCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
 void* Mutex_Create(void) {
 	pthread_mutex_t* ptr = Mem_Alloc(1, sizeof(pthread_mutex_t), "allocating mutex");
 	int res = pthread_mutex_init(ptr, NULL);
@@ -783,30 +861,65 @@ void Mutex_Unlock(void* handle) {
 	if (res) Logger_Abort2(res, "Unlocking mutex");
 }
 
+/* Behaves like an auto-reset event, so a signal is never lost if nothing is waiting yet */
+struct WaitData {
+	pthread_cond_t  cond;
+	pthread_mutex_t mutex;
+	bool signalled;
+};
+
 void* Waitable_Create(void) {
-	pthread_cond_t* ptr = Mem_Alloc(1, sizeof(pthread_cond_t), "allocating waitable");
-	int res = pthread_cond_init(ptr, NULL);
-	if (res) Logger_Abort2(res, "Creating event");
+	struct WaitData* ptr = Mem_Alloc(1, sizeof(struct WaitData), "waitable");
+	int res;
+
+	res = pthread_cond_init(&ptr->cond, NULL);
+	if (res) Logger_Abort2(res, "Creating waitable");
+	res = pthread_mutex_init(&ptr->mutex, NULL);
+	if (res) Logger_Abort2(res, "Creating waitable mutex");
+
+	ptr->signalled = false;
 	return ptr;
 }
 
 void Waitable_Free(void* handle) {
-	int res = pthread_cond_destroy((pthread_cond_t*)handle);
-	if (res) Logger_Abort2(res, "Destroying event");
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+
+	res = pthread_cond_destroy(&ptr->cond);
+	if (res) Logger_Abort2(res, "Destroying waitable");
+	res = pthread_mutex_destroy(&ptr->mutex);
+	if (res) Logger_Abort2(res, "Destroying waitable mutex");
 	Mem_Free(handle);
 }
 
 void Waitable_Signal(void* handle) {
-	int res = pthread_cond_signal((pthread_cond_t*)handle);
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+
+	Mutex_Lock(&ptr->mutex);
+	ptr->signalled = true;
+	Mutex_Unlock(&ptr->mutex);
+
+	res = pthread_cond_signal(&ptr->cond);
 	if (res) Logger_Abort2(res, "Signalling event");
 }
 
 void Waitable_Wait(void* handle) {
-	int res = pthread_cond_wait((pthread_cond_t*)handle, &event_mutex);
-	if (res) Logger_Abort2(res, "Waiting event");
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+
+	Mutex_Lock(&ptr->mutex);
+	/* pthread_cond_wait can wake up spuriously, without being signalled */
+	while (!ptr->signalled) {
+		res = pthread_cond_wait(&ptr->cond, &ptr->mutex);
+		if (res) Logger_Abort2(res, "Waitable wait");
+	}
+	ptr->signalled = false;
+	Mutex_Unlock(&ptr->mutex);
 }
 
 void Waitable_WaitFor(void* handle, uint32_t milliseconds) {
+	struct WaitData* ptr = (struct WaitData*)handle;
 	struct timeval tv;
 	struct timespec ts;
 	int res;
@@ -817,9 +930,15 @@ void Waitable_WaitFor(void* handle, uint32_t milliseconds) {
 	ts.tv_sec += ts.tv_nsec / NS_PER_SEC;
 	ts.tv_nsec %= NS_PER_SEC;
 
-	res = pthread_cond_timedwait((pthread_cond_t*)handle, &event_mutex, &ts);
-	if (res == ETIMEDOUT) return;
-	if (res) Logger_Abort2(res, "Waiting timed event");
+	Mutex_Lock(&ptr->mutex);
+	/* ts is an absolute deadline, so waiting again after a spurious wakeup doesn't extend it */
+	while (!ptr->signalled) {
+		res = pthread_cond_timedwait(&ptr->cond, &ptr->mutex, &ts);
+		if (res == ETIMEDOUT) break;
+		if (res) Logger_Abort2(res, "Waitable wait for");
+	}
+	ptr->signalled = false;
+	Mutex_Unlock(&ptr->mutex);
 }
 #endif
 
@@ -1414,6 +1533,7 @@ struct AudioContext {
 	WAVEHDR Headers[AUDIO_MAX_BUFFERS];
 	struct AudioFormat Format;
 	int Count;
+	HANDLE Waitable;
 };
 static struct AudioContext Audio_Contexts[20];
 
@@ -1429,8 +1549,9 @@ void Audio_Init(AudioHandle* handle, int buffers) {
 			ctx->Headers[j].dwFlags = WHDR_DONE;
 		}
 
-		*handle    = i;
-		ctx->Count = buffers;
+		*handle       = i;
+		ctx->Count    = buffers;
+		ctx->Waitable = NULL;
 		return;
 	}
 	Logger_Abort("No free audio contexts");
@@ -1442,8 +1563,9 @@ ReturnCode Audio_Free(AudioHandle handle) {
 	ReturnCode res;
 	ctx = &Audio_Contexts[handle];
 
-	ctx->Count  = 0;
-	ctx->Format = fmt;
+	ctx->Count    = 0;
+	ctx->Format   = fmt;
+	ctx->Waitable = NULL;
 	if (!ctx->Handle) return 0;
 
 	res = waveOutClose(ctx->Handle);
@@ -1470,6 +1592,10 @@ ReturnCode Audio_SetFormat(AudioHandle handle, struct AudioFormat* format) {
 	fmt.cbSize          = 0;
 
 	ctx->Format = *format;
+	/* event is signalled whenever the device is done with a buffer */
+	if (ctx->Waitable) {
+		return waveOutOpen(&ctx->Handle, WAVE_MAPPER, &fmt, (DWORD_PTR)ctx->Waitable, 0, CALLBACK_EVENT);
+	}
 	return waveOutOpen(&ctx->Handle, WAVE_MAPPER, &fmt, 0, 0, CALLBACK_NULL);
 }
 
@@ -1511,6 +1637,11 @@ ReturnCode Audio_IsCompleted(AudioHandle handle, int idx, bool* completed) {
 }
 
 ReturnCode Audio_IsFinished(AudioHandle handle, bool* finished) { return Audio_AllCompleted(handle, finished); }
+
+bool Audio_SetWaitable(AudioHandle handle, void* waitable) {
+	Audio_Contexts[handle].Waitable = (HANDLE)waitable;
+	return true;
+}
 #endif
 #ifdef CC_BUILD_POSIX
 struct AudioContext {
@@ -1712,6 +1843,9 @@ ReturnCode Audio_IsFinished(AudioHandle handle, bool* finished) {
 	alGetSourcei(ctx->Source, AL_SOURCE_STATE, &state);
 	*finished = state != AL_PLAYING; return 0;
 }
+
+/* OpenAL has no notification of when a buffer has been processed */
+bool Audio_SetWaitable(AudioHandle handle, void* waitable) { return false; }
 #endif
 static ReturnCode Audio_AllCompleted(AudioHandle handle, bool* finished) {
 	struct AudioContext* ctx = &Audio_Contexts[handle];
@@ -1960,12 +2094,10 @@ void Platform_Init(void) {
 	signal(SIGCHLD, SIG_IGN);
 	Platform_InitDisplay();
 	Platform_InitStopwatch();
-	pthread_mutex_init(&event_mutex, NULL);
 	pthread_mutex_init(&audio_lock,  NULL);
 }
 
 void Platform_Free(void) {
-	pthread_mutex_destroy(&event_mutex);
 	pthread_mutex_destroy(&audio_lock);
 }
 
@@ -134,6 +134,10 @@ bool File_Exists(const String* path);
 ReturnCode File_GetModifiedTime(const String* path, TimeMS* ms);
 /* Sets the last time the file was modified, as number of milliseconds since 1/1/0001 */
 ReturnCode File_SetModifiedTime(const String* path, TimeMS ms);
+/* Renames the given file. (replacing dst if it already exists) */
+ReturnCode File_Rename(const String* src, const String* dst);
+/* Deletes the given file. */
+ReturnCode File_Delete(const String* path);
 
 /* Attempts to create a new (or overwrite) file for writing. */
 /* NOTE: If the file already exists, its contents are discarded. */
@@ -160,12 +164,17 @@ CC_API void Thread_Sleep(uint32_t milliseconds);
 typedef void Thread_StartFunc(void);
 /* Starts a new thread, optionally immediately detaching it. (See Thread_Detach) */
 CC_API void* Thread_Start(Thread_StartFunc* func, bool detach);
+typedef void Thread_StartArgFunc(void* arg);
+/* Starts a new thread that calls func with the given argument. (See Thread_Start) */
+CC_API void* Thread_StartArg(Thread_StartArgFunc* func, void* arg, bool detach);
 /* Frees the platform specific persistent data associated with the thread. */
 /* NOTE: You must either detach or join threads, as this data otherwise leaks. */
 CC_API void Thread_Detach(void* handle);
 /* Blocks the current thread, until the given thread has finished. */
 /* NOTE: Once a thread has been detached, you can no longer use this method. */
 CC_API void Thread_Join(void* handle);
+/* Returns the number of processors (cores) that threads can run on. */
+CC_API int  Thread_ProcessorCount(void);
 
 /* Allocates a new mutex. (used to synchronise access to a shared resource) */
 CC_API void* Mutex_Create(void);
@@ -254,4 +263,8 @@ ReturnCode Audio_Stop(AudioHandle handle);
 ReturnCode Audio_IsCompleted(AudioHandle handle, int idx, bool* completed);
 /* Returns whether all buffers have finished playing. */
 ReturnCode Audio_IsFinished(AudioHandle handle, bool* finished);
+/* Sets the waitable that is signalled whenever a buffer finishes playing. */
+/* Returns false when the backend can't signal this, so buffers must be polled instead. */
+/* NOTE: Must be called before Audio_SetFormat. */
+bool Audio_SetWaitable(AudioHandle handle, void* waitable);
 #endif
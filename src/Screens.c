@@ -632,14 +632,8 @@ struct Screen* LoadingScreen_UNSAFE_RawPointer = (struct Screen*)&LoadingScreen_
 static void GeneratingScreen_Init(void* screen) {
 	World_Reset();
 	Event_RaiseVoid(&WorldEvents.NewMap);
-	Gen_Done = false;
 	LoadingScreen_Init(screen);
-
-	if (Gen_Vanilla) {
-		Thread_Start(&NotchyGen_Generate, true);
-	} else {
-		Thread_Start(&FlatgrassGen_Generate, true);
-	}
+	Gen_Start();
 }
 
 static void GeneratingScreen_EndGeneration(void) {
@@ -648,15 +642,13 @@ static void GeneratingScreen_EndGeneration(void) {
 	float x, z;
 
 	Gui_CloseActive();
-	Gen_Done = false;
-
 	if (!Gen_Blocks) {
 		Chat_AddRaw("&cFailed to generate the map."); return;
 	}
 
 	World_BlocksSize = Gen_Width * Gen_Height * Gen_Length;
 	World_SetNewMap(Gen_Blocks, World_BlocksSize, Gen_Width, Gen_Height, Gen_Length);
-	Gen_Blocks = NULL;
+	Gen_Stop();
 
 	x = (World_Width / 2) + 0.5f; z = (World_Length / 2) + 0.5f;
 	p->Spawn = Respawn_FindSpawnPosition(x, z, p->Base.Size);
@@ -814,16 +806,10 @@ static void ChatScreen_SetInitialMessages(struct ChatScreen* s) {
 static void ChatScreen_CheckOtherStatuses(struct ChatScreen* s) {
 	const static String texPack = String_FromConst("texturePack");
 	String str; char strBuffer[STRING_SIZE];
-	struct HttpRequest request;
 	int progress;
-	bool hasRequest;
-	String identifier;
-	
-	hasRequest = Http_GetCurrent(&request, &progress);
-	identifier = String_FromRawArray(request.ID);	
 
 	/* Is terrain / texture pack currently being downloaded? */
-	if (!hasRequest || !String_Equals(&identifier, &texPack)) {
+	if (!Http_GetProgress(&texPack, &progress)) {
 		if (s->Status.Textures[1].ID) {
 			TextGroupWidget_SetText(&s->Status, 1, &String_Empty);
 		}
@@ -22,6 +22,9 @@
 #include "Inventory.h"
 #include "Platform.h"
 #include "GameStructs.h"
+#include "Deflate.h"
+#include "Stream.h"
+#include "Errors.h"
 
 static char server_nameBuffer[STRING_SIZE];
 static char server_motdBuffer[STRING_SIZE];
@@ -52,20 +55,11 @@ void Server_RetrieveTexturePack(const String* url) {
 
 void Server_DownloadTexturePack(const String* url) {
 	const static String texPack = String_FromConst("texturePack");
-	String etag; char etagBuffer[STRING_SIZE];
-	TimeMS lastModified;
-
 	if (TextureCache_HasDenied(url)) return;
-	String_InitArray(etag, etagBuffer);
-	lastModified = 0;
-
-	if (TextureCache_Has(url)) {
-		TextureCache_GetLastModified(url, &lastModified);
-		TextureCache_GetETag(url, &etag);
-	}
 
+	/* Http revalidates the cached copy, so this is only downloaded again if changed */
 	TexturePack_ExtractCurrent(url);
-	Http_AsyncGetDataEx(url, true, &texPack, &lastModified, &etag);
+	Http_AsyncGetStreamed(url, true, &texPack, NULL, NULL, Http_CacheOnly);
 }
 
 static void Server_CheckAsyncResources(void) {
@@ -73,7 +67,8 @@ static void Server_CheckAsyncResources(void) {
 	struct HttpRequest item;
 	if (!Http_GetResult(&texPack, &item)) return;
 
-	if (item.Success) {
+	/* 304 means the cached copy already extracted by Server_DownloadTexturePack is up to date */
+	if (item.Success && item.StatusCode == 200) {
 		TexturePack_Extract_Req(&item);
 	} else if (item.Result) {
 		Chat_Add1("&cError %i when trying to download texture pack", &item.Result);
@@ -261,9 +256,45 @@ static bool net_connecting;
 static TimeMS net_connectTimeout;
 #define NET_TIMEOUT_MS (15 * 1000)
 
+/* Compressed stream state (see Net_BeginCompression) */
+static bool net_compressed, net_beginCompression;
+static struct InflateState net_inflateState;
+static struct Stream net_inflateStream, net_compPart;
+static uint8_t net_compBuffer[4096 * 4];
+
 static void Server_Free(void);
+static void MPConnection_ResetCompression(void) {
+	net_compressed = false; net_beginCompression = false;
+	Stream_ReadonlyMemory(&net_compPart, net_compBuffer, 0);
+}
+
+void Net_BeginCompression(void) {
+	if (net_compressed) return;
+	net_compressed = true; net_beginCompression = true;
+	Inflate_MakeStream(&net_inflateStream, &net_inflateState, &net_compPart);
+}
+
+/* Reads compressed data from the socket, then decompresses as much of it as possible */
+static ReturnCode MPConnection_ReadCompressed(uint8_t* data, uint32_t pending, uint32_t* read) {
+	ReturnCode res;
+	*read = 0;
+
+	/* Only read more data from socket once all previously read data has been consumed */
+	if (pending && !net_compPart.Meta.Mem.Left) {
+		res = Socket_Read(net_socket, net_compBuffer, sizeof(net_compBuffer), &pending);
+		if (res) return res;
+		Stream_ReadonlyMemory(&net_compPart, net_compBuffer, pending);
+	}
+
+	res = net_inflateStream.Read(&net_inflateStream, data, 4096 * 4, read);
+	if (res) return res;
+	/* Server only ever sync flushes, so the stream must never end */
+	return net_inflateState.LastBlock ? NET_ERR_COMP_FINAL_BLOCK : 0;
+}
+
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
+	MPConnection_ResetCompression();
 	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
 	net_readCurrent = net_readBuffer;
 	Server.WriteBuffer = net_writeBuffer;
@@ -415,7 +446,10 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 	res     = Socket_Available(net_socket, &pending);
 	readEnd = net_readCurrent;
 
-	if (!res && pending) {
+	if (!res && net_compressed) {
+		res = MPConnection_ReadCompressed(net_readCurrent, pending, &pending);
+		readEnd += pending;
+	} else if (!res && pending) {
 		/* NOTE: Always using a read call that is a multiple of 4096 (appears to?) improve read performance */	
 		res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &pending);
 		readEnd += pending;
@@ -459,7 +493,19 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		}
 
 		handler(net_readCurrent + 1);  /* skip opcode */
+		/* Handler disconnects when the server sent invalid data */
+		if (Server.Disconnected) return;
 		net_readCurrent += Net_PacketSizes[opcode];
+
+		/* All data after the BeginCompression packet is compressed */
+		if (net_beginCompression) {
+			net_beginCompression = false;
+			remaining = (int)(readEnd - net_readCurrent);
+
+			Mem_Copy(net_compBuffer, net_readCurrent, remaining);
+			Stream_ReadonlyMemory(&net_compPart, net_compBuffer, remaining);
+			net_readCurrent = readEnd; break;
+		}
 	}
 
 	/* Protocol packets might be split up across TCP packets */
@@ -537,6 +583,7 @@ static void MPConnection_Reset(void) {
 	}
 
 	net_writeFailed = false;
+	MPConnection_ResetCompression();
 	Block_SetUsedCount(256);
 	Handlers_Reset();
 	Server_Free();
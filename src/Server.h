@@ -31,7 +31,7 @@ enum OPCODE_ {
 	OPCODE_BULK_BLOCK_UPDATE,   OPCODE_SET_TEXT_COLOR,
 	OPCODE_ENV_SET_MAP_URL,     OPCODE_ENV_SET_MAP_PROPERTY,
 	OPCODE_SET_ENTITY_PROPERTY, OPCODE_TWO_WAY_PING,
-	OPCODE_SET_INVENTORY_ORDER,
+	OPCODE_SET_INVENTORY_ORDER, OPCODE_BEGIN_COMPRESSION,
 
 	OPCODE_COUNT
 };
@@ -101,4 +101,7 @@ extern Net_Handler Net_Handlers[OPCODE_COUNT];
 #define Net_Set(opcode, handler, size) Net_Handlers[opcode] = handler; Net_PacketSizes[opcode] = size;
 
 void Net_SendPacket(void);
+/* Marks all data received from the server after the current packet as being DEFLATE compressed. */
+/* NOTE: The server sends this compressed data with a sync flush after each batch of packets. */
+void Net_BeginCompression(void);
 #endif
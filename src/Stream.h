@@ -31,6 +31,7 @@ struct Stream {
 	union {
 		FileHandle File;
 		void* Inflate;
+		void* Http;
 		/* NOTE: These structs rely on overlapping Meta_Mem fields being the same! Don't change them */
 		struct { uint8_t* Cur; uint32_t Left, Length; uint8_t* Base; } Mem;
 		struct { struct Stream* Source; uint32_t Left, Length; } Portion;
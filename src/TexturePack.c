@@ -498,15 +498,31 @@ void Atlas_Free(void) {
 /*########################################################################################################################*
 *------------------------------------------------------TextureCache-------------------------------------------------------*
 *#########################################################################################################################*/
-/* Because I didn't store milliseconds in original C# client */
-#define TEXCACHE_TICKS_PER_MS 10000
-static struct EntryList cache_accepted, cache_denied, cache_eTags, cache_lastModified;
+static struct EntryList cache_accepted, cache_denied;
+
+/* Texture packs used to be cached here, named by CRC32 of their URL, along with etags.txt and */
+/* lastmodified.txt. They are in the http disk cache now, and can't be moved into it as the URLs */
+/* they were downloaded from weren't stored, so the old copies are just deleted (only once). */
+static void TextureCache_DeleteOld(const String* path, void* obj) {
+	const static String part = String_FromConst(".part");
+	String name = *path;
+	uint64_t crc;
+	Utils_UNSAFE_GetFilename(&name);
+
+	if (String_CaselessEqualsConst(&name, "etags.txt") || String_CaselessEqualsConst(&name, "lastmodified.txt")
+		|| String_CaselessEnds(&name, &part) || Convert_ParseUInt64(&name, &crc)) {
+		File_Delete(path);
+	}
+}
 
 void TextureCache_Init(void) {
-	EntryList_Init(&cache_accepted,     "texturecache", "acceptedurls.txt", ' ');
-	EntryList_Init(&cache_denied,       "texturecache", "deniedurls.txt",   ' ');
-	EntryList_Init(&cache_eTags,        "texturecache", "etags.txt",        ' ');
-	EntryList_Init(&cache_lastModified, "texturecache", "lastmodified.txt", ' ');
+	const static String dir = String_FromConst("texturecache");
+	EntryList_Init(&cache_accepted, "texturecache", "acceptedurls.txt", ' ');
+	EntryList_Init(&cache_denied,   "texturecache", "deniedurls.txt",   ' ');
+	if (Options_GetBool(OPT_OLD_TEXTURECACHE_DELETED, false)) return;
+
+	if (Directory_Exists(&dir)) Directory_Enum(&dir, NULL, TextureCache_DeleteOld);
+	Options_SetBool(OPT_OLD_TEXTURECACHE_DELETED, true);
 }
 
 bool TextureCache_HasAccepted(const String* url) { return EntryList_Find(&cache_accepted, url) >= 0; }
@@ -521,103 +537,6 @@ void TextureCache_Deny(const String* url)        {
 	EntryList_Save(&cache_denied);
 }
 
-CC_NOINLINE static void TextureCache_MakePath(String* path, const String* url) {
-	String key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
-
-	String_AppendUInt32(&key, Utils_CRC32(url->buffer, url->length));
-	String_Format1(path, "texturecache/%s", &key);
-}
-
-bool TextureCache_Has(const String* url) {
-	String path; char pathBuffer[FILENAME_SIZE];
-	String_InitArray(path, pathBuffer);
-
-	TextureCache_MakePath(&path, url);
-	return File_Exists(&path);
-}
-
-bool TextureCache_Get(const String* url, struct Stream* stream) {
-	String path; char pathBuffer[FILENAME_SIZE];
-	ReturnCode res;
-
-	String_InitArray(path, pathBuffer);
-	TextureCache_MakePath(&path, url);
-	res = Stream_OpenFile(stream, &path);
-
-	if (res == ReturnCode_FileNotFound) return false;
-	if (res) { Logger_Warn2(res, "opening cache for", url); return false; }
-	return true;
-}
-
-void TexturePack_GetFromTags(const String* url, String* result, struct EntryList* list) {
-	String key, value; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
-
-	String_AppendUInt32(&key, Utils_CRC32(url->buffer, url->length));	
-	value = EntryList_UNSAFE_Get(list, &key);
-	if (value.length) String_AppendString(result, &value);
-}
-
-void TextureCache_GetLastModified(const String* url, TimeMS* time) {
-	String path;  char pathBuffer[FILENAME_SIZE];
-	String entry; char entryBuffer[STRING_SIZE];
-	ReturnCode res;
-
-	String_InitArray(entry, entryBuffer);
-	TexturePack_GetFromTags(url, &entry, &cache_lastModified);
-
-	if (entry.length && Convert_ParseUInt64(&entry, time)) {
-		*time /= TEXCACHE_TICKS_PER_MS;
-	} else {
-		String_InitArray(path, pathBuffer);
-		TextureCache_MakePath(&path, url);
-
-		res = File_GetModifiedTime(&path, time);
-		if (res) { Logger_Warn2(res, "getting last modified time of", url); *time = 0; }
-	}
-}
-
-void TextureCache_GetETag(const String* url, String* etag) {
-	TexturePack_GetFromTags(url, etag, &cache_eTags);
-}
-
-void TextureCache_Set(const String* url, uint8_t* data, uint32_t length) {
-	String path; char pathBuffer[FILENAME_SIZE];
-	ReturnCode res;
-
-	String_InitArray(path, pathBuffer);
-	TextureCache_MakePath(&path, url);
-	if (!Utils_EnsureDirectory("texturecache")) return;
-	
-	res = Stream_WriteAllTo(&path, data, length);
-	if (res) { Logger_Warn2(res, "caching", url); }
-}
-
-CC_NOINLINE static void TextureCache_SetEntry(const String* url, const String* data, struct EntryList* list) {
-	String key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
-
-	String_AppendUInt32(&key, Utils_CRC32(url->buffer, url->length));
-	EntryList_Set(list, &key, data);
-	EntryList_Save(list);
-}
-
-void TextureCache_SetETag(const String* url, const String* etag) {
-	if (!etag->length) return;
-	TextureCache_SetEntry(url, etag, &cache_eTags);
-}
-
-void TextureCache_SetLastModified(const String* url, const TimeMS* lastModified) {
-	String data; char dataBuffer[STRING_SIZE];
-	uint64_t ticks = (*lastModified) * TEXCACHE_TICKS_PER_MS;
-	if (!ticks) return;
-
-	String_InitArray(data, dataBuffer);
-	String_AppendUInt64(&data, ticks);
-	TextureCache_SetEntry(url, &data, &cache_lastModified);
-}
-
 
 /*########################################################################################################################*
 *-------------------------------------------------------TexturePack-------------------------------------------------------*
@@ -688,7 +607,7 @@ void TexturePack_ExtractCurrent(const String* url) {
 
 	if (!url->length) { TexturePack_ExtractDefault(); return; }
 	
-	if (!TextureCache_Get(url, &stream)) {
+	if (!Http_OpenCached(url, &stream)) {
 		/* e.g. 404 errors */
 		if (World_TextureUrl.length) TexturePack_ExtractDefault();
 	} else {
@@ -707,27 +626,32 @@ void TexturePack_ExtractCurrent(const String* url) {
 }
 
 void TexturePack_Extract_Req(struct HttpRequest* item) {
-	String url, etag;
-	void* data; uint32_t len;
-	struct Stream mem;
+	String url;
+	struct Stream stream;
+	uint8_t sig[PNG_SIG_SIZE];
+	uint32_t read;
 	bool png;
 	ReturnCode res;
 
-	url  = String_FromRawArray(item->URL);
+	url = String_FromRawArray(item->URL);
 	String_Copy(&World_TextureUrl, &url);
-	data = item->Data;
-	len  = item->Size;
+	HttpRequest_Free(item);
 
-	etag = String_FromRawArray(item->Etag);
-	TextureCache_Set(&url, data, len);
-	TextureCache_SetETag(&url, &etag);
-	TextureCache_SetLastModified(&url, &item->LastModified);
+	/* Contents were written straight to the http cache, instead of into memory */
+	if (!Http_OpenCached(&url, &stream)) {
+		Logger_Warn2(ReturnCode_FileNotFound, "opening cache for", &url); return;
+	}
 
-	Stream_ReadonlyMemory(&mem, data, len);
-	png = Png_Detect(data, len);
-	res = png ? TexturePack_ExtractTerrainPng(&mem) 
-			 : TexturePack_ExtractZip(&mem);
+	res = stream.Read(&stream, sig, PNG_SIG_SIZE, &read);
+	png = !res && Png_Detect(sig, read);
+	if (!res) res = stream.Seek(&stream, 0);
 
+	if (!res) {
+		res = png ? TexturePack_ExtractTerrainPng(&stream) 
+				  : TexturePack_ExtractZip(&stream);
+	}
 	if (res) Logger_Warn2(res, png ? "decoding" : "extracting", &url);
-	HttpRequest_Free(item);
+
+	res = stream.Close(&stream);
+	if (res) Logger_Warn2(res, "closing cache for", &url);
 }
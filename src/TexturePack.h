@@ -66,6 +66,7 @@ void Atlas_Free(void);
 TextureRec Atlas1D_TexRec(TextureLoc texLoc, int uCount, int* index);
 
 /* Initialises cache state. (e.g. loading accepted/denied lists) */
+/* NOTE: Texture packs themselves are cached by Http. (see Http_OpenCached) */
 void TextureCache_Init(void);
 /* Whether the given URL is in list of accepted URLs. */
 bool TextureCache_HasAccepted(const String* url);
@@ -78,22 +79,6 @@ void TextureCache_Accept(const String* url);
 /* Denied URLs are never loaded. */
 void TextureCache_Deny(const String* url);
 
-/* Returns whether the given URL has been cached. */
-bool TextureCache_Has(const String* url);
-/* Attempts to get the cached data stream for the given url. */
-bool TextureCache_Get(const String* url, struct Stream* stream);
-/* Attempts to get the Last-Modified header cached for the given URL. */
-/* If header is not found, returns last time the cached data was modified. */
-void TextureCache_GetLastModified(const String* url, TimeMS* time);
-/* Attempts to get the ETag header cached for the given URL. */
-void TextureCache_GetETag(const String* url, String* etag);
-/* Sets the cached data for the given url. */
-void TextureCache_Set(const String* url, uint8_t* data, uint32_t length);
-/* Sets the cached ETag header for the given url. */
-void TextureCache_SetETag(const String* url, const String* etag);
-/* Sets the cached Last-Modified header for the given url. */
-void TextureCache_SetLastModified(const String* url, const TimeMS* lastModified);
-
 void TexturePack_ExtractZip_File(const String* filename);
 void TexturePack_ExtractDefault(void);
 void TexturePack_ExtractCurrent(const String* url);
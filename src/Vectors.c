@@ -56,7 +56,7 @@ Vector3 Vector3_RotateZ(Vector3 v, float angle) {
 }
 
 
-void Vector3I_Floor(Vector3I* result, Vector3* a) {
+void Vector3I_Floor(Vector3I* result, const Vector3* a) {
 	result->X = Math_Floor(a->X); result->Y = Math_Floor(a->Y); result->Z = Math_Floor(a->Z);
 }
 
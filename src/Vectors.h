@@ -112,7 +112,7 @@ static CC_INLINE bool Vector3I_NotEquals(const Vector3I* a, const Vector3I* b) {
 	return a->X != b->X || a->Y != b->Y || a->Z != b->Z;
 }
 
-void Vector3I_Floor(Vector3I* result, Vector3* a);
+void Vector3I_Floor(Vector3I* result, const Vector3* a);
 void Vector3I_ToVector3(Vector3* result, Vector3I* a);
 void Vector3I_Min(Vector3I* result, Vector3I* a, Vector3I* b);
 void Vector3I_Max(Vector3I* result, Vector3I* a, Vector3I* b);
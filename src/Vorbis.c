@@ -12,12 +12,21 @@
 *-------------------------------------------------------Ogg stream--------------------------------------------------------*
 *#########################################################################################################################*/
 #define OGG_FourCC(a, b, c, d) (((uint32_t)a << 24) | ((uint32_t)b << 16) | ((uint32_t)c << 8) | (uint32_t)d)
-static ReturnCode Ogg_NextPage(struct Stream* stream) {
+struct OggPage {
+	uint32_t HeaderSize, Size; /* size of page header and of page data */
+	int LastStart;             /* offset in page data of the last packet that finishes in this page, */
+	                           /*  or -1 if no packet both starts and finishes in this page */
+	uint32_t Granule;          /* sample position at end of the last packet that finishes in this page */
+	bool HasGranule;           /* false when no packet finishes in this page */
+	uint8_t Flags;
+};
+
+static ReturnCode Ogg_ReadHeader(struct Stream* source, struct OggPage* page) {
 	uint8_t header[27];
-	struct Stream* source;
-	uint32_t sig, size;
-	int i, numSegments;
 	uint8_t segments[255];
+	uint32_t sig;
+	int i, numSegments, start;
+	bool continued;
 	ReturnCode res;
 
 	/* OGG page format:
@@ -32,7 +41,6 @@ static ReturnCode Ogg_NextPage(struct Stream* stream) {
 	* [number of segments] number of bytes in each segment
 	* [sum of bytes in each segment] page data
 	*/
-	source = stream->Meta.Ogg.Source;
 	if ((res = Stream_Read(source, header, sizeof(header)))) return res;
 
 	sig = Stream_GetU32_BE(&header[0]);
@@ -40,14 +48,43 @@ static ReturnCode Ogg_NextPage(struct Stream* stream) {
 	if (header[4] != 0) return OGG_ERR_VERSION;
 
 	numSegments = header[26];
-	size = 0;
 	if ((res = Stream_Read(source, segments, numSegments))) return res;
-	for (i = 0; i < numSegments; i++) size += segments[i];
 
-	if ((res = Stream_Read(source, stream->Meta.Ogg.Base, size))) return res;
+	page->HeaderSize = sizeof(header) + numSegments;
+	page->Flags      = header[5];
+	page->Granule    = Stream_GetU32_LE(&header[6]);
+	/* granule of -1 means no packet finishes in this page */
+	page->HasGranule = page->Granule != 0xFFFFFFFFUL || Stream_GetU32_LE(&header[10]) != 0xFFFFFFFFUL;
+
+	page->Size      = 0;
+	page->LastStart = -1;
+	continued = header[5] & 1;
+	start     = 0;
+
+	for (i = 0; i < numSegments; i++) {
+		page->Size += segments[i];
+		/* packet ends at first segment that is less than 255 bytes */
+		if (segments[i] == 255) continue;
+
+		if (!continued) page->LastStart = start;
+		continued = false;
+		start     = page->Size;
+	}
+	return 0;
+}
+
+static ReturnCode Ogg_NextPage(struct Stream* stream) {
+	struct Stream* source;
+	struct OggPage page;
+	ReturnCode res;
+
+	source = stream->Meta.Ogg.Source;
+	if ((res = Ogg_ReadHeader(source, &page))) return res;
+
+	if ((res = Stream_Read(source, stream->Meta.Ogg.Base, page.Size))) return res;
 	stream->Meta.Ogg.Cur  = stream->Meta.Ogg.Base;
-	stream->Meta.Ogg.Left = size;
-	stream->Meta.Ogg.Last = header[5] & 4;
+	stream->Meta.Ogg.Left = page.Size;
+	stream->Meta.Ogg.Last = page.Flags & 4;
 	return 0;
 }
 
@@ -182,38 +219,31 @@ struct Codebook {
 	/* vector quantisation values */
 	float MinValue, DeltaValue;
 	uint32_t SequenceP, LookupType, LookupValues;
-	uint16_t* Multiplicands;
+	float* Vectors; /* dequantised vector of each entry, Entries * Dimensions */
 };
 
 static void Codebook_Free(struct Codebook* c) {
 	Mem_Free(c->Codewords);
 	Mem_Free(c->Values);
-	Mem_Free(c->Multiplicands);
+	Mem_Free(c->Vectors);
 }
 
-static uint32_t Codebook_Pow(uint32_t base, uint32_t exp) {
-	uint32_t result = 1; /* exponentiation by squaring */
-	while (exp) {
-		if (exp & 1) result *= base;
-		exp >>= 1;
-		base *= base;
+/* Whether base to the power of exp is greater than limit */
+static bool Codebook_PowExceeds(uint32_t base, uint32_t exp, uint32_t limit) {
+	uint64_t result = 1;
+	/* stops as soon as result > limit, so result never exceeds 2^24 * 2^24 */
+	for (; exp; exp--) {
+		result *= base;
+		if (result > limit) return true;
 	}
-	return result;
+	return false;
 }
 
 static uint32_t Codebook_Lookup1Values(uint32_t entries, uint32_t dimensions) {
-	uint32_t i, pow, next;
+	uint32_t i;
 	/* the greatest integer value for which [value] to the power of [dimensions] is less than or equal to [entries] */
-	/* TODO: verify this */
-	for (i = 1; ; i++) {
-		pow  = Codebook_Pow(i,     dimensions);
-		next = Codebook_Pow(i + 1, dimensions);
-
-		if (next < pow)     return i; /* overflow */
-		if (pow == entries) return i;
-		if (next > entries) return i;
-	}
-	return 0;
+	for (i = 1; !Codebook_PowExceeds(i + 1, dimensions, entries); i++) { }
+	return i;
 }
 
 static bool Codebook_CalcCodewords(struct Codebook* c, uint8_t* len) {
@@ -276,6 +306,32 @@ static bool Codebook_CalcCodewords(struct Codebook* c, uint8_t* len) {
 	return true;
 }
 
+/* Dequantises every entry's vector up front, so decoding a vector is just a table add */
+static void Codebook_CalcVectors(struct Codebook* c, uint16_t* multiplicands) {
+	uint32_t i, j, offset, indexDivisor;
+	float last, value, *v;
+
+	c->Vectors = Mem_Alloc(c->Entries * c->Dimensions, 4, "codebook vectors");
+	v = c->Vectors;
+
+	for (i = 0; i < c->Entries; i++) {
+		last = 0.0f; indexDivisor = 1;
+
+		for (j = 0; j < c->Dimensions; j++) {
+			if (c->LookupType == 1) {
+				offset = (i / indexDivisor) % c->LookupValues;
+				indexDivisor *= c->LookupValues;
+			} else {
+				offset = i * c->Dimensions + j;
+			}
+
+			value = multiplicands[offset] * c->DeltaValue + c->MinValue + last;
+			*v++  = value;
+			if (c->SequenceP) last = value;
+		}
+	}
+}
+
 static ReturnCode Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook* c) {
 	uint32_t sync;
 	uint8_t* codewordLens;
@@ -284,6 +340,7 @@ static ReturnCode Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 	int runBits, runLen;
 	int valueBits;
 	uint32_t lookupValues;
+	uint16_t* multiplicands;
 
 	sync = Vorbis_ReadBits(ctx, 24);
 	if (sync != CODEBOOK_SYNC) return VORBIS_ERR_CODEBOOK_SYNC;
@@ -331,9 +388,13 @@ static ReturnCode Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 	Mem_Free(codewordLens);
 
 	c->LookupType    = Vorbis_ReadBits(ctx, 4);
-	c->Multiplicands = NULL;
+	c->Vectors    = NULL;
 	if (c->LookupType == 0) return 0;
 	if (c->LookupType > 2)  return VORBIS_ERR_CODEBOOK_LOOKUP;
+	/* Entries * Dimensions (up to 2^40) is the size of the vectors table, which must fit in 32 bits */
+	if (!c->Dimensions || (uint64_t)c->Entries * c->Dimensions * sizeof(float) > 0xFFFFFFFFUL) {
+		return VORBIS_ERR_CODEBOOK_ENTRY;
+	}
 
 	c->MinValue   = float32_unpack(ctx);
 	c->DeltaValue = float32_unpack(ctx);
@@ -347,10 +408,13 @@ static ReturnCode Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 	}
 	c->LookupValues = lookupValues;
 
-	c->Multiplicands = Mem_Alloc(lookupValues, 2, "multiplicands");
+	multiplicands = Mem_Alloc(lookupValues, 2, "multiplicands");
 	for (i = 0; i < lookupValues; i++) {
-		c->Multiplicands[i] = Vorbis_ReadBits(ctx, valueBits);
+		multiplicands[i] = Vorbis_ReadBits(ctx, valueBits);
 	}
+
+	Codebook_CalcVectors(c, multiplicands);
+	Mem_Free(multiplicands);
 	return 0;
 }
 
@@ -377,29 +441,16 @@ static uint32_t Codebook_DecodeScalar(struct VorbisState* ctx, struct Codebook*
 
 static void Codebook_DecodeVectors(struct VorbisState* ctx, struct Codebook* c, float* v, int step) {
 	uint32_t lookupOffset = Codebook_DecodeScalar(ctx, c);
-	float last = 0.0f, value;
-	uint32_t i, offset;
-
-	if (c->LookupType == 1) {		
-		uint32_t indexDivisor = 1;
-		for (i = 0; i < c->Dimensions; i++, v += step) {
-			offset = (lookupOffset / indexDivisor) % c->LookupValues;
-			value  = c->Multiplicands[offset] * c->DeltaValue + c->MinValue + last;
+	float* src;
+	uint32_t i;
 
-			*v += value;
-			if (c->SequenceP) last = value;
-			indexDivisor *= c->LookupValues;
-		}
-	} else if (c->LookupType == 2) {
-		offset = lookupOffset * c->Dimensions;
-		for (i = 0; i < c->Dimensions; i++, offset++, v += step) {
-			value  = c->Multiplicands[offset] * c->DeltaValue + c->MinValue + last;
+	if (!c->Vectors) Logger_Abort("Invalid huffman code");
+	src = c->Vectors + lookupOffset * c->Dimensions;
 
-			*v += value;
-			if (c->SequenceP) last = value;
-		}
+	if (step == 1) {
+		for (i = 0; i < c->Dimensions; i++) { v[i] += src[i]; }
 	} else {
-		Logger_Abort("Invalid huffman code");
+		for (i = 0; i < c->Dimensions; i++, v += step) { *v += src[i]; }
 	}
 }
 
@@ -418,6 +469,8 @@ struct Floor {
 	int16_t SubclassBooks[FLOOR_MAX_CLASSES][8];
 	int16_t  XList[FLOOR_MAX_VALUES];
 	uint16_t ListOrder[FLOOR_MAX_VALUES];
+	uint16_t LoNeighbor[FLOOR_MAX_VALUES];
+	uint16_t HiNeighbor[FLOOR_MAX_VALUES];
 	int32_t  YList[VORBIS_MAX_CHANS][FLOOR_MAX_VALUES];
 };
 
@@ -443,6 +496,22 @@ static void Floor_SortXList(int left, int right) {
 	}
 }
 
+static int low_neighbor(int16_t* v, int x) {
+	int n = 0, i, max = Int32_MinValue;
+	for (i = 0; i < x; i++) {
+		if (v[i] < v[x] && v[i] > max) { n = i; max = v[i]; }
+	}
+	return n;
+}
+
+static int high_neighbor(int16_t* v, int x) {
+	int n = 0, i, min = Int32_MaxValue;
+	for (i = 0; i < x; i++) {
+		if (v[i] > v[x] && v[i] < min) { n = i; min = v[i]; }
+	}
+	return n;
+}
+
 static ReturnCode Floor_DecodeSetup(struct VorbisState* ctx, struct Floor* f) {
 	static int16_t ranges[4] = { 256, 128, 84, 64 };
 	int i, j, idx, maxClass;
@@ -490,6 +559,12 @@ static ReturnCode Floor_DecodeSetup(struct VorbisState* ctx, struct Floor* f) {
 	tmp_xlist = xlist_sorted; 
 	tmp_order = f->ListOrder;
 	Floor_SortXList(0, idx - 1);
+
+	/* neighbours only depend on X list, so no need to search for them every frame */
+	for (i = 2; i < idx; i++) {
+		f->LoNeighbor[i] = low_neighbor(f->XList, i);
+		f->HiNeighbor[i] = high_neighbor(f->XList, i);
+	}
 	return 0;
 }
 
@@ -576,22 +651,6 @@ static void Floor_RenderLine(int x0, int y0, int x1, int y1, float* data) {
 	}
 }
 
-static int low_neighbor(int16_t* v, int x) {
-	int n = 0, i, max = Int32_MinValue;
-	for (i = 0; i < x; i++) {
-		if (v[i] < v[x] && v[i] > max) { n = i; max = v[i]; }
-	}
-	return n;
-}
-
-static int high_neighbor(int16_t* v, int x) {
-	int n = 0, i, min = Int32_MaxValue;
-	for (i = 0; i < x; i++) {
-		if (v[i] > v[x] && v[i] < min) { n = i; min = v[i]; }
-	}
-	return n;
-}
-
 static void Floor_Synthesis(struct VorbisState* ctx, struct Floor* f, int ch) {
 	/* amplitude arrays */
 	int32_t YFinal[FLOOR_MAX_VALUES];
@@ -617,8 +676,8 @@ static void Floor_Synthesis(struct VorbisState* ctx, struct Floor* f, int ch) {
 	YFinal[1] = yList[1];
 
 	for (i = 2; i < f->Values; i++) {
-		lo_offset = low_neighbor(f->XList, i);
-		hi_offset = high_neighbor(f->XList, i);
+		lo_offset = f->LoNeighbor[i];
+		hi_offset = f->HiNeighbor[i];
 		predicted = Floor_RenderPoint(f->XList[lo_offset], YFinal[lo_offset],
 									  f->XList[hi_offset], YFinal[hi_offset], f->XList[i]);
 
@@ -826,8 +885,8 @@ static void Residue_DecodeFrame(struct VorbisState* ctx, struct Residue* r, int
 		Residue_DecodeCore(ctx, r, size * ch, 1, &decodeAny, &interleaved);
 
 		/* deinterleave type 2 output */	
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < ch; j++) {
+		for (j = 0; j < ch; j++) {
+			for (i = 0; i < size; i++) {
 				data[j][i] = interleaved[i * ch + j];
 			}
 		}
@@ -959,8 +1018,10 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	/* Uses a few fixes for the paper noted at http://www.nothings.org/stb_vorbis/mdct_01.txt */
 	float *A = state->A, *B = state->B, *C = state->C;
 
-	float u[VORBIS_MAX_BLOCK_SIZE];
-	float w[VORBIS_MAX_BLOCK_SIZE];
+	float bufferA[VORBIS_MAX_BLOCK_SIZE];
+	float bufferB[VORBIS_MAX_BLOCK_SIZE];
+	float *u = bufferA, *w = bufferB, *tmp;
+	float *e, *f, *ue, *uf;
 	float e_1, e_2, f_1, f_2;
 	float g_1, g_2, h_1, h_2;
 	float x_1, x_2, y_1, y_2;
@@ -988,23 +1049,27 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 		int k0 = n >> (l+2), k1 = 1 << (l+3);
 		int r, r4, rMax = n >> (l+4), s2, s2Max = 1 << (l+2);
 
-		for (r = 0, r4 = 0; r < rMax; r++, r4 += 4) {
-			for (s2 = 0; s2 < s2Max; s2 += 2) {
-				e_1 = w[n-1-k0*s2-r4];     e_2 = w[n-3-k0*s2-r4];
-				f_1 = w[n-1-k0*(s2+1)-r4]; f_2 = w[n-3-k0*(s2+1)-r4];
+		/* butterflies are independent, so walk each pair of blocks sequentially */
+		for (s2 = 0; s2 < s2Max; s2 += 2) {
+			e  = &w[n-1-k0*s2]; f  = &w[n-1-k0*(s2+1)];
+			ue = &u[n-1-k0*s2]; uf = &u[n-1-k0*(s2+1)];
 
-				u[n-1-k0*s2-r4] = e_1 + f_1;
-				u[n-3-k0*s2-r4] = e_2 + f_2;
+			for (r = 0, r4 = 0; r < rMax; r++, r4 += 4) {
+				e_1 = e[-r4]; e_2 = e[-r4-2];
+				f_1 = f[-r4]; f_2 = f[-r4-2];
 
-				u[n-1-k0*(s2+1)-r4] = (e_1 - f_1) * A[r*k1] - (e_2 - f_2) * A[r*k1+1];
-				u[n-3-k0*(s2+1)-r4] = (e_2 - f_2) * A[r*k1] + (e_1 - f_1) * A[r*k1+1];
+				ue[-r4]   = e_1 + f_1;
+				ue[-r4-2] = e_2 + f_2;
+
+				uf[-r4]   = (e_1 - f_1) * A[r*k1] - (e_2 - f_2) * A[r*k1+1];
+				uf[-r4-2] = (e_2 - f_2) * A[r*k1] + (e_1 - f_1) * A[r*k1+1];
 			}
 		}
 
-		/* TODO: eliminate this, do w/u in-place */
+		/* each pass writes every element the next pass reads, so just swap buffers */
 		/* TODO: dynamically allocate mem for imdct */
 		if (l+1 <= log2_n - 4) {
-			Mem_Copy(w, u, sizeof(u));
+			tmp = w; w = u; u = tmp;
 		}
 	}
 
@@ -1213,6 +1278,7 @@ static ReturnCode Vorbis_DecodeSetup(struct VorbisState* ctx) {
 }
 
 ReturnCode Vorbis_DecodeHeaders(struct VorbisState* ctx) {
+	struct Stream* source;
 	uint32_t count;
 	ReturnCode res;
 	
@@ -1239,6 +1305,58 @@ ReturnCode Vorbis_DecodeHeaders(struct VorbisState* ctx) {
 
 	imdct_init(&ctx->imdct[0], ctx->BlockSizes[0]);
 	imdct_init(&ctx->imdct[1], ctx->BlockSizes[1]);
+
+	/* setup header always finishes a page, so audio data starts on a fresh page */
+	/* (if position isn't known, seeking is just not supported) */
+	source = ctx->Source->Meta.Ogg.Source;
+	if (ctx->Source->Meta.Ogg.Left || source->Position(source, &ctx->AudioStart)) {
+		ctx->AudioStart = 0;
+	}
+	return 0;
+}
+
+ReturnCode Vorbis_Seek(struct VorbisState* ctx, uint32_t sample, uint32_t* actual) {
+	struct Stream* source = ctx->Source->Meta.Ogg.Source;
+	struct OggPage page;
+	uint32_t pos;
+	uint32_t landPos, landSkip, landSample;
+	ReturnCode res;
+
+	if (!ctx->AudioStart) return ReturnCode_NotSupported;
+	pos = ctx->AudioStart;
+	if ((res = source->Seek(source, pos))) return res;
+
+	/* first audio page can always be resumed from */
+	landPos = pos; landSkip = 0; landSample = 0;
+
+	for (;;) {
+		res = Ogg_ReadHeader(source, &page);
+		if (res == ERR_END_OF_STREAM) break;
+		if (res) return res;
+
+		if (page.HasGranule && page.Granule > sample) break;
+
+		/* decoding can resume from the last packet that finishes in a page, since that packet */
+		/* produces no samples (like at start of stream), and ends at the page's granule. */
+		/* So the first sample decoded afterwards is always the sample at the page's granule. */
+		if (page.HasGranule && page.LastStart >= 0) {
+			landPos    = pos;
+			landSkip   = page.LastStart;
+			landSample = page.Granule;
+		}
+		pos += page.HeaderSize + page.Size;
+		if ((res = source->Skip(source, page.Size))) return res;
+	}
+
+	if ((res = source->Seek(source, landPos))) return res;
+	if ((res = Ogg_NextPage(ctx->Source)))     return res;
+	ctx->Source->Meta.Ogg.Cur  += landSkip;
+	ctx->Source->Meta.Ogg.Left -= landSkip;
+
+	/* like at start of stream, first frame decoded has no previous frame to overlap with */
+	ctx->Bits = 0; ctx->NumBits = 0;
+	ctx->PrevBlockSize = 0;
+	*actual = landSample;
 	return 0;
 }
 
@@ -1264,7 +1382,7 @@ ReturnCode Vorbis_DecodeFrame(struct VorbisState* ctx) {
 	/* inverse coupling */
 	int magChannel, angChannel;
 	float* magValues, m;
-	float* angValues, a;
+	float* angValues, a, t;
 
 	/* misc variables */
 	float* tmp;
@@ -1288,7 +1406,7 @@ ReturnCode Vorbis_DecodeFrame(struct VorbisState* ctx) {
 
 	/* swap prev and cur outputs around */
 	tmp = ctx->Values[1]; ctx->Values[1] = ctx->Values[0]; ctx->Values[0] = tmp;
-	Mem_Set(ctx->Values[0], 0, ctx->Channels * ctx->CurBlockSize);
+	Mem_Set(ctx->Values[0], 0, ctx->Channels * ctx->CurBlockSize * sizeof(float));
 
 	for (i = 0; i < ctx->Channels; i++) {
 		ctx->CurOutput[i]  = ctx->Values[0] + i * ctx->CurBlockSize;
@@ -1334,22 +1452,15 @@ ReturnCode Vorbis_DecodeFrame(struct VorbisState* ctx) {
 		magValues = ctx->CurOutput[mapping->Magnitude[i]];
 		angValues = ctx->CurOutput[mapping->Angle[i]];
 
+		/* written as selects instead of nested branches, so the compiler can vectorise it */
+		/* m > 0, a > 0: (m, m - a)   m > 0, a <= 0: (m + a, m) */
+		/* m <= 0, a > 0: (m, m + a)  m <= 0, a <= 0: (m - a, m) */
 		for (j = 0; j < ctx->DataSize; j++) {
 			m = magValues[j]; a = angValues[j];
+			t = m > 0.0f ? -a : a;
 
-			if (m > 0.0f) {
-				if (a > 0.0f) { angValues[j] = m - a; }
-				else {
-					angValues[j] = m;
-					magValues[j] = m + a;
-				}
-			} else {
-				if (a > 0.0f) { angValues[j] = m + a; }
-				else {
-					angValues[j] = m;
-					magValues[j] = m - a;
-				}
-			}
+			magValues[j] = a > 0.0f ? m : m - t;
+			angValues[j] = a > 0.0f ? m + t : m;
 		}
 	}
 
@@ -1380,15 +1491,25 @@ ReturnCode Vorbis_DecodeFrame(struct VorbisState* ctx) {
 	return 0;
 }
 
+/* Clamps samples to [-1, 1] and converts them to 16 bit, writing every 'stride'th output sample */
+static void Vorbis_ConvertSamples(int16_t* data, float* src, int count, int stride) {
+	float sample;
+	int i;
+
+	for (i = 0; i < count; i++, data += stride) {
+		sample = src[i];
+		Math_Clamp(sample, -1.0f, 1.0f);
+		*data = (int16_t)(sample * 32767);
+	}
+}
+
 int Vorbis_OutputFrame(struct VorbisState* ctx, int16_t* data) {
 	struct VorbisWindow window;
-	float* prev[VORBIS_MAX_CHANS];
-	float*  cur[VORBIS_MAX_CHANS];
+	float *prev, *cur;
 
 	int curQrtr, prevQrtr, overlapQtr;
 	int curOffset, prevOffset, overlapSize;
-	float sample;
-	int i, ch;
+	int i, ch, channels = ctx->Channels;
 
 	/* first frame decoded has no data */
 	if (ctx->PrevBlockSize == 0) {
@@ -1411,53 +1532,31 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, int16_t* data) {
 	          -  | * -        |           ***               | * -        |
 	   ******-***|*   -       |              ***            |*   -       |
 	*/	
-	curOffset  = curQrtr  - overlapQtr;
-	prevOffset = prevQrtr - overlapQtr;
-
-	for (i = 0; i < ctx->Channels; i++) {
-		prev[i] = ctx->PrevOutput[i] + (prevQrtr * 2);
-		cur[i]  = ctx->CurOutput[i];
-	}
-
-	/* for long prev and short cur block, there will be non-overlapped data before */
-	for (i = 0; i < prevOffset; i++) {
-		for (ch = 0; ch < ctx->Channels; ch++) {
-			sample = prev[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (int16_t)(sample * 32767);
-		}
-	}
-
-	/* adjust pointers to start at 0 for overlapping */
-	for (i = 0; i < ctx->Channels; i++) {
-		prev[i] += prevOffset; cur[i] += curOffset;
-	}
-
+	curOffset   = curQrtr  - overlapQtr;
+	prevOffset  = prevQrtr - overlapQtr;
 	overlapSize = overlapQtr * 2;
 	window = ctx->Windows[(overlapQtr * 4) == ctx->BlockSizes[1]];
 
-	/* overlap and add data */
-	/* also perform windowing here */
-	for (i = 0; i < overlapSize; i++) {
-		for (ch = 0; ch < ctx->Channels; ch++) {
-			sample = prev[ch][i] * window.Prev[i] + cur[ch][i] * window.Cur[i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (int16_t)(sample * 32767);
-		}
-	}
+	/* each channel is processed in contiguous runs, then interleaved while converting */
+	for (ch = 0; ch < channels; ch++) {
+		prev = ctx->PrevOutput[ch] + (prevQrtr * 2);
+		cur  = ctx->CurOutput[ch]  + curOffset;
 
-	/* for long cur and short prev block, there will be non-overlapped data after */
-	for (i = 0; i < ctx->Channels; i++) { cur[i] += overlapSize; }
-	for (i = 0; i < curOffset; i++) {
-		for (ch = 0; ch < ctx->Channels; ch++) {
-			sample = cur[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (int16_t)(sample * 32767);
+		/* overlap and add data, also performing windowing here */
+		/* previous block is not needed after this, so the result is stored in it */
+		for (i = 0; i < overlapSize; i++) {
+			prev[prevOffset + i] = prev[prevOffset + i] * window.Prev[i] + cur[i] * window.Cur[i];
 		}
+
+		/* for long prev and short cur block, there will be non-overlapped data before */
+		Vorbis_ConvertSamples(data + ch, prev, prevOffset + overlapSize, channels);
+		/* for long cur and short prev block, there will be non-overlapped data after */
+		Vorbis_ConvertSamples(data + ch + (prevOffset + overlapSize) * channels,
+							cur + overlapSize, curOffset, channels);
 	}
 
 	ctx->PrevBlockSize = ctx->CurBlockSize;
-	return (prevQrtr + curQrtr) * ctx->Channels;
+	return (prevQrtr + curQrtr) * channels;
 }
 
 static float floor1_inverse_dB_table[256] = {
@@ -30,6 +30,7 @@ struct VorbisState {
 	uint8_t Channels, ModeNumBits;
 	uint16_t CurBlockSize, PrevBlockSize, DataSize, NumCodebooks;
 	int SampleRate; int BlockSizes[2];
+	uint32_t AudioStart; /* position in ogg source of first audio page, 0 if unknown */
 	float* Temp; /* temp array reused in places */
 	float* Values[2]; /* swapped each frame */
 	float* PrevOutput[VORBIS_MAX_CHANS];
@@ -50,4 +51,8 @@ void Vorbis_Free(struct VorbisState* ctx);
 ReturnCode Vorbis_DecodeHeaders(struct VorbisState* ctx);
 ReturnCode Vorbis_DecodeFrame(struct VorbisState* ctx);
 int Vorbis_OutputFrame(struct VorbisState* ctx, int16_t* data);
+/* Seeks to the last packet boundary at or before the given sample (per channel), */
+/* so that decoding resumes from there. Actual sample resumed from is returned in 'actual'. */
+/* NOTE: Only supported when the ogg source stream supports seeking. */
+ReturnCode Vorbis_Seek(struct VorbisState* ctx, uint32_t sample, uint32_t* actual);
 #endif
@@ -8,6 +8,8 @@
 #include "ExtMath.h"
 #include "Physics.h"
 #include "Game.h"
+#include "GameStructs.h"
+#include "Funcs.h"
 
 BlockRaw* World_Blocks;
 #ifdef EXTENDED_BLOCKS
@@ -20,6 +22,18 @@ int World_MaxX, World_MaxY, World_MaxZ;
 int World_OneY;
 uint8_t World_Uuid[16];
 
+/* Bit for each block in the world, set when that block is solid. Each row along the X axis */
+/* starts on a new uint32_t, so that a row can be scanned 32 blocks at a time. */
+static uint32_t* world_solidBits;
+static int world_solidStride;  /* Number of uint32_t per row along the X axis */
+static bool world_solidStale;  /* Whether block definitions changed since bits were calculated */
+
+/* For each 16x16x16 section of the world, a bit for each of its 4x4x4 bricks, set when */
+/* that brick contains at least one non gas block. Used to skip empty space when ray tracing. */
+static uint64_t* world_occupied;
+static int world_occupiedX, world_occupiedZ; /* Number of sections along X and Z axes */
+static bool world_occupiedStale; /* Whether block definitions changed since bits were calculated */
+
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -49,6 +63,10 @@ void World_Reset(void) {
 	if (World_Blocks != World_Blocks2) Mem_Free(World_Blocks2);
 #endif
 	Mem_Free(World_Blocks);
+	Mem_Free(world_solidBits);
+	world_solidBits = NULL;
+	Mem_Free(world_occupied);
+	world_occupied  = NULL;
 	World_Width = 0; World_Height = 0; World_Length = 0;
 	World_MaxX = 0;  World_MaxY = 0;   World_MaxZ = 0;
 
@@ -63,6 +81,10 @@ void World_Reset(void) {
 void World_SetNewMap(BlockRaw* blocks, int blocksSize, int width, int height, int length) {
 	World_Width = width; World_Height = height; World_Length = length;
 	World_Blocks = blocks; World_BlocksSize = blocksSize;
+	Mem_Free(world_solidBits);
+	world_solidBits = NULL;
+	Mem_Free(world_occupied);
+	world_occupied  = NULL;
 	if (!World_BlocksSize) World_Blocks = NULL;
 
 	if (blocksSize != (width * height * length)) {
@@ -86,24 +108,156 @@ void World_SetNewMap(BlockRaw* blocks, int blocksSize, int width, int height, in
 }
 
 
+#define World_SolidWord(x, y, z) world_solidBits[((y) * World_Length + (z)) * world_solidStride + ((x) >> 5)]
+static void World_SetSolid(int x, int y, int z, BlockID block) {
+	uint32_t bit;
+	if (!world_solidBits || world_solidStale) return;
+	bit = 1u << (x & 31);
+
+	if (Blocks.Physics[block].Collide == COLLIDE_SOLID) {
+		World_SolidWord(x, y, z) |= bit;
+	} else {
+		World_SolidWord(x, y, z) &= ~bit;
+	}
+}
+
+#define World_OccupiedIndex(x, y, z) ((((y) >> 4) * world_occupiedZ + ((z) >> 4)) * world_occupiedX + ((x) >> 4))
+#define World_BrickBit(x, y, z) (1ull << ((((y) >> 2) & 3) << 4 | (((z) >> 2) & 3) << 2 | (((x) >> 2) & 3)))
+static void World_SetOccupied(int x, int y, int z, BlockID block) {
+	uint64_t* mask;
+	uint64_t bit;
+	int minX, minY, minZ, maxX, maxY, maxZ;
+
+	if (!world_occupied || world_occupiedStale) return;
+	mask = &world_occupied[World_OccupiedIndex(x, y, z)];
+	bit  = World_BrickBit(x, y, z);
+
+	if (Blocks.Draw[block] != DRAW_GAS) { *mask |= bit; return; }
+	if (!(*mask & bit)) return;
+
+	/* Removed a block, so have to check whether rest of the brick is empty too */
+	minX = x & ~3; maxX = min(minX + 3, World_MaxX);
+	minY = y & ~3; maxY = min(minY + 3, World_MaxY);
+	minZ = z & ~3; maxZ = min(minZ + 3, World_MaxZ);
+
+	for (y = minY; y <= maxY; y++) {
+		for (z = minZ; z <= maxZ; z++) {
+			for (x = minX; x <= maxX; x++) {
+				if (Blocks.Draw[World_GetBlock(x, y, z)] != DRAW_GAS) return;
+			}
+		}
+	}
+	*mask &= ~bit;
+}
+
 #ifdef EXTENDED_BLOCKS
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
 	World_Blocks[i] = (BlockRaw)block;
 
 	/* defer allocation of second map array if possible */
-	if (World_Blocks == World_Blocks2) {
-		if (block < 256) return;
+	if (World_Blocks != World_Blocks2) {
+		World_Blocks2[i] = (BlockRaw)(block >> 8);
+	} else if (block >= 256) {
 		World_Blocks2 = Mem_AllocCleared(World_BlocksSize, 1, "blocks array upper");
 		Block_SetUsedCount(768);
+		World_Blocks2[i] = (BlockRaw)(block >> 8);
 	}
-	World_Blocks2[i] = (BlockRaw)(block >> 8);
+
+	World_SetSolid(x, y, z, block);
+	World_SetOccupied(x, y, z, block);
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	World_Blocks[World_Pack(x, y, z)] = block; 
+	World_SetSolid(x, y, z, block);
+	World_SetOccupied(x, y, z, block);
+}
+#endif
+
+static void World_CalcSolidBits(void) {
+	uint32_t* bits;
+	int x, y, z, index = 0;
+	BlockID block;
+
+	if (!world_solidBits) {
+		world_solidStride = (World_Width + 31) >> 5;
+		world_solidBits   = Mem_Alloc(World_Height * World_Length * world_solidStride, 4, "solid bits");
+	}
+	world_solidStale = false;
+	Mem_Set(world_solidBits, 0, World_Height * World_Length * world_solidStride * 4);
+
+	for (y = 0; y < World_Height; y++) {
+		for (z = 0; z < World_Length; z++) {
+			bits = &World_SolidWord(0, y, z);
+
+			for (x = 0; x < World_Width; x++, index++) {
+#ifdef EXTENDED_BLOCKS
+				block = (BlockID)((World_Blocks[index] | (World_Blocks2[index] << 8)) & Block_IDMask);
+#else
+				block = World_Blocks[index];
+#endif
+				if (Blocks.Physics[block].Collide != COLLIDE_SOLID) continue;
+				bits[x >> 5] |= 1u << (x & 31);
+			}
+		}
+	}
+}
+
+int World_NextSolidX(int x, int maxX, int y, int z) {
+	uint32_t* row;
+	uint32_t bits;
+	int i;
+
+	if (!world_solidBits || world_solidStale) World_CalcSolidBits();
+	row  = &World_SolidWord(0, y, z);
+	i    = x >> 5;
+	bits = row[i] & (0xFFFFFFFFu << (x & 31));
+
+	/* Skip over words with no solid blocks at all */
+	while (!bits) {
+		i++;
+		if ((i << 5) > maxX) return maxX + 1;
+		bits = row[i];
+	}
+
+	for (x = i << 5; !(bits & 1); x++) { bits >>= 1; }
+	return x <= maxX ? x : maxX + 1;
 }
+
+static void World_CalcOccupied(void) {
+	uint64_t* mask;
+	int x, y, z, index = 0;
+	BlockID block;
+
+	if (!world_occupied) {
+		world_occupiedX = (World_Width  + 15) >> 4;
+		world_occupiedZ = (World_Length + 15) >> 4;
+		world_occupied  = Mem_Alloc(world_occupiedX * world_occupiedZ * ((World_Height + 15) >> 4), 8, "occupied bricks");
+	}
+	world_occupiedStale = false;
+	Mem_Set(world_occupied, 0, world_occupiedX * world_occupiedZ * ((World_Height + 15) >> 4) * 8);
+
+	for (y = 0; y < World_Height; y++) {
+		for (z = 0; z < World_Length; z++) {
+			for (x = 0; x < World_Width; x++, index++) {
+#ifdef EXTENDED_BLOCKS
+				block = (BlockID)((World_Blocks[index] | (World_Blocks2[index] << 8)) & Block_IDMask);
+#else
+				block = World_Blocks[index];
 #endif
+				if (Blocks.Draw[block] == DRAW_GAS) continue;
+				mask   = &world_occupied[World_OccupiedIndex(x, y, z)];
+				*mask |= World_BrickBit(x, y, z);
+			}
+		}
+	}
+}
+
+uint64_t World_GetOccupied(int x, int y, int z) {
+	if (!world_occupied || world_occupiedStale) World_CalcOccupied();
+	return world_occupied[World_OccupiedIndex(x, y, z)];
+}
 
 BlockID World_GetPhysicsBlock(int x, int y, int z) {
 	if (x < 0 || x >= World_Width || z < 0 || z >= World_Length || y < 0) return BLOCK_BEDROCK;
@@ -300,3 +454,25 @@ Vector3 Respawn_FindSpawnPosition(float x, float z, Vector3 modelSize) {
 	}
 	return spawn;
 }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------World component---------------------------------------------------*
+*#########################################################################################################################*/
+static void World_BlockDefChanged(void* obj) {
+	world_solidStale    = true;
+	world_occupiedStale = true;
+}
+
+static void World_Init(void) {
+	Event_RegisterVoid(&BlockEvents.BlockDefChanged, NULL, World_BlockDefChanged);
+}
+
+static void World_Free(void) {
+	Event_UnregisterVoid(&BlockEvents.BlockDefChanged, NULL, World_BlockDefChanged);
+}
+
+struct IGameComponent World_Component = {
+	World_Init, /* Init */
+	World_Free  /* Free */
+};
@@ -7,6 +7,7 @@
    Copyright 2014-2017 ClassicalSharp | Licensed under BSD-3
 */
 struct AABB;
+struct IGameComponent;
 
 #define World_Unpack(idx, x, y, z) x = idx % World_Width; z = (idx / World_Width) % World_Length; y = (idx / World_Width) / World_Length;
 #define World_Pack(x, y, z) (((y) * World_Length + (z)) * World_Width + (x))
@@ -41,7 +42,16 @@ static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
 #endif
 
 BlockID World_GetPhysicsBlock(int x, int y, int z);
+/* Sets the block at the given coordinates, also updating the solid bitset (world_solidBits). */
 void World_SetBlock(int x, int y, int z, BlockID block);
+/* Returns the first X coordinate from x to maxX (inclusive) in the given row of the world */
+/*  where the block is solid, or maxX + 1 if there are no solid blocks in that range. */
+/* NOTE: Uses a bitset of solid blocks, so runs of non solid blocks are skipped 32 at a time. */
+int World_NextSolidX(int x, int maxX, int y, int z);
+/* Returns which 4x4x4 bricks of the 16x16x16 section containing the given coords have at least */
+/*  one non gas block. The brick containing (x, y, z) is bit ((y>>2)&3)<<4 | ((z>>2)&3)<<2 | ((x>>2)&3) */
+/* NOTE: Coordinates must be inside the world. */
+uint64_t World_GetOccupied(int x, int y, int z);
 BlockID World_SafeGetBlock_3I(Vector3I p);
 bool World_IsValidPos(int x, int y, int z);
 bool World_IsValidPos_3I(Vector3I p);
@@ -136,4 +146,5 @@ float Respawn_HighestSolidY(struct AABB* bb);
 /* Finds a suitable initial spawn position for the entity. */
 /* Works by iterating downwards from top of world until solid ground is found. */
 Vector3 Respawn_FindSpawnPosition(float x, float z, Vector3 modelSize);
+extern struct IGameComponent World_Component;
 #endif